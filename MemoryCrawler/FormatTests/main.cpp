@@ -0,0 +1,608 @@
+//
+//  main.cpp
+//  FormatTests
+//
+//  Created by larryhou on 2020/3/2.
+//  Copyright © 2020 larryhou. All rights reserved.
+//
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "diff.h"
+#include "cache.h"
+#include "crawler.h"
+
+static int32_t __failures = 0;
+
+#define expect(condition) check(condition, #condition, __FILE__, __LINE__)
+
+static void check(bool condition, const char *expression, const char *file, int line)
+{
+    if (condition) {return;}
+    printf("\e[31m%s:%d %s\e[0m\n", file, line, expression);
+    ++__failures;
+}
+
+static int __stdout = -1;
+
+// cache reading prints summaries and fallback messages, keep them out of test output
+static void mute()
+{
+    fflush(stdout);
+    __stdout = dup(STDOUT_FILENO);
+    auto null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    close(null);
+}
+
+static void unmute()
+{
+    fflush(stdout);
+    dup2(__stdout, STDOUT_FILENO);
+    close(__stdout);
+}
+
+static std::string readFile(const char *filepath)
+{
+    std::ifstream fs(filepath, std::ios_base::in | std::ios_base::binary);
+    return std::string((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const char *filepath, const std::string &bytes)
+{
+    std::ofstream fs(filepath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    fs.write(bytes.data(), bytes.size());
+}
+
+static bool sameTable(const BaselineTable &a, const BaselineTable &b)
+{
+    if (a.types.size() != b.types.size() || a.objects.size() != b.objects.size()) {return false;}
+    for (auto i = 0; i < a.types.size(); i++)
+    {
+        if (a.types[i].name != b.types[i].name || a.types[i].typeInfoAddress != b.types[i].typeInfoAddress) {return false;}
+    }
+    for (auto i = 0; i < a.objects.size(); i++)
+    {
+        auto &x = a.objects[i];
+        auto &y = b.objects[i];
+        if (x.address != y.address || x.typeIndex != y.typeIndex || x.size != y.size) {return false;}
+    }
+    return true;
+}
+
+static bool emptyBaseline(const SnapshotBaseline &baseline)
+{
+    return baseline.uuid.empty()
+        && baseline.managed.types.empty() && baseline.managed.objects.empty()
+        && baseline.native.types.empty() && baseline.native.objects.empty()
+        && baseline.sections.empty();
+}
+
+static SnapshotBaseline createBaseline()
+{
+    SnapshotBaseline baseline;
+    baseline.uuid = "8d1e4b5c-0f2a-4c3e-9b7d-6a5f4e3d2c1b";
+    baseline.managed.types = {{"System.String", 0x1000}, {"System.Object[]", 0x1040}, {"UnityEngine.GameObject", 0x1080}};
+    baseline.native.types = {{"Texture2D", 0}, {"GameObject", 0}};
+    for (auto i = 0; i < 64; i++)
+    {
+        baseline.managed.objects.push_back(BaselineObject{0x20000 + (address_t)i * 0x40, i % 3, 0x20 + i});
+        baseline.native.objects.push_back(BaselineObject{0x80000 + (address_t)i * 0x100, i % 2, 0x100 + i});
+    }
+    baseline.sections.push_back(MemoryFragment(0x20000, 0x10000, 0));
+    baseline.sections.push_back(MemoryFragment(0x40000, 0x8000, 1));
+    return baseline;
+}
+
+static void testBaselineRoundTrip()
+{
+    auto baseline = createBaseline();
+    expect(baseline.save("round.mcbl"));
+
+    SnapshotBaseline loaded;
+    expect(loaded.load("round.mcbl"));
+    expect(loaded.uuid == baseline.uuid);
+    expect(sameTable(loaded.managed, baseline.managed));
+    expect(sameTable(loaded.native, baseline.native));
+    expect(loaded.managed.indice.size() == baseline.managed.objects.size());
+    expect(loaded.sections.size() == baseline.sections.size());
+    for (auto i = 0; i < baseline.sections.size() && i < loaded.sections.size(); i++)
+    {
+        expect(loaded.sections[i].address == baseline.sections[i].address);
+        expect(loaded.sections[i].size == baseline.sections[i].size);
+    }
+
+    expect(!baseline.save("missing/round.mcbl"));
+}
+
+static void testBaselineTruncated()
+{
+    auto baseline = createBaseline();
+    expect(baseline.save("truncated.mcbl"));
+    auto bytes = readFile("truncated.mcbl");
+
+    // every prefix of a valid file must be rejected and leave nothing behind
+    auto rejects = 0;
+    for (auto length = 0; length < bytes.size(); length++)
+    {
+        writeFile("truncated.mcbl", bytes.substr(0, length));
+        SnapshotBaseline loaded = createBaseline();
+        if (!loaded.load("truncated.mcbl") && emptyBaseline(loaded)) {++rejects;}
+    }
+    expect(rejects == bytes.size());
+
+    writeFile("truncated.mcbl", bytes);
+    SnapshotBaseline loaded;
+    expect(loaded.load("truncated.mcbl"));
+}
+
+static void testBaselineDamaged()
+{
+    SnapshotBaseline loaded;
+
+    auto baseline = createBaseline();
+    std::swap(baseline.managed.objects[10], baseline.managed.objects[11]);
+    expect(baseline.save("unsorted.mcbl"));
+    expect(!loaded.load("unsorted.mcbl"));
+    expect(emptyBaseline(loaded));
+
+    baseline = createBaseline();
+    baseline.native.objects[5].typeIndex = (int32_t)baseline.native.types.size();
+    expect(baseline.save("type.mcbl"));
+    expect(!loaded.load("type.mcbl"));
+    expect(emptyBaseline(loaded));
+
+    baseline = createBaseline();
+    baseline.managed.objects[0].typeIndex = -1;
+    expect(baseline.save("type.mcbl"));
+    expect(!loaded.load("type.mcbl"));
+
+    baseline = createBaseline();
+    std::swap(baseline.sections[0], baseline.sections[1]);
+    expect(baseline.save("sections.mcbl"));
+    expect(!loaded.load("sections.mcbl"));
+
+    baseline = createBaseline();
+    expect(baseline.save("magic.mcbl"));
+    auto bytes = readFile("magic.mcbl");
+    bytes[0] ^= 0xFF;
+    writeFile("magic.mcbl", bytes);
+    expect(!loaded.load("magic.mcbl"));
+
+    // huge counts must fail before allocating
+    bytes = readFile("type.mcbl");
+    auto offset = 4 + 4 + 4 + baseline.uuid.size();
+    bytes[offset + 3] = 0x7F;
+    writeFile("count.mcbl", bytes);
+    expect(!loaded.load("count.mcbl"));
+
+    expect(!loaded.load("nonexistent.mcbl"));
+    expect(emptyBaseline(loaded));
+}
+
+static const char *CACHE_UUID = "3f6c2a1e-7b4d-4e8a-a5c9-0d1e2f3a4b5c";
+
+template <typename T>
+static Array<T> *createArray(PackedMemorySnapshot &snapshot, int32_t size)
+{
+    return Array<T>::create(snapshot.arena, size);
+}
+
+static PooledString createName(PackedMemorySnapshot &snapshot, const std::string &text)
+{
+    return snapshot.strings.intern(text);
+}
+
+static void createCrawler(MemorySnapshotCrawler &crawler)
+{
+    auto &snapshot = *crawler.snapshot;
+    snapshot.uuid = CACHE_UUID;
+    auto &vm = snapshot.virtualMachineInformation;
+    vm.allocationGranularity = 16;
+    vm.arrayBoundsOffsetInHeader = 16;
+    vm.arrayHeaderSize = 32;
+    vm.arraySizeOffsetInHeader = 24;
+    vm.heapFormatVersion = 2018;
+    vm.objectHeaderSize = 16;
+    vm.pointerSize = 8;
+    snapshot.managedTypeIndex.system_Int32 = 0;
+    snapshot.nativeTypeIndex.Object = 0;
+    
+    snapshot.nativeTypes = createArray<PackedNativeType>(snapshot, 2);
+    const char *nativeTypeNames[] = {"Object", "GameObject"};
+    for (auto i = 0; i < 2; i++)
+    {
+        auto &nt = snapshot.nativeTypes->items[i];
+        nt.name = createName(snapshot, nativeTypeNames[i]);
+        nt.nativeBaseTypeArrayIndex = i - 1;
+        nt.baseClassId = 100 + i;
+        nt.typeIndex = i;
+        nt.managedTypeArrayIndex = i == 1 ? 2 : -1;
+        nt.instanceCount = 1 + i;
+        nt.instanceMemory = 0x100 * (1 + i);
+    }
+    
+    snapshot.nativeObjects = createArray<PackedNativeUnityEngineObject>(snapshot, 3);
+    for (auto i = 0; i < 3; i++)
+    {
+        auto &no = snapshot.nativeObjects->items[i];
+        no.name = createName(snapshot, "Player" + std::to_string(i));
+        no.nativeObjectAddress = 0x7f0000 + i * 0x100;
+        no.flags = i;
+        no.hideFlags = i * 2;
+        no.instanceId = 1000 + i;
+        no.nativeTypeArrayIndex = i == 0 ? 1 : 0;
+        no.size = 0x100;
+        no.classId = 1;
+        no.managedObjectArrayIndex = i == 0 ? 2 : -1;
+        no.nativeObjectArrayIndex = i;
+        no.isDontDestroyOnLoad = i == 1;
+        no.isManager = false;
+        no.isPersistent = i == 2;
+    }
+    
+    snapshot.connections = createArray<Connection>(snapshot, 2);
+    for (auto i = 0; i < 2; i++)
+    {
+        auto &nc = snapshot.connections->items[i];
+        nc.connectionArrayIndex = i;
+        nc.from = i;
+        nc.to = i + 1;
+        nc.fromKind = CK_native;
+        nc.toKind = CK_native;
+        crawler.tryAcceptConnection(nc);
+    }
+    
+    snapshot.typeDescriptions = createArray<TypeDescription>(snapshot, 3);
+    const char *typeNames[] = {"System.Int32", "Game.Node", "UnityEngine.GameObject"};
+    for (auto i = 0; i < 3; i++)
+    {
+        auto &type = snapshot.typeDescriptions->items[i];
+        type.name = createName(snapshot, typeNames[i]);
+        type.assembly = createName(snapshot, i == 2 ? "UnityEngine.dll" : "mscorlib.dll");
+        type.typeInfoAddress = 0x500000 + i * 0x40;
+        type.arrayRank = 0;
+        type.baseOrElementTypeIndex = -1;
+        type.size = i == 0 ? 4 : 32;
+        type.typeIndex = i;
+        type.instanceCount = i;
+        type.instanceMemory = i * 32;
+        type.nativeTypeArrayIndex = i == 2 ? 1 : -1;
+        type.isArray = false;
+        type.isValueType = i == 0;
+        type.isUnityEngineObjectType = i == 2;
+    }
+    
+    auto &node = snapshot.typeDescriptions->items[1];
+    node.fields = createArray<FieldDescription>(snapshot, 3);
+    const char *fieldNames[] = {"next", "value", "count"};
+    for (auto i = 0; i < 3; i++)
+    {
+        auto &field = node.fields->items[i];
+        field.name = createName(snapshot, fieldNames[i]);
+        field.isStatic = i == 2;
+        field.fieldSlotIndex = i;
+        field.offset = 16 + i * 8;
+        field.typeIndex = i == 0 ? 1 : 0;
+        field.hookTypeIndex = 1;
+    }
+    node.staticFieldBytes = createArray<byte_t>(snapshot, 8);
+    for (auto i = 0; i < 8; i++) { node.staticFieldBytes->items[i] = (byte_t)(0xA0 + i); }
+    
+    const address_t addresses[] = {0x200000, 0x200040, 0x200080};
+    const int32_t typeIndice[] = {1, 1, 2};
+    for (auto i = 0; i < 3; i++)
+    {
+        auto &mo = crawler.managedObjects.add();
+        mo.address = addresses[i];
+        mo.typeIndex = typeIndice[i];
+        mo.managedObjectIndex = i;
+        mo.nativeObjectIndex = i == 2 ? 0 : -1;
+        mo.size = 32;
+        mo.nativeSize = i == 2 ? 0x100 : 0;
+    }
+    
+    // gc handle holds first node, first node holds second one through its next field
+    auto &handle = crawler.joints.add();
+    handle.gcHandleIndex = 0;
+    handle.jointArrayIndex = 0;
+    handle.isConnected = true;
+    auto &next = crawler.joints.add();
+    next.hookObjectAddress = addresses[0];
+    next.hookObjectIndex = 0;
+    next.hookTypeIndex = 1;
+    next.fieldTypeIndex = 1;
+    next.fieldSlotIndex = 0;
+    next.fieldOffset = 16;
+    next.fieldAddress = addresses[0] + 16;
+    next.jointArrayIndex = 1;
+    next.isConnected = true;
+    
+    const int32_t from[] = {0, 0, 2};
+    const int32_t to[] = {0, 1, 0};
+    const ConnectionKind fromKind[] = {CK_gcHandle, CK_managed, CK_managed};
+    const ConnectionKind toKind[] = {CK_managed, CK_managed, CK_native};
+    const int32_t joint[] = {0, 1, -1};
+    for (auto i = 0; i < 3; i++)
+    {
+        auto &ec = crawler.connections.add();
+        ec.connectionArrayIndex = i;
+        ec.from = from[i];
+        ec.to = to[i];
+        ec.fromKind = fromKind[i];
+        ec.toKind = toKind[i];
+        ec.jointArrayIndex = joint[i];
+        crawler.tryAcceptConnection(ec);
+    }
+    crawler.buildManagedGraph();
+}
+
+static bool sameCrawler(MemorySnapshotCrawler &a, MemorySnapshotCrawler &b)
+{
+    auto &x = *a.snapshot;
+    auto &y = *b.snapshot;
+    if (memcmp(&x.virtualMachineInformation, &y.virtualMachineInformation, sizeof(VirtualMachineInformation)) != 0) {return false;}
+    if (memcmp(&x.managedTypeIndex, &y.managedTypeIndex, sizeof(ManagedTypeIndex)) != 0) {return false;}
+    if (memcmp(&x.nativeTypeIndex, &y.nativeTypeIndex, sizeof(NativeTypeIndex)) != 0) {return false;}
+    
+    if (x.nativeTypes->size != y.nativeTypes->size) {return false;}
+    for (auto i = 0; i < x.nativeTypes->size; i++)
+    {
+        auto &m = x.nativeTypes->items[i];
+        auto &n = y.nativeTypes->items[i];
+        if (m.name != n.name || m.nativeBaseTypeArrayIndex != n.nativeBaseTypeArrayIndex || m.baseClassId != n.baseClassId
+            || m.typeIndex != n.typeIndex || m.managedTypeArrayIndex != n.managedTypeArrayIndex
+            || m.instanceCount != n.instanceCount || m.instanceMemory != n.instanceMemory) {return false;}
+    }
+    
+    if (x.nativeObjects->size != y.nativeObjects->size) {return false;}
+    for (auto i = 0; i < x.nativeObjects->size; i++)
+    {
+        auto &m = x.nativeObjects->items[i];
+        auto &n = y.nativeObjects->items[i];
+        if (m.name != n.name || m.nativeObjectAddress != n.nativeObjectAddress || m.flags != n.flags || m.hideFlags != n.hideFlags
+            || m.instanceId != n.instanceId || m.nativeTypeArrayIndex != n.nativeTypeArrayIndex || m.size != n.size || m.classId != n.classId
+            || m.managedObjectArrayIndex != n.managedObjectArrayIndex || m.nativeObjectArrayIndex != n.nativeObjectArrayIndex
+            || m.isDontDestroyOnLoad != n.isDontDestroyOnLoad || m.isManager != n.isManager || m.isPersistent != n.isPersistent
+            || m.fromConnections != n.fromConnections || m.toConnections != n.toConnections) {return false;}
+    }
+    
+    if (x.connections->size != y.connections->size) {return false;}
+    for (auto i = 0; i < x.connections->size; i++)
+    {
+        auto &m = x.connections->items[i];
+        auto &n = y.connections->items[i];
+        if (m.from != n.from || m.to != n.to || m.fromKind != n.fromKind || m.toKind != n.toKind) {return false;}
+    }
+    
+    if (x.typeDescriptions->size != y.typeDescriptions->size) {return false;}
+    for (auto i = 0; i < x.typeDescriptions->size; i++)
+    {
+        auto &m = x.typeDescriptions->items[i];
+        auto &n = y.typeDescriptions->items[i];
+        if (m.name != n.name || m.assembly != n.assembly || m.typeInfoAddress != n.typeInfoAddress || m.arrayRank != n.arrayRank
+            || m.baseOrElementTypeIndex != n.baseOrElementTypeIndex || m.size != n.size || m.typeIndex != n.typeIndex
+            || m.instanceCount != n.instanceCount || m.instanceMemory != n.instanceMemory || m.nativeMemory != n.nativeMemory
+            || m.nativeTypeArrayIndex != n.nativeTypeArrayIndex || m.isArray != n.isArray || m.isValueType != n.isValueType
+            || m.isUnityEngineObjectType != n.isUnityEngineObjectType) {return false;}
+        
+        if ((m.staticFieldBytes == nullptr) != (n.staticFieldBytes == nullptr)) {return false;}
+        if (m.staticFieldBytes != nullptr && (m.staticFieldBytes->size != n.staticFieldBytes->size
+            || memcmp(m.staticFieldBytes->items, n.staticFieldBytes->items, m.staticFieldBytes->size) != 0)) {return false;}
+        
+        if ((m.fields == nullptr) != (n.fields == nullptr)) {return false;}
+        if (m.fields == nullptr) {continue;}
+        if (m.fields->size != n.fields->size) {return false;}
+        for (auto k = 0; k < m.fields->size; k++)
+        {
+            auto &f = m.fields->items[k];
+            auto &g = n.fields->items[k];
+            if (f.name != g.name || f.isStatic != g.isStatic || f.fieldSlotIndex != g.fieldSlotIndex || f.offset != g.offset
+                || f.typeIndex != g.typeIndex || f.hookTypeIndex != g.hookTypeIndex) {return false;}
+        }
+    }
+    
+    if (a.managedObjects.size() != b.managedObjects.size()) {return false;}
+    for (auto i = 0; i < a.managedObjects.size(); i++)
+    {
+        auto &m = a.managedObjects[i];
+        auto &n = b.managedObjects[i];
+        if (m.address != n.address || m.typeIndex != n.typeIndex || m.managedObjectIndex != n.managedObjectIndex
+            || m.nativeObjectIndex != n.nativeObjectIndex || m.size != n.size || m.nativeSize != n.nativeSize
+            || m.isValueType != n.isValueType) {return false;}
+        
+        auto p = a.managedGraph.fromConnections(i);
+        auto q = b.managedGraph.fromConnections(i);
+        if (!std::equal(p.begin(), p.end(), q.begin(), q.end())) {return false;}
+        p = a.managedGraph.toConnections(i);
+        q = b.managedGraph.toConnections(i);
+        if (!std::equal(p.begin(), p.end(), q.begin(), q.end())) {return false;}
+    }
+    
+    if (a.joints.size() != b.joints.size()) {return false;}
+    for (auto i = 0; i < a.joints.size(); i++)
+    {
+        auto &m = a.joints[i];
+        auto &n = b.joints[i];
+        if (m.gcHandleIndex != n.gcHandleIndex || m.hookTypeIndex != n.hookTypeIndex || m.hookObjectAddress != n.hookObjectAddress
+            || m.hookObjectIndex != n.hookObjectIndex || m.linkArrayIndex != n.linkArrayIndex || m.fieldTypeIndex != n.fieldTypeIndex
+            || m.fieldSlotIndex != n.fieldSlotIndex || m.fieldOffset != n.fieldOffset || m.fieldAddress != n.fieldAddress
+            || m.managedArrayIndex != n.managedArrayIndex || m.elementArrayIndex != n.elementArrayIndex
+            || m.jointArrayIndex != n.jointArrayIndex || m.isStatic != n.isStatic || m.isConnected != n.isConnected) {return false;}
+    }
+    
+    if (a.connections.size() != b.connections.size()) {return false;}
+    for (auto i = 0; i < a.connections.size(); i++)
+    {
+        auto &m = a.connections[i];
+        auto &n = b.connections[i];
+        if (m.connectionArrayIndex != n.connectionArrayIndex || m.from != n.from || m.to != n.to
+            || m.fromKind != n.fromKind || m.toKind != n.toKind || m.jointArrayIndex != n.jointArrayIndex) {return false;}
+    }
+    return true;
+}
+
+// damaged cache must leave no crawling result behind
+static bool emptyCrawler(MemorySnapshotCrawler &crawler)
+{
+    auto nativeObjects = crawler.snapshot->nativeObjects;
+    for (auto i = 0; nativeObjects != nullptr && i < nativeObjects->size; i++)
+    {
+        auto &no = nativeObjects->items[i];
+        if (no.fromConnections.size() != 0 || no.toConnections.size() != 0) {return false;}
+    }
+    return crawler.managedObjects.size() == 0 && crawler.joints.size() == 0 && crawler.connections.size() == 0
+        && crawler.snapshot->connections == nullptr;
+}
+
+static std::string cachePath()
+{
+    return std::string("__cpp_cache/") + CACHE_UUID + ".mcc";
+}
+
+static void saveCache(void (*corrupt)(MemorySnapshotCrawler &crawler))
+{
+    PackedMemorySnapshot snapshot;
+    MemorySnapshotCrawler crawler(&snapshot);
+    createCrawler(crawler);
+    if (corrupt != nullptr) { corrupt(crawler); }
+    mute();
+    SnapshotCrawlerCache().save(crawler);
+    unmute();
+}
+
+// false if cache was rejected
+static bool readCache(bool expectEmpty = true)
+{
+    PackedMemorySnapshot snapshot;
+    MemorySnapshotCrawler crawler(&snapshot);
+    mute();
+    SnapshotCrawlerCache().read(CACHE_UUID, &crawler);
+    unmute();
+    auto accepted = snapshot.uuid == CACHE_UUID;
+    if (!accepted && expectEmpty) { expect(emptyCrawler(crawler)); }
+    return accepted;
+}
+
+static void testCacheRoundTrip()
+{
+    saveCache(nullptr);
+    
+    PackedMemorySnapshot source;
+    MemorySnapshotCrawler crawler(&source);
+    createCrawler(crawler);
+    
+    PackedMemorySnapshot snapshot;
+    MemorySnapshotCrawler cached(&snapshot);
+    mute();
+    SnapshotCrawlerCache().read(CACHE_UUID, &cached);
+    unmute();
+    expect(snapshot.uuid == CACHE_UUID);
+    expect(sameCrawler(crawler, cached));
+}
+
+static void testCacheTruncated()
+{
+    saveCache(nullptr);
+    auto bytes = readFile(cachePath().c_str());
+    
+    auto rejects = 0;
+    for (auto length = 0; length < bytes.size(); length++)
+    {
+        writeFile(cachePath().c_str(), bytes.substr(0, length));
+        if (!readCache()) {++rejects;}
+    }
+    expect(rejects == bytes.size());
+    
+    writeFile(cachePath().c_str(), bytes);
+    expect(readCache());
+}
+
+static void testCacheDamaged()
+{
+    typedef void (*Corrupt)(MemorySnapshotCrawler &crawler);
+    Corrupt corrupts[] =
+    {
+        [](MemorySnapshotCrawler &c) { c.snapshot->nativeTypes->items[1].nativeBaseTypeArrayIndex = 2; },
+        [](MemorySnapshotCrawler &c) { c.snapshot->nativeTypes->items[1].managedTypeArrayIndex = 3; },
+        [](MemorySnapshotCrawler &c) { c.snapshot->nativeObjects->items[0].nativeTypeArrayIndex = 2; },
+        [](MemorySnapshotCrawler &c) { c.snapshot->nativeObjects->items[1].nativeObjectArrayIndex = -2; },
+        [](MemorySnapshotCrawler &c) { c.snapshot->nativeObjects->items[0].managedObjectArrayIndex = 3; },
+        [](MemorySnapshotCrawler &c) { c.snapshot->connections->items[1].to = 3; },
+        [](MemorySnapshotCrawler &c) { c.snapshot->connections->items[0].fromKind = (ConnectionKind)(CK_link + 1); },
+        [](MemorySnapshotCrawler &c) { c.snapshot->typeDescriptions->items[0].baseOrElementTypeIndex = 3; },
+        [](MemorySnapshotCrawler &c) { c.snapshot->typeDescriptions->items[2].typeIndex = -1; },
+        [](MemorySnapshotCrawler &c) { c.snapshot->typeDescriptions->items[2].nativeTypeArrayIndex = 2; },
+        [](MemorySnapshotCrawler &c) { c.snapshot->typeDescriptions->items[1].fields->items[0].typeIndex = 3; },
+        [](MemorySnapshotCrawler &c) { c.snapshot->typeDescriptions->items[1].fields->items[1].hookTypeIndex = -2; },
+        [](MemorySnapshotCrawler &c) { c.snapshot->typeDescriptions->items[1].fields->items[2].fieldSlotIndex = 3; },
+        [](MemorySnapshotCrawler &c) { c.managedObjects[1].typeIndex = 3; },
+        [](MemorySnapshotCrawler &c) { c.managedObjects[1].managedObjectIndex = 3; },
+        [](MemorySnapshotCrawler &c) { c.managedObjects[2].nativeObjectIndex = 3; },
+        [](MemorySnapshotCrawler &c) { c.joints[1].hookTypeIndex = 3; },
+        [](MemorySnapshotCrawler &c) { c.joints[1].hookObjectIndex = 3; },
+        [](MemorySnapshotCrawler &c) { c.joints[1].fieldSlotIndex = 3; },
+        [](MemorySnapshotCrawler &c) { c.joints[0].fieldSlotIndex = 0; }, // no hook type
+        [](MemorySnapshotCrawler &c) { c.joints[0].jointArrayIndex = 2; },
+        [](MemorySnapshotCrawler &c) { c.connections[1].to = 3; },
+        [](MemorySnapshotCrawler &c) { c.connections[2].to = 3; },
+        [](MemorySnapshotCrawler &c) { c.connections[2].jointArrayIndex = 2; },
+        [](MemorySnapshotCrawler &c) { c.connections[0].connectionArrayIndex = 3; },
+    };
+    
+    auto count = (int32_t)(sizeof(corrupts) / sizeof(Corrupt));
+    for (auto i = 0; i < count; i++)
+    {
+        saveCache(corrupts[i]);
+        if (readCache())
+        {
+            printf("\e[31mdamaged cache #%d accepted\e[0m\n", i);
+            ++__failures;
+        }
+    }
+    
+    saveCache(nullptr);
+    auto bytes = readFile(cachePath().c_str());
+    bytes[0] ^= 0xFF;
+    writeFile(cachePath().c_str(), bytes);
+    expect(!readCache());
+    
+    // flipped bytes may still form a valid cache, but reading must never crash
+    saveCache(nullptr);
+    bytes = readFile(cachePath().c_str());
+    for (auto i = 0; i < bytes.size(); i++)
+    {
+        auto damaged = bytes;
+        damaged[i] ^= 0x5A;
+        writeFile(cachePath().c_str(), damaged);
+        readCache();
+    }
+}
+
+int main(int argc, const char * argv[])
+{
+    char workspace[] = "/tmp/FormatTests.XXXXXX";
+    if (mkdtemp(workspace) == nullptr || chdir(workspace) != 0)
+    {
+        printf("\e[31mfailed to create workspace\e[0m\n");
+        return 1;
+    }
+
+    testBaselineRoundTrip();
+    testBaselineTruncated();
+    testBaselineDamaged();
+    testCacheRoundTrip();
+    testCacheTruncated();
+    testCacheDamaged();
+
+    if (__failures == 0) {printf("\e[32mall tests passed\e[0m\n");}
+    else {printf("\e[31m%d checks failed\e[0m\n", __failures);}
+    return __failures == 0 ? 0 : 1;
+}
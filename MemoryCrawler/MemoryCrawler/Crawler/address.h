@@ -0,0 +1,250 @@
+//
+//  address.h
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/14.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#ifndef address_h
+#define address_h
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include "types.h"
+
+inline uint64_t hashAddress(address_t address)
+{
+    return (address >> 3) * 0x9E3779B97F4A7C15ull;
+}
+
+// Open addressing hash keyed by address with linear probing, insert only.
+template <class T>
+class AddressHashMap
+{
+    struct Slot
+    {
+        address_t address;
+        T value;
+    };
+
+    std::vector<Slot> __slots;
+    size_t __size;
+    int32_t __shift;
+
+    bool __zeroUsed;
+    T __zeroValue;
+
+public:
+    AddressHashMap(): __size(0), __shift(64), __zeroUsed(false) {}
+
+    T *find(address_t address);
+    // returns the newly inserted value, or nullptr if address exists
+    T *insert(address_t address, const T &value);
+
+    void reserve(size_t count);
+    size_t size() const { return __size; }
+    void clear();
+
+private:
+    void rehash(size_t capacity);
+};
+
+template <class T>
+T *AddressHashMap<T>::find(address_t address)
+{
+    if (address == 0) {return __zeroUsed ? &__zeroValue : nullptr;}
+    if (__slots.empty()) {return nullptr;}
+
+    auto mask = __slots.size() - 1;
+    for (auto i = hashAddress(address) >> __shift;; i = (i + 1) & mask)
+    {
+        auto &slot = __slots[i];
+        if (slot.address == address) {return &slot.value;}
+        if (slot.address == 0) {return nullptr;}
+    }
+}
+
+template <class T>
+T *AddressHashMap<T>::insert(address_t address, const T &value)
+{
+    if (address == 0)
+    {
+        if (__zeroUsed) {return nullptr;}
+        __zeroUsed = true;
+        __zeroValue = value;
+        ++__size;
+        return &__zeroValue;
+    }
+
+    if ((__size + 1) * 2 > __slots.size()) {rehash(std::max<size_t>(__slots.size() * 2, 64));}
+
+    auto mask = __slots.size() - 1;
+    for (auto i = hashAddress(address) >> __shift;; i = (i + 1) & mask)
+    {
+        auto &slot = __slots[i];
+        if (slot.address == address) {return nullptr;}
+        if (slot.address == 0)
+        {
+            slot.address = address;
+            slot.value = value;
+            ++__size;
+            return &slot.value;
+        }
+    }
+}
+
+template <class T>
+void AddressHashMap<T>::reserve(size_t count)
+{
+    size_t capacity = 64;
+    while (capacity < count * 2) {capacity <<= 1;}
+    if (capacity > __slots.size()) {rehash(capacity);}
+}
+
+template <class T>
+void AddressHashMap<T>::rehash(size_t capacity)
+{
+    std::vector<Slot> slots(capacity, Slot{0, T()});
+    std::swap(slots, __slots);
+
+    __shift = 64;
+    while (capacity > 1) {capacity >>= 1; --__shift;}
+
+    auto mask = __slots.size() - 1;
+    for (auto iter = slots.begin(); iter != slots.end(); iter++)
+    {
+        if (iter->address == 0) {continue;}
+        auto i = hashAddress(iter->address) >> __shift;
+        while (__slots[i].address != 0) {i = (i + 1) & mask;}
+        __slots[i] = *iter;
+    }
+}
+
+template <class T>
+void AddressHashMap<T>::clear()
+{
+    std::vector<Slot>().swap(__slots);
+    __size = 0;
+    __shift = 64;
+    __zeroUsed = false;
+}
+
+template <class T>
+struct AddressRange
+{
+    const T *first;
+    const T *last;
+
+    const T *begin() const { return first; }
+    const T *end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+};
+
+// Sorted flat arrays for lookups after crawling, duplicated addresses keep insertion order.
+template <class T>
+class AddressIndex
+{
+    std::vector<address_t> __addresses;
+    std::vector<T> __values;
+
+public:
+    void add(address_t address, const T &value);
+    void reserve(size_t count);
+    void build();
+
+    size_t lowerBound(address_t address) const;
+    const T *find(address_t address) const;
+    AddressRange<T> range(address_t address) const;
+
+    address_t address(size_t index) const { return __addresses[index]; }
+    const T &value(size_t index) const { return __values[index]; }
+
+    size_t size() const { return __addresses.size(); }
+    void clear();
+};
+
+template <class T>
+void AddressIndex<T>::add(address_t address, const T &value)
+{
+    __addresses.push_back(address);
+    __values.push_back(value);
+}
+
+template <class T>
+void AddressIndex<T>::reserve(size_t count)
+{
+    __addresses.reserve(count);
+    __values.reserve(count);
+}
+
+template <class T>
+void AddressIndex<T>::build()
+{
+    if (std::is_sorted(__addresses.begin(), __addresses.end())) {return;}
+
+    std::vector<int32_t> order(__addresses.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int32_t a, int32_t b)
+                     {
+                         return __addresses[a] < __addresses[b];
+                     });
+
+    std::vector<address_t> addresses(order.size());
+    std::vector<T> values(order.size());
+    for (auto i = 0; i < order.size(); i++)
+    {
+        addresses[i] = __addresses[order[i]];
+        values[i] = __values[order[i]];
+    }
+
+    std::swap(addresses, __addresses);
+    std::swap(values, __values);
+}
+
+template <class T>
+size_t AddressIndex<T>::lowerBound(address_t address) const
+{
+    const address_t *base = __addresses.data();
+    size_t count = __addresses.size();
+
+    // branchless halving compiles to cmov, the remaining block is counted in a vectorizable loop
+    while (count > 16)
+    {
+        auto half = count >> 1;
+        base = base[half] < address ? base + half : base;
+        count -= half;
+    }
+
+    size_t offset = 0;
+    for (size_t i = 0; i < count; i++) { offset += base[i] < address; }
+    return (base - __addresses.data()) + offset;
+}
+
+template <class T>
+const T *AddressIndex<T>::find(address_t address) const
+{
+    auto index = lowerBound(address);
+    if (index < __addresses.size() && __addresses[index] == address) {return &__values[index];}
+    return nullptr;
+}
+
+template <class T>
+AddressRange<T> AddressIndex<T>::range(address_t address) const
+{
+    auto first = lowerBound(address);
+    auto last = first;
+    while (last < __addresses.size() && __addresses[last] == address) {++last;}
+    return AddressRange<T>{__values.data() + first, __values.data() + last};
+}
+
+template <class T>
+void AddressIndex<T>::clear()
+{
+    std::vector<address_t>().swap(__addresses);
+    std::vector<T>().swap(__values);
+}
+
+#endif /* address_h */
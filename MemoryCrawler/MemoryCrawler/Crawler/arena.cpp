@@ -0,0 +1,77 @@
+//
+//  arena.cpp
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/26.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#include <cassert>
+#include <sys/mman.h>
+#include "arena.h"
+
+MemoryArena::MemoryArena(size_t slabSize): __slabSize(slabSize)
+{
+    assert(slabSize > 0);
+}
+
+char *MemoryArena::map(size_t size)
+{
+    auto page = (size_t)4096;
+    size = (size + page - 1) / page * page;
+    auto base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {throw std::bad_alloc();} // callers never check allocations, same as operator new
+    __slabs.push_back(Slab{(char *)base, size});
+    return (char *)base;
+}
+
+void *MemoryArena::allocate(size_t size, size_t alignment)
+{
+    auto ptr = (char *)(((uintptr_t)__cursor + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    if (__cursor == nullptr || ptr + size > __limit)
+    {
+        // large blocks get their own slab so the current one keeps filling
+        if (size > __slabSize / 4)
+        {
+            __used += size;
+            return map(size);
+        }
+
+        __cursor = map(__slabSize);
+        __limit = __cursor + __slabs.back().size;
+        ptr = __cursor;
+    }
+
+    __cursor = ptr + size;
+    __used += size;
+    return ptr;
+}
+
+size_t MemoryArena::reserved() const
+{
+    size_t size = 0;
+    for (auto iter = __slabs.begin(); iter != __slabs.end(); iter++) { size += iter->size; }
+    return size;
+}
+
+void MemoryArena::reset()
+{
+    for (auto iter = __finalizers.rbegin(); iter != __finalizers.rend(); iter++)
+    {
+        iter->destroy(iter->items, iter->count);
+    }
+    __finalizers.clear();
+
+    for (auto iter = __slabs.begin(); iter != __slabs.end(); iter++)
+    {
+        munmap(iter->base, iter->size);
+    }
+    __slabs.clear();
+    __cursor = __limit = nullptr;
+    __used = 0;
+}
+
+MemoryArena::~MemoryArena()
+{
+    reset();
+}
@@ -0,0 +1,104 @@
+//
+//  arena.h
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/26.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#ifndef arena_h
+#define arena_h
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// bump pointer allocator over mmap'd slabs, everything is released at once when arena is destroyed
+// objects with non-trivial destructors are finalized before slabs are unmapped, not thread safe
+class MemoryArena
+{
+    struct Slab
+    {
+        char *base;
+        size_t size;
+    };
+
+    struct Finalizer
+    {
+        void *items;
+        size_t count;
+        void (*destroy)(void *items, size_t count);
+    };
+
+    size_t __slabSize;
+    std::vector<Slab> __slabs;
+    std::vector<Finalizer> __finalizers;
+    char *__cursor = nullptr;
+    char *__limit = nullptr;
+    size_t __used = 0;
+
+public:
+    static constexpr size_t DEFAULT_SLAB_SIZE = 8 << 20;
+
+    MemoryArena(size_t slabSize = DEFAULT_SLAB_SIZE);
+    MemoryArena(const MemoryArena &) = delete;
+    MemoryArena &operator=(const MemoryArena &) = delete;
+    ~MemoryArena();
+
+    void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // default constructed items
+    template <typename T>
+    T *create(size_t count);
+
+    template <typename T, typename ...Args>
+    T *make(Args&&... args);
+
+    void reset();
+
+    size_t used() const { return __used; }
+    size_t reserved() const;
+    size_t slabCount() const { return __slabs.size(); }
+
+private:
+    char *map(size_t size);
+
+    template <typename T>
+    static void destroy(void *items, size_t count);
+};
+
+template <typename T>
+void MemoryArena::destroy(void *items, size_t count)
+{
+    auto ptr = (T *)items;
+    for (auto i = 0; i < count; i++) { ptr[i].~T(); }
+}
+
+template <typename T>
+T *MemoryArena::create(size_t count)
+{
+    if (count == 0) {return nullptr;}
+    auto items = (T *)allocate(sizeof(T) * count, alignof(T));
+    for (auto i = 0; i < count; i++) { new (items + i) T(); }
+    if (!std::is_trivially_destructible<T>::value)
+    {
+        __finalizers.push_back(Finalizer{items, count, &MemoryArena::destroy<T>});
+    }
+    return items;
+}
+
+template <typename T, typename ...Args>
+T *MemoryArena::make(Args&&... args)
+{
+    auto item = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    if (!std::is_trivially_destructible<T>::value)
+    {
+        __finalizers.push_back(Finalizer{item, 1, &MemoryArena::destroy<T>});
+    }
+    return item;
+}
+
+#endif /* arena_h */
@@ -0,0 +1,139 @@
+//
+//  bench.h
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/14.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#ifndef bench_h
+#define bench_h
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <random>
+#include <vector>
+#include "address.h"
+#include "stream.h"
+
+template <class F>
+double benchElapse(F &&handler)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    handler();
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// compare address indice with std::map over given addresses, e.g. managed objects of a crawled snapshot
+inline void benchAddressIndex(const std::vector<address_t> &addresses)
+{
+    if (addresses.size() == 0) {return;}
+
+    auto count = addresses.size();
+    std::vector<address_t> hits(addresses);
+    std::shuffle(hits.begin(), hits.end(), std::mt19937_64(count));
+    std::vector<address_t> misses(count);
+    for (auto i = 0; i < count; i++) { misses[i] = hits[i] + 4; }
+
+    int64_t checksum = 0;
+    auto report = [&](const char *name, double build, double hit, double miss)
+    {
+        printf("\e[36m%-16s \e[32mbuild=%8.2fms \e[33mhit=%7.2fns \e[33mmiss=%7.2fns\e[0m\n", name, build,
+               hit * 1e6 / count, miss * 1e6 / count);
+    };
+
+    printf("\e[37maddresses=%lu\e[0m\n", count);
+    {
+        std::map<address_t, int32_t> map;
+        auto build = benchElapse([&]{ for (auto i = 0; i < count; i++) { map.insert(std::make_pair(addresses[i], i)); } });
+        auto hit = benchElapse([&]{ for (auto i = hits.begin(); i != hits.end(); i++) { auto iter = map.find(*i); checksum += iter != map.end() ? iter->second : -1; } });
+        auto miss = benchElapse([&]{ for (auto i = misses.begin(); i != misses.end(); i++) { checksum += map.find(*i) != map.end(); } });
+        report("std::map", build, hit, miss);
+    }
+    {
+        AddressHashMap<int32_t> map;
+        auto build = benchElapse([&]{ for (auto i = 0; i < count; i++) { map.insert(addresses[i], i); } });
+        auto hit = benchElapse([&]{ for (auto i = hits.begin(); i != hits.end(); i++) { auto iter = map.find(*i); checksum += iter != nullptr ? *iter : -1; } });
+        auto miss = benchElapse([&]{ for (auto i = misses.begin(); i != misses.end(); i++) { checksum += map.find(*i) != nullptr; } });
+        report("AddressHashMap", build, hit, miss);
+    }
+    {
+        AddressIndex<int32_t> index;
+        auto build = benchElapse([&]
+                                 {
+                                     index.reserve(count);
+                                     for (auto i = 0; i < count; i++) { index.add(addresses[i], i); }
+                                     index.build();
+                                 });
+        auto hit = benchElapse([&]{ for (auto i = hits.begin(); i != hits.end(); i++) { auto iter = index.find(*i); checksum += iter != nullptr ? *iter : -1; } });
+        auto miss = benchElapse([&]{ for (auto i = misses.begin(); i != misses.end(); i++) { checksum += index.find(*i) != nullptr; } });
+        report("AddressIndex", build, hit, miss);
+    }
+    printf("\e[90mchecksum=%lld\e[0m\n", checksum);
+}
+
+// decoding throughput of FileStream paths over given file, legacy per byte std::fstream read as reference
+inline void benchFileStream(const char *filepath)
+{
+    std::ifstream ifs(filepath, std::ios_base::binary | std::ios_base::ate);
+    if (!ifs.is_open()) {return;}
+    size_t size = ifs.tellg();
+    ifs.seekg(0);
+    
+    size_t count = size / sizeof(uint64_t);
+    int64_t checksum = 0;
+    auto report = [&](const char *name, double elapse)
+    {
+        printf("\e[36m%-28s \e[32m%9.2fms \e[33m%9.2fMB/s\e[0m\n", name, elapse, count * sizeof(uint64_t) / elapse / 1e3);
+    };
+    
+    printf("\e[37mbytes=%lu\e[0m\n", count * sizeof(uint64_t));
+    report("fstream::read per byte", benchElapse([&]
+                                                 {
+                                                     char buf[sizeof(uint32_t)];
+                                                     for (size_t i = 0; i < count * 2; i++)
+                                                     {
+                                                         auto ptr = buf + sizeof(uint32_t) - 1;
+                                                         for (auto n = 0; n < sizeof(uint32_t); n++) { ifs.read(ptr--, 1); }
+                                                         checksum += *(uint32_t *)buf;
+                                                     }
+                                                 }));
+    
+    auto bench = [&](const char *name, std::function<void(FileStream &)> handler)
+    {
+        FileStream fs;
+        fs.open(filepath);
+        report(name, benchElapse([&]{ handler(fs); }));
+    };
+    
+    bench("read<uint32_t>", [&](FileStream &fs){ for (size_t i = 0; i < count * 2; i++) { checksum += fs.readUInt32(); } });
+    bench("read<uint32_t> reverse", [&](FileStream &fs){ for (size_t i = 0; i < count * 2; i++) { checksum += fs.readUInt32(true); } });
+    bench("read<uint64_t> reverse", [&](FileStream &fs){ for (size_t i = 0; i < count; i++) { checksum += fs.readUInt64(true); } });
+    
+    const size_t block = 1 << 16;
+    std::vector<uint64_t> items(block);
+    auto bulk = [&](const char *name, size_t width, std::function<void(FileStream &, size_t)> handler)
+    {
+        bench(name, [&](FileStream &fs)
+              {
+                  size_t total = count * sizeof(uint64_t) / width;
+                  for (size_t i = 0; i < total; i += block * sizeof(uint64_t) / width)
+                  {
+                      auto n = std::min(block * sizeof(uint64_t) / width, total - i);
+                      handler(fs, n);
+                      checksum += items[0];
+                  }
+              });
+    };
+    bulk("readArray<int32_t>", 4, [&](FileStream &fs, size_t n){ fs.readArray((int32_t *)items.data(), n); });
+    bulk("readArray<int32_t> reverse", 4, [&](FileStream &fs, size_t n){ fs.readArray((int32_t *)items.data(), n, true); });
+    bulk("readArray<float> reverse", 4, [&](FileStream &fs, size_t n){ fs.readArray((float *)items.data(), n, true); });
+    bulk("readArray<uint64_t> reverse", 8, [&](FileStream &fs, size_t n){ fs.readArray(items.data(), n, true); });
+    
+    bench("readZEString", [&](FileStream &fs){ while (fs.tell() < count * sizeof(uint64_t)) { checksum += fs.readZEString().size(); } });
+    printf("\e[90mchecksum=%lld\e[0m\n", checksum);
+}
+
+#endif /* bench_h */
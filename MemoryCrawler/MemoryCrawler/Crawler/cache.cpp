@@ -9,6 +9,17 @@
 #include "cache.h"
 #include <sys/stat.h>
 #include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <thread>
+#include <type_traits>
+#include "stream.h"
+#include "parallel.h"
+
+constexpr uint32_t SnapshotCrawlerCache::MAGIC;
+constexpr uint32_t SnapshotCrawlerCache::VERSION;
+constexpr int32_t SnapshotCrawlerCache::VM_FIELD_COUNT;
 
 SnapshotCrawlerCache::SnapshotCrawlerCache()
 {
@@ -25,12 +36,6 @@ void SnapshotCrawlerCache::open(const char *filepath)
 //    sqlite3_exec(__database, "PRAGMA journal_mode = MEMORY;", nullptr, nullptr, &errmsg);
 }
 
-void SnapshotCrawlerCache::create(const char *sql)
-{
-    char *errmsg;
-    sqlite3_exec(__database, sql, nullptr, nullptr, &errmsg);
-}
-
 static int sqliteCallbackSelectCount(void *context, int argc, char **argv, char **columns)
 {
     auto ptr = (int *)context;
@@ -48,331 +53,9 @@ int32_t SnapshotCrawlerCache::selectCount(const char *name)
     return count;
 }
 
-void SnapshotCrawlerCache::createNativeTypeTable()
-{
-    create("CREATE TABLE nativeTypes (" \
-           "typeIndex INTEGER PRIMARY KEY," \
-           "name TEXT NOT NULL," \
-           "nativeBaseTypeArrayIndex INTEGER," \
-           "managedTypeArrayIndex INTEGER,"\
-           "instanceCount INTEGER," \
-           "instanceMemory INTEGER);");
-}
-
-void SnapshotCrawlerCache::insert(Array<PackedNativeType> &nativeTypes)
-{
-    insert<PackedNativeType>("INSERT INTO nativeTypes VALUES (?1, ?2, ?3, ?4, ?5, ?6);",
-                             nativeTypes, [](PackedNativeType &nt, sqlite3_stmt *stmt)
-                             {
-                                 sqlite3_bind_int(stmt, 1, nt.typeIndex);
-                                 sqlite3_bind_text(stmt, 2, nt.name.c_str(), (int)nt.name.size(), SQLITE_STATIC);
-                                 sqlite3_bind_int64(stmt, 3, nt.nativeBaseTypeArrayIndex);
-                                 sqlite3_bind_int(stmt, 4, nt.managedTypeArrayIndex);
-                                 sqlite3_bind_int(stmt, 5, nt.instanceCount);
-                                 sqlite3_bind_int(stmt, 6, nt.instanceMemory);
-                                 return true;
-                             });
-}
-
-void SnapshotCrawlerCache::createNativeObjectTable()
-{
-    create("CREATE TABLE nativeObjects (" \
-           "hideFlags INTEGER," \
-           "instanceId INTEGER," \
-           "isDontDestroyOnLoad INTEGER," \
-           "isManager INTEGER," \
-           "isPersistent INTEGER," \
-           "name TEXT NOT NULL," \
-           "nativeObjectAddress INTEGER," \
-           "nativeTypeArrayIndex INTEGER REFERENCES nativeTypes (typeIndex)," \
-           "size INTEGER," \
-           "managedObjectArrayIndex INTEGER," \
-           "nativeObjectArrayIndex INTEGER PRIMARY KEY);");
-}
-
-void SnapshotCrawlerCache::insert(Array<PackedNativeUnityEngineObject> &nativeObjects)
-{
-    insert<PackedNativeUnityEngineObject>("INSERT INTO nativeObjects VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11);",
-                                          nativeObjects, [](PackedNativeUnityEngineObject &no, sqlite3_stmt *stmt)
-                                          {
-                                              sqlite3_bind_int(stmt, 1, no.hideFlags);
-                                              sqlite3_bind_int(stmt, 2, no.instanceId);
-                                              sqlite3_bind_int(stmt, 3, no.isDontDestroyOnLoad);
-                                              sqlite3_bind_int(stmt, 4, no.isManager);
-                                              sqlite3_bind_int(stmt, 5, no.isPersistent);
-                                              sqlite3_bind_text(stmt, 6, no.name.c_str(), (int)no.name.size(), SQLITE_STATIC);
-                                              sqlite3_bind_int64(stmt, 7, no.nativeObjectAddress);
-                                              sqlite3_bind_int(stmt, 8, no.nativeTypeArrayIndex);
-                                              sqlite3_bind_int(stmt, 9, no.size);
-                                              sqlite3_bind_int(stmt, 10, no.managedObjectArrayIndex);
-                                              sqlite3_bind_int(stmt, 11, no.nativeObjectArrayIndex);
-                                              return true;
-                                          });
-}
-
-void SnapshotCrawlerCache::createTypeTable()
-{
-    create("CREATE TABLE types (" \
-           "arrayRank INTEGER," \
-           "assembly TEXT NOT NULL," \
-           "baseOrElementTypeIndex INTEGER," \
-           "isArray INTEGER," \
-           "isValueType INTEGER," \
-           "name TEXT NOT NULL," \
-           "size INTEGER," \
-           "staticFieldBytes BLOB," \
-           "typeIndex INTEGER PRIMARY KEY," \
-           "typeInfoAddress INTEGER," \
-           "nativeTypeArrayIndex INTEGER," \
-           "fields INTEGER," \
-           "instanceCount INTEGER," \
-           "instanceMemory INTEGER," \
-           "nativeMemory INTEGER);");
-}
-
-void SnapshotCrawlerCache::createFieldTable()
-{
-    create("CREATE TABLE fields (" \
-           "id INTEGER PRIMARY KEY," \
-           "hookTypeIndex INTEGER REFERENCES nativeTypes (typeIndex)," \
-           "slotIndex INTEGER," \
-           "isStatic INTEGER," \
-           "name TEXT NOT NULL," \
-           "offset INTEGER," \
-           "typeIndex INTEGER REFERENCES nativeTypes (typeIndex));");
-}
-
-void SnapshotCrawlerCache::insert(Array<TypeDescription> &types)
-{
-    insert<TypeDescription>("INSERT INTO types VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, ?12, ?13, ?14, ?15);",
-                            types, [this](TypeDescription &t, sqlite3_stmt *stmt)
-                            {
-                                sqlite3_bind_int(stmt, 1, t.arrayRank);
-                                sqlite3_bind_text(stmt, 2, t.assembly.c_str(), (int)t.assembly.size(), SQLITE_STATIC);
-                                sqlite3_bind_int(stmt, 3, t.baseOrElementTypeIndex);
-                                sqlite3_bind_int(stmt, 4, t.isArray);
-                                sqlite3_bind_int(stmt, 5, t.isValueType);
-                                sqlite3_bind_text(stmt, 6, t.name.c_str(), (int)t.name.size(), SQLITE_STATIC);
-                                sqlite3_bind_int(stmt, 7, t.size);
-                                if (t.staticFieldBytes != nullptr)
-                                {
-                                    sqlite3_bind_blob(stmt, 8, t.staticFieldBytes->items, t.staticFieldBytes->size, SQLITE_STATIC);
-                                }
-                                sqlite3_bind_int(stmt, 9, t.typeIndex);
-                                sqlite3_bind_int64(stmt, 10, t.typeInfoAddress);
-                                sqlite3_bind_int(stmt, 11, t.nativeTypeArrayIndex);
-                                sqlite3_bind_int(stmt, 12, t.fields != nullptr ? t.fields->size : 0);
-                                sqlite3_bind_int(stmt, 13, t.instanceCount);
-                                sqlite3_bind_int(stmt, 14, t.instanceMemory);
-                                sqlite3_bind_int(stmt, 15, t.nativeMemory);
-                                return true;
-                            });
-    
-    // type fields
-    char *errmsg;
-    sqlite3_stmt *stmt;
-    
-    sqlite3_exec(__database, "BEGIN TRANSACTION", nullptr, nullptr, &errmsg);
-    auto sql = "INSERT INTO fields VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7);";
-    sqlite3_prepare_v2(__database, sql, (int)strlen(sql), &stmt, nullptr);
-    
-    int32_t slotKey = 0;
-    for (auto i = 0; i < types.size; i++)
-    {
-        auto &t = types.items[i];
-        if (t.fields == nullptr || t.fields->size == 0) { continue; }
-        auto iter = t.fields->items;
-        auto count = t.fields->size;
-        while (count-- > 0)
-        {
-            auto &f = *iter;
-            sqlite3_bind_int(stmt, 1, slotKey++);
-            sqlite3_bind_int(stmt, 2, f.hookTypeIndex);
-            sqlite3_bind_int(stmt, 3, f.fieldSlotIndex);
-            sqlite3_bind_int(stmt, 4, f.isStatic);
-            sqlite3_bind_text(stmt, 5, f.name.c_str(), (int)f.name.size(), SQLITE_STATIC);
-            sqlite3_bind_int(stmt, 6, f.offset);
-            sqlite3_bind_int(stmt, 7, f.typeIndex);
-            if (sqlite3_step(stmt) != SQLITE_DONE) {}
-            sqlite3_reset(stmt);
-            ++iter;
-        }
-    }
-    
-    sqlite3_exec(__database, "COMMIT TRANSACTION", nullptr, nullptr, &errmsg);
-    sqlite3_finalize(stmt);
-}
-
-void SnapshotCrawlerCache::createJointTable()
-{
-    create("CREATE TABLE joints (" \
-           "jointArrayIndex INTEGER PRIMARY KEY," \
-           "hookTypeIndex INTEGER," \
-           "hookObjectIndex INTEGER," \
-           "hookObjectAddress INTEGER," \
-           "fieldTypeIndex INTEGER," \
-           "fieldSlotIndex INTEGER," \
-           "fieldOffset INTEGER," \
-           "fieldAddress INTEGER," \
-           "elementArrayIndex INTEGER," \
-           "gcHandleIndex INTEGER," \
-           "isStatic INTEGER);");
-}
-
-void SnapshotCrawlerCache::removeRedundants(MemorySnapshotCrawler &crawler)
-{
-    int32_t jointArrayIndex = 0;
-    auto &joints = crawler.joints;
-    for (auto i = 0; i < joints.size(); i++)
-    {
-        auto &ej = joints[i];
-        if (ej.isConnected)
-        {
-            ej.jointEntryIndex = jointArrayIndex++;
-        }
-    }
-    
-    auto &connections = crawler.connections;
-    for (auto i = 0; i < connections.size(); i++)
-    {
-        auto &ec = connections[i];
-        auto &ej = joints[ec.jointArrayIndex];
-        ec.jointEntryIndex = ej.jointEntryIndex;
-    }
-}
-
-void SnapshotCrawlerCache::insert(InstanceManager<EntityJoint> &joints)
-{
-    insert<EntityJoint>("INSERT INTO joints VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11);",
-                        joints, [](EntityJoint &ej, sqlite3_stmt *stmt)
-                        {
-                            if (!ej.isConnected){return;}
-                            
-                            sqlite3_bind_int(stmt, 1, ej.jointEntryIndex == -1 ? ej.jointArrayIndex : ej.jointEntryIndex);
-                            sqlite3_bind_int(stmt, 2, ej.hookTypeIndex);
-                            sqlite3_bind_int(stmt, 3, ej.hookObjectIndex);
-                            sqlite3_bind_int64(stmt, 4, ej.hookObjectAddress);
-                            sqlite3_bind_int(stmt, 5, ej.fieldTypeIndex);
-                            sqlite3_bind_int(stmt, 6, ej.fieldSlotIndex);
-                            sqlite3_bind_int(stmt, 7, ej.fieldOffset);
-                            sqlite3_bind_int64(stmt, 8, ej.fieldAddress);
-                            sqlite3_bind_int(stmt, 9, ej.elementArrayIndex);
-                            sqlite3_bind_int(stmt, 10, ej.gcHandleIndex);
-                            sqlite3_bind_int(stmt, 11, ej.isStatic);
-                        });
-}
-
-void SnapshotCrawlerCache::createConnectionTable()
-{
-    create("CREATE TABLE connections (" \
-           "connectionArrayIndex INTEGER PRIMARY KEY," \
-           "fromIndex INTEGER," \
-           "fromKind INTEGER," \
-           "toIndex INTEGER," \
-           "toKind INTEGER,"
-           "jointArrayIndex INTEGER REFERENCES joints (jointArrayIndex));");
-}
-
-void SnapshotCrawlerCache::insert(InstanceManager<EntityConnection> &connections)
-{
-    insert<EntityConnection>("INSERT INTO connections VALUES (?1, ?2, ?3, ?4, ?5, ?6);",
-                             connections, [](EntityConnection &ec, sqlite3_stmt *stmt)
-                             {
-                                 sqlite3_bind_int(stmt, 1, ec.connectionArrayIndex);
-                                 sqlite3_bind_int(stmt, 2, ec.from);
-                                 sqlite3_bind_int(stmt, 3, (int)ec.fromKind);
-                                 sqlite3_bind_int(stmt, 4, ec.to);
-                                 sqlite3_bind_int(stmt, 5, (int)ec.toKind);
-                                 sqlite3_bind_int(stmt, 6, ec.jointEntryIndex == -1 ? ec.jointArrayIndex : ec.jointEntryIndex);
-                             });
-}
-
-void SnapshotCrawlerCache::createObjectTable()
-{
-    create("CREATE TABLE objects (" \
-           "address INTEGER," \
-           "typeIndex INTEGER REFERENCES types (typeIndex)," \
-           "managedObjectIndex INTEGER PRIMARY KEY," \
-           "nativeObjectIndex INTEGER," \
-           "isValueType INTEGER," \
-           "size INTEGER," \
-           "nativeSize INTEGER);");
-}
-
-void SnapshotCrawlerCache::insert(InstanceManager<ManagedObject> &objects)
+void SnapshotCrawlerCache::readDatabase(const char *uuid, MemorySnapshotCrawler *crawler)
 {
-    insert<ManagedObject>("INSERT INTO objects VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7);",
-                          objects, [](ManagedObject &mo, sqlite3_stmt *stmt)
-                          {
-                              sqlite3_bind_int64(stmt, 1, mo.address);
-                              sqlite3_bind_int(stmt, 2, mo.typeIndex);
-                              sqlite3_bind_int(stmt, 3, mo.managedObjectIndex);
-                              sqlite3_bind_int(stmt, 4, mo.nativeObjectIndex);
-                              sqlite3_bind_int(stmt, 5, mo.isValueType);
-                              sqlite3_bind_int(stmt, 6, mo.size);
-                              sqlite3_bind_int(stmt, 7, mo.nativeSize);
-                          });
-}
-
-void SnapshotCrawlerCache::createVMTable()
-{
-    create("CREATE TABLE vm (" \
-           "allocationGranularity INTEGER," \
-           "arrayBoundsOffsetInHeader INTEGER," \
-           "arrayHeaderSize INTEGER," \
-           "arraySizeOffsetInHeader INTEGER," \
-           "heapFormatVersion INTEGER," \
-           "objectHeaderSize INTEGER," \
-           "pointerSize INTEGER);");
-}
-
-void SnapshotCrawlerCache::createStringTable()
-{
-    create("CREATE TABLE strings (" \
-           "id INTEGER PRIMARY KEY," \
-           "size INTEGER," \
-           "data TEXT NOT NULL," \
-           "address INTEGER);");
-}
-
-void SnapshotCrawlerCache::insertStringTable(MemorySnapshotCrawler &crawler)
-{
-    char *errmsg;
-    sqlite3_stmt *stmt;
-    
-    const char sql[] = "INSERT INTO strings VALUES (?1, ?2, ?3, ?4);";
-    sqlite3_exec(__database, "BEGIN TRANSACTION", nullptr, nullptr, &errmsg);
-    sqlite3_prepare_v2(__database, sql, (int)strlen(sql), &stmt, nullptr);
-    
-    int32_t sequence = 0;
-    int32_t stringTypeIndex = crawler.snapshot->managedTypeIndex.system_String;
-    auto &managedObjects = crawler.managedObjects;
-    for (auto i = 0; i < managedObjects.size(); i++)
-    {
-        auto &mo = managedObjects[i];
-        if (stringTypeIndex == mo.typeIndex)
-        {
-            int32_t size;
-            auto target = crawler.getString(mo.address, size);
-            if (size < 0) {continue;}
-            
-            sqlite3_bind_int(stmt, 1, sequence++);
-            sqlite3_bind_int(stmt, 2, size);
-            sqlite3_bind_text16(stmt, 3, target, size, SQLITE_STATIC);
-            sqlite3_bind_int64(stmt, 4, mo.address);
-            
-            if (sqlite3_step(stmt) != SQLITE_DONE) {}
-            sqlite3_reset(stmt);
-        }
-    }
-    
-    sqlite3_exec(__database, "COMMIT TRANSACTION", nullptr, nullptr, &errmsg);
-    sqlite3_finalize(stmt);
-}
-
-void SnapshotCrawlerCache::read(const char *uuid, MemorySnapshotCrawler *crawler)
-{
-    __sampler.begin("SnapshotCrawlerCache::read");
+    __sampler.begin("SnapshotCrawlerCache::readDatabase");
     char filepath[256];
     sprintf(filepath, "%s/%s.db", __workspace, uuid);
     
@@ -384,12 +67,12 @@ void SnapshotCrawlerCache::read(const char *uuid, MemorySnapshotCrawler *crawler
     auto &snapshot = *crawler->snapshot;
     
     __sampler.begin("read_native_types");
-    snapshot.nativeTypes = new Array<PackedNativeType>(selectCount("nativeTypes"));
+    snapshot.nativeTypes = Array<PackedNativeType>::create(snapshot.arena, selectCount("nativeTypes"));
     select<PackedNativeType>("select * from nativeTypes;", *snapshot.nativeTypes,
-                             [](PackedNativeType &nt, sqlite3_stmt *stmt)
+                             [&](PackedNativeType &nt, sqlite3_stmt *stmt)
                              {
                                  nt.typeIndex = sqlite3_column_int(stmt, 0);
-                                 nt.name = (char *)sqlite3_column_text(stmt, 1);
+                                 nt.name = snapshot.strings.intern((char *)sqlite3_column_text(stmt, 1));
                                  nt.nativeBaseTypeArrayIndex = sqlite3_column_int(stmt, 2);
                                  nt.managedTypeArrayIndex = sqlite3_column_int(stmt, 3);
                                  nt.instanceCount = sqlite3_column_int(stmt, 4);
@@ -398,16 +81,16 @@ void SnapshotCrawlerCache::read(const char *uuid, MemorySnapshotCrawler *crawler
     __sampler.end(); // read_native_types
     
     __sampler.begin("read_native_objects");
-    snapshot.nativeObjects = new Array<PackedNativeUnityEngineObject>(selectCount("nativeObjects"));
+    snapshot.nativeObjects = Array<PackedNativeUnityEngineObject>::create(snapshot.arena, selectCount("nativeObjects"));
     select<PackedNativeUnityEngineObject>("select * from nativeObjects;", *snapshot.nativeObjects,
-                                          [](PackedNativeUnityEngineObject &nt, sqlite3_stmt *stmt)
+                                          [&](PackedNativeUnityEngineObject &nt, sqlite3_stmt *stmt)
                                           {
                                               nt.hideFlags = sqlite3_column_int(stmt, 0);
                                               nt.instanceId = sqlite3_column_int(stmt, 1);
                                               nt.isDontDestroyOnLoad = (bool)sqlite3_column_int(stmt, 2);
                                               nt.isManager = (bool)sqlite3_column_int(stmt, 3);
                                               nt.isPersistent = (bool)sqlite3_column_int(stmt, 4);
-                                              nt.name = (char *)sqlite3_column_text(stmt, 5);
+                                              nt.name = snapshot.strings.intern((char *)sqlite3_column_text(stmt, 5));
                                               nt.nativeObjectAddress = sqlite3_column_int64(stmt, 6);
                                               nt.nativeTypeArrayIndex = sqlite3_column_int(stmt, 7);
                                               nt.size = sqlite3_column_int(stmt, 8);
@@ -417,23 +100,23 @@ void SnapshotCrawlerCache::read(const char *uuid, MemorySnapshotCrawler *crawler
     __sampler.end(); // read_native_objects
     
     __sampler.begin("read_managed_types");
-    snapshot.typeDescriptions = new Array<TypeDescription>(selectCount("types"));
+    snapshot.typeDescriptions = Array<TypeDescription>::create(snapshot.arena, selectCount("types"));
     select<TypeDescription>("select * from types;", *snapshot.typeDescriptions,
-                            [](TypeDescription &mt, sqlite3_stmt *stmt)
+                            [&](TypeDescription &mt, sqlite3_stmt *stmt)
                             {
                                 mt.arrayRank = sqlite3_column_int(stmt, 0);
-                                mt.assembly = (char *)sqlite3_column_text(stmt, 1);
+                                mt.assembly = snapshot.strings.intern((char *)sqlite3_column_text(stmt, 1));
                                 mt.baseOrElementTypeIndex = sqlite3_column_int(stmt, 2);
                                 mt.isArray = (bool)sqlite3_column_int(stmt, 3);
                                 mt.isValueType = (bool)sqlite3_column_int(stmt, 4);
-                                mt.name = (char *)sqlite3_column_text(stmt, 5);
+                                mt.name = snapshot.strings.intern((char *)sqlite3_column_text(stmt, 5));
                                 mt.size = sqlite3_column_int(stmt, 6);
                                 {
                                     auto size = sqlite3_column_bytes(stmt, 7);
                                     if (size > 0)
                                     {
                                         auto data = (const char *)sqlite3_column_blob(stmt, 7);
-                                        mt.staticFieldBytes = new Array<byte_t>(size);
+                                        mt.staticFieldBytes = Array<byte_t>::create(snapshot.arena, size);
                                         memcpy(mt.staticFieldBytes->items, data, size);
                                     }
                                 }
@@ -444,7 +127,7 @@ void SnapshotCrawlerCache::read(const char *uuid, MemorySnapshotCrawler *crawler
                                     auto size = sqlite3_column_int(stmt, 11);
                                     if (size > 0)
                                     {
-                                        mt.fields = new Array<FieldDescription>(size);
+                                        mt.fields = Array<FieldDescription>::create(snapshot.arena, size);
                                     }
                                 }
                                 mt.instanceCount = sqlite3_column_int(stmt, 12);
@@ -468,7 +151,7 @@ void SnapshotCrawlerCache::read(const char *uuid, MemorySnapshotCrawler *crawler
                auto &field = hookType->fields->items[fieldSlotIndex];
                field.hookTypeIndex = fieldHookTypeIndex;
                field.isStatic = (bool)sqlite3_column_int(stmt, 3);
-               field.name = (char *)sqlite3_column_text(stmt, 4);
+               field.name = snapshot.strings.intern((char *)sqlite3_column_text(stmt, 4));
                field.offset = sqlite3_column_int(stmt, 5);
                field.typeIndex = sqlite3_column_int(stmt, 6);
            });
@@ -539,6 +222,7 @@ void SnapshotCrawlerCache::read(const char *uuid, MemorySnapshotCrawler *crawler
                               mo.nativeSize = sqlite3_column_int(stmt, 6);
                           });
     __sampler.end(); // read_managed_objects
+    crawler->buildManagedGraph();
     __sampler.end(); // read_crawler
     __sampler.end(); // ::read
     
@@ -560,114 +244,1283 @@ void SnapshotCrawlerCache::select(const char *sql, int32_t size, std::function<v
     sqlite3_finalize(stmt);
 }
 
-void SnapshotCrawlerCache::insertVMTable(VirtualMachineInformation &vm)
+static const char *NATIVE_TYPE_SCHEMA =
+    "CREATE TABLE nativeTypes (" \
+    "typeIndex INTEGER PRIMARY KEY," \
+    "name TEXT NOT NULL," \
+    "nativeBaseTypeArrayIndex INTEGER," \
+    "managedTypeArrayIndex INTEGER,"\
+    "instanceCount INTEGER," \
+    "instanceMemory INTEGER);";
+
+static const char *NATIVE_OBJECT_SCHEMA =
+    "CREATE TABLE nativeObjects (" \
+    "hideFlags INTEGER," \
+    "instanceId INTEGER," \
+    "isDontDestroyOnLoad INTEGER," \
+    "isManager INTEGER," \
+    "isPersistent INTEGER," \
+    "name TEXT NOT NULL," \
+    "nativeObjectAddress INTEGER," \
+    "nativeTypeArrayIndex INTEGER REFERENCES nativeTypes (typeIndex)," \
+    "size INTEGER," \
+    "managedObjectArrayIndex INTEGER," \
+    "nativeObjectArrayIndex INTEGER PRIMARY KEY);";
+
+static const char *TYPE_SCHEMA =
+    "CREATE TABLE types (" \
+    "arrayRank INTEGER," \
+    "assembly TEXT NOT NULL," \
+    "baseOrElementTypeIndex INTEGER," \
+    "isArray INTEGER," \
+    "isValueType INTEGER," \
+    "name TEXT NOT NULL," \
+    "size INTEGER," \
+    "staticFieldBytes BLOB," \
+    "typeIndex INTEGER PRIMARY KEY," \
+    "typeInfoAddress INTEGER," \
+    "nativeTypeArrayIndex INTEGER," \
+    "fields INTEGER," \
+    "instanceCount INTEGER," \
+    "instanceMemory INTEGER," \
+    "nativeMemory INTEGER);";
+
+static const char *FIELD_SCHEMA =
+    "CREATE TABLE fields (" \
+    "id INTEGER PRIMARY KEY," \
+    "hookTypeIndex INTEGER REFERENCES nativeTypes (typeIndex)," \
+    "slotIndex INTEGER," \
+    "isStatic INTEGER," \
+    "name TEXT NOT NULL," \
+    "offset INTEGER," \
+    "typeIndex INTEGER REFERENCES nativeTypes (typeIndex));";
+
+#if FULL_CACHE_ENABLED
+static const char *JOINT_SCHEMA =
+    "CREATE TABLE joints (" \
+    "jointArrayIndex INTEGER PRIMARY KEY," \
+    "hookTypeIndex INTEGER," \
+    "hookObjectIndex INTEGER," \
+    "hookObjectAddress INTEGER," \
+    "fieldTypeIndex INTEGER," \
+    "fieldSlotIndex INTEGER," \
+    "fieldOffset INTEGER," \
+    "fieldAddress INTEGER," \
+    "elementArrayIndex INTEGER," \
+    "gcHandleIndex INTEGER," \
+    "isStatic INTEGER);";
+
+static const char *CONNECTION_SCHEMA =
+    "CREATE TABLE connections (" \
+    "connectionArrayIndex INTEGER PRIMARY KEY," \
+    "fromIndex INTEGER," \
+    "fromKind INTEGER," \
+    "toIndex INTEGER," \
+    "toKind INTEGER," \
+    "jointArrayIndex INTEGER REFERENCES joints (jointArrayIndex));";
+#endif
+
+static const char *OBJECT_SCHEMA =
+    "CREATE TABLE objects (" \
+    "address INTEGER," \
+    "typeIndex INTEGER REFERENCES types (typeIndex)," \
+    "managedObjectIndex INTEGER PRIMARY KEY," \
+    "nativeObjectIndex INTEGER," \
+    "isValueType INTEGER," \
+    "size INTEGER," \
+    "nativeSize INTEGER);";
+
+static const char *VM_SCHEMA =
+    "CREATE TABLE vm (" \
+    "allocationGranularity INTEGER," \
+    "arrayBoundsOffsetInHeader INTEGER," \
+    "arrayHeaderSize INTEGER," \
+    "arraySizeOffsetInHeader INTEGER," \
+    "heapFormatVersion INTEGER," \
+    "objectHeaderSize INTEGER," \
+    "pointerSize INTEGER);";
+
+static const char *STRING_SCHEMA =
+    "CREATE TABLE strings (" \
+    "id INTEGER PRIMARY KEY," \
+    "size INTEGER," \
+    "data TEXT NOT NULL," \
+    "address INTEGER);";
+
+// secondary indice are built once all rows are loaded
+static const char *DATABASE_INDICE[] =
 {
-    char *errmsg;
-    sqlite3_stmt *stmt;
+    "CREATE INDEX nativeObjects_address ON nativeObjects (nativeObjectAddress);",
+    "CREATE INDEX fields_hookTypeIndex ON fields (hookTypeIndex);",
+    "CREATE INDEX objects_address ON objects (address);",
+    "CREATE INDEX strings_address ON strings (address);",
+#if FULL_CACHE_ENABLED
+    "CREATE INDEX connections_fromIndex ON connections (fromIndex);",
+    "CREATE INDEX connections_toIndex ON connections (toIndex);",
+#endif
+};
+
+// collects column values of pending rows, which are bound to a multi-row insert statement once its row count is known
+class SQLiteRow
+{
+    enum ValueKind { VK_null, VK_integer, VK_text, VK_text16, VK_blob };
+    struct Value
+    {
+        ValueKind kind;
+        sqlite3_int64 integer;
+        const void *data;
+        int size;
+    };
     
-    const char sql[] = "INSERT INTO vm VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7);";
-    sqlite3_exec(__database, "BEGIN TRANSACTION", nullptr, nullptr, &errmsg);
-    sqlite3_prepare_v2(__database, sql, (int)strlen(sql), &stmt, nullptr);
+    std::vector<Value> __values;
+    
+public:
+    size_t size() const { return __values.size(); }
+    
+    void bind(int32_t v) { __values.push_back(Value{VK_integer, v, nullptr, 0}); }
+    void bind(address_t v) { __values.push_back(Value{VK_integer, (sqlite3_int64)v, nullptr, 0}); }
+    void bind(const string &v) { __values.push_back(Value{VK_text, 0, v.c_str(), (int)v.size()}); }
+    void bind(const PooledString &v) { __values.push_back(Value{VK_text, 0, v.c_str(), (int)v.size()}); }
+    void bind(const char16_t *v, int32_t size) { __values.push_back(Value{VK_text16, 0, v, size}); }
+    void bind(const Array<byte_t> *v)
+    {
+        if (v == nullptr) { __values.push_back(Value{VK_null, 0, nullptr, 0}); }
+        else { __values.push_back(Value{VK_blob, 0, v->items, (int)v->size}); }
+    }
     
-    sqlite3_bind_int(stmt, 1, vm.allocationGranularity);
-    sqlite3_bind_int(stmt, 2, vm.arrayBoundsOffsetInHeader);
-    sqlite3_bind_int(stmt, 3, vm.arrayHeaderSize);
-    sqlite3_bind_int(stmt, 4, vm.arraySizeOffsetInHeader);
-    sqlite3_bind_int(stmt, 5, vm.heapFormatVersion);
-    sqlite3_bind_int(stmt, 6, vm.objectHeaderSize);
-    sqlite3_bind_int(stmt, 7, vm.pointerSize);
+    // bind collected values in order and start over, bound data must stay alive until statement is stepped
+    void apply(sqlite3_stmt *stmt)
+    {
+        for (auto i = 0; i < __values.size(); i++)
+        {
+            auto &v = __values[i];
+            auto column = i + 1;
+            switch (v.kind)
+            {
+                case VK_null: sqlite3_bind_null(stmt, column); break;
+                case VK_integer: sqlite3_bind_int64(stmt, column, v.integer); break;
+                case VK_text: sqlite3_bind_text(stmt, column, (const char *)v.data, v.size, SQLITE_STATIC); break;
+                case VK_text16: sqlite3_bind_text16(stmt, column, v.data, v.size, SQLITE_STATIC); break;
+                case VK_blob: sqlite3_bind_blob(stmt, column, v.data, v.size, SQLITE_STATIC); break;
+            }
+        }
+        __values.clear();
+    }
+};
+
+static bool execute(sqlite3 *database, const char *sql)
+{
+    char *errmsg = nullptr;
+    if (sqlite3_exec(database, sql, nullptr, nullptr, &errmsg) == SQLITE_OK) {return true;}
+    printf("\e[31m[SQLite] %s\e[0m\n", errmsg);
+    sqlite3_free(errmsg);
+    return false;
+}
+
+// no journal and no fsync, database is rebuilt from scratch on every export
+static sqlite3 *openBulkDatabase(const char *filepath)
+{
+    remove(filepath);
+    sqlite3 *database = nullptr;
+    auto rc = sqlite3_open(filepath, &database);
+    assert(rc == 0);
+    execute(database, "PRAGMA journal_mode=OFF;");
+    execute(database, "PRAGMA synchronous=OFF;");
+    execute(database, "PRAGMA locking_mode=EXCLUSIVE;");
+    execute(database, "PRAGMA temp_store=MEMORY;");
+    execute(database, "PRAGMA cache_size=-65536;");
+    execute(database, "PRAGMA FOREIGN_KEYS=OFF;");
+    return database;
+}
+
+static sqlite3_stmt *prepareInsert(sqlite3 *database, const char *table, int32_t columns, int32_t rows)
+{
+    string sql = string("INSERT INTO ") + table + " VALUES ";
+    for (auto r = 0; r < rows; r++)
+    {
+        sql += r == 0 ? "(" : ",(";
+        for (auto c = 0; c < columns; c++) { sql += c == 0 ? "?" : ",?"; }
+        sql += ")";
+    }
     
-    if (sqlite3_step(stmt) != SQLITE_DONE) {}
+    sqlite3_stmt *stmt = nullptr;
+    sqlite3_prepare_v2(database, sql.c_str(), (int)sql.size(), &stmt, nullptr);
+    return stmt;
+}
+
+static bool step(sqlite3 *database, sqlite3_stmt *stmt, const char *table)
+{
+    auto rc = sqlite3_step(stmt);
     sqlite3_reset(stmt);
+    if (rc == SQLITE_DONE) {return true;}
+    printf("\e[31m[SQLite] insert %s: %s\e[0m\n", table, sqlite3_errmsg(database));
+    return false;
+}
+
+// multi-row insert in one transaction, bind(index, row) returns false to skip index before binding anything
+template <typename F>
+static int64_t insertRows(sqlite3 *database, const char *table, int32_t columns, int32_t count, F bind)
+{
+    constexpr int32_t VARIABLE_LIMIT = 999; // SQLITE_MAX_VARIABLE_NUMBER of older sqlite
+    auto batch = std::max(1, VARIABLE_LIMIT / columns);
     
-    sqlite3_exec(__database, "COMMIT TRANSACTION", nullptr, nullptr, &errmsg);
+    execute(database, "BEGIN TRANSACTION;");
+    auto stmt = prepareInsert(database, table, columns, batch);
+    
+    SQLiteRow row;
+    int32_t pending = 0;
+    int64_t total = 0;
+    auto success = true;
+    for (auto i = 0; i < count && success; i++)
+    {
+        // each row is bound exactly once, tail rows are kept until a statement of matching size is prepared
+        if (!bind(i, row)) {continue;}
+        assert(row.size() == (size_t)(pending + 1) * columns);
+        if (++pending == batch)
+        {
+            row.apply(stmt);
+            success = step(database, stmt, table);
+            total += pending;
+            pending = 0;
+        }
+    }
     sqlite3_finalize(stmt);
+    
+    if (success && pending > 0)
+    {
+        stmt = prepareInsert(database, table, columns, pending);
+        row.apply(stmt);
+        if (step(database, stmt, table)) { total += pending; }
+        sqlite3_finalize(stmt);
+    }
+    
+    execute(database, "COMMIT TRANSACTION;");
+    return total;
 }
 
-void SnapshotCrawlerCache::save(MemorySnapshotCrawler &crawler)
+struct DatabaseTable
+{
+    const char *name;
+    const char *schema;
+    int32_t capacity; // upper bound of rows
+    std::function<int64_t(sqlite3 *database, const char *name)> write;
+    
+    int64_t rows = 0;
+    int64_t elapse = 0; // nanoseconds
+};
+
+void SnapshotCrawlerCache::removeRedundants(MemorySnapshotCrawler &crawler)
+{
+    int32_t jointArrayIndex = 0;
+    auto &joints = crawler.joints;
+    for (auto i = 0; i < joints.size(); i++)
+    {
+        auto &ej = joints[i];
+        if (ej.isConnected)
+        {
+            ej.jointEntryIndex = jointArrayIndex++;
+        }
+    }
+    
+    auto &connections = crawler.connections;
+    for (auto i = 0; i < connections.size(); i++)
+    {
+        auto &ec = connections[i];
+        auto &ej = joints[ec.jointArrayIndex];
+        ec.jointEntryIndex = ej.jointEntryIndex;
+    }
+}
+
+void SnapshotCrawlerCache::saveDatabase(MemorySnapshotCrawler &crawler)
 {
     if (crawler.snapshot->uuid == string()) {return;}
     
-    __sampler.begin("SnapshotCrawlerCache::save");
+    __sampler.begin("SnapshotCrawlerCache::saveDatabase");
     mkdir(__workspace, 0777);
     
-    char filepath[64];
-    sprintf(filepath, "%s/%s.db", __workspace, crawler.snapshot->uuid.c_str());
-    remove(filepath);
+    __sampler.begin("remove_redundants");
+    removeRedundants(crawler);
+    __sampler.end();
     
-    __sampler.begin("open");
-    open(filepath);
+    auto &snapshot = *crawler.snapshot;
+    std::vector<FieldDescription *> fields;
+    auto &types = *snapshot.typeDescriptions;
+    for (auto i = 0; i < types.size; i++)
+    {
+        auto &t = types[i];
+        if (t.fields == nullptr) {continue;}
+        for (auto n = 0; n < t.fields->size; n++) { fields.push_back(&t.fields->items[n]); }
+    }
+    
+    std::vector<DatabaseTable> tables;
+    tables.push_back(DatabaseTable{"nativeTypes", NATIVE_TYPE_SCHEMA, snapshot.nativeTypes->size, [&](sqlite3 *database, const char *name)
+    {
+        auto &nativeTypes = *snapshot.nativeTypes;
+        return insertRows(database, name, 6, nativeTypes.size, [&](int32_t i, SQLiteRow &row)
+                          {
+                              auto &nt = nativeTypes[i];
+                              row.bind(nt.typeIndex);
+                              row.bind(nt.name);
+                              row.bind(nt.nativeBaseTypeArrayIndex);
+                              row.bind(nt.managedTypeArrayIndex);
+                              row.bind(nt.instanceCount);
+                              row.bind(nt.instanceMemory);
+                              return true;
+                          });
+    }});
+    tables.push_back(DatabaseTable{"nativeObjects", NATIVE_OBJECT_SCHEMA, snapshot.nativeObjects->size, [&](sqlite3 *database, const char *name)
+    {
+        auto &nativeObjects = *snapshot.nativeObjects;
+        return insertRows(database, name, 11, nativeObjects.size, [&](int32_t i, SQLiteRow &row)
+                          {
+                              auto &no = nativeObjects[i];
+                              row.bind(no.hideFlags);
+                              row.bind(no.instanceId);
+                              row.bind(no.isDontDestroyOnLoad);
+                              row.bind(no.isManager);
+                              row.bind(no.isPersistent);
+                              row.bind(no.name);
+                              row.bind(no.nativeObjectAddress);
+                              row.bind(no.nativeTypeArrayIndex);
+                              row.bind(no.size);
+                              row.bind(no.managedObjectArrayIndex);
+                              row.bind(no.nativeObjectArrayIndex);
+                              return true;
+                          });
+    }});
+    tables.push_back(DatabaseTable{"types", TYPE_SCHEMA, types.size, [&](sqlite3 *database, const char *name)
+    {
+        return insertRows(database, name, 15, types.size, [&](int32_t i, SQLiteRow &row)
+                          {
+                              auto &t = types[i];
+                              row.bind(t.arrayRank);
+                              row.bind(t.assembly);
+                              row.bind(t.baseOrElementTypeIndex);
+                              row.bind(t.isArray);
+                              row.bind(t.isValueType);
+                              row.bind(t.name);
+                              row.bind(t.size);
+                              row.bind(t.staticFieldBytes);
+                              row.bind(t.typeIndex);
+                              row.bind(t.typeInfoAddress);
+                              row.bind(t.nativeTypeArrayIndex);
+                              row.bind(t.fields != nullptr ? t.fields->size : 0);
+                              row.bind(t.instanceCount);
+                              row.bind(t.instanceMemory);
+                              row.bind(t.nativeMemory);
+                              return true;
+                          });
+    }});
+    tables.push_back(DatabaseTable{"fields", FIELD_SCHEMA, (int32_t)fields.size(), [&](sqlite3 *database, const char *name)
+    {
+        return insertRows(database, name, 7, (int32_t)fields.size(), [&](int32_t i, SQLiteRow &row)
+                          {
+                              auto &f = *fields[i];
+                              row.bind(i);
+                              row.bind(f.hookTypeIndex);
+                              row.bind(f.fieldSlotIndex);
+                              row.bind(f.isStatic);
+                              row.bind(f.name);
+                              row.bind(f.offset);
+                              row.bind(f.typeIndex);
+                              return true;
+                          });
+    }});
+#if FULL_CACHE_ENABLED
+    tables.push_back(DatabaseTable{"joints", JOINT_SCHEMA, crawler.joints.size(), [&](sqlite3 *database, const char *name)
+    {
+        auto &joints = crawler.joints;
+        return insertRows(database, name, 11, joints.size(), [&](int32_t i, SQLiteRow &row)
+                          {
+                              auto &ej = joints[i];
+                              if (!ej.isConnected) {return false;}
+                              row.bind(ej.jointEntryIndex == -1 ? ej.jointArrayIndex : ej.jointEntryIndex);
+                              row.bind(ej.hookTypeIndex);
+                              row.bind(ej.hookObjectIndex);
+                              row.bind(ej.hookObjectAddress);
+                              row.bind(ej.fieldTypeIndex);
+                              row.bind(ej.fieldSlotIndex);
+                              row.bind(ej.fieldOffset);
+                              row.bind(ej.fieldAddress);
+                              row.bind(ej.elementArrayIndex);
+                              row.bind(ej.gcHandleIndex);
+                              row.bind(ej.isStatic);
+                              return true;
+                          });
+    }});
+    tables.push_back(DatabaseTable{"connections", CONNECTION_SCHEMA, crawler.connections.size(), [&](sqlite3 *database, const char *name)
+    {
+        auto &connections = crawler.connections;
+        return insertRows(database, name, 6, connections.size(), [&](int32_t i, SQLiteRow &row)
+                          {
+                              auto &ec = connections[i];
+                              row.bind(ec.connectionArrayIndex);
+                              row.bind(ec.from);
+                              row.bind((int32_t)ec.fromKind);
+                              row.bind(ec.to);
+                              row.bind((int32_t)ec.toKind);
+                              row.bind(ec.jointEntryIndex == -1 ? ec.jointArrayIndex : ec.jointEntryIndex);
+                              return true;
+                          });
+    }});
+#endif
+    tables.push_back(DatabaseTable{"objects", OBJECT_SCHEMA, crawler.managedObjects.size(), [&](sqlite3 *database, const char *name)
+    {
+        auto &objects = crawler.managedObjects;
+        return insertRows(database, name, 7, objects.size(), [&](int32_t i, SQLiteRow &row)
+                          {
+                              auto &mo = objects[i];
+                              row.bind(mo.address);
+                              row.bind(mo.typeIndex);
+                              row.bind(mo.managedObjectIndex);
+                              row.bind(mo.nativeObjectIndex);
+                              row.bind(mo.isValueType);
+                              row.bind(mo.size);
+                              row.bind(mo.nativeSize);
+                              return true;
+                          });
+    }});
+    tables.push_back(DatabaseTable{"vm", VM_SCHEMA, 1, [&](sqlite3 *database, const char *name)
+    {
+        auto &vm = snapshot.virtualMachineInformation;
+        return insertRows(database, name, 7, 1, [&](int32_t i, SQLiteRow &row)
+                          {
+                              row.bind(vm.allocationGranularity);
+                              row.bind(vm.arrayBoundsOffsetInHeader);
+                              row.bind(vm.arrayHeaderSize);
+                              row.bind(vm.arraySizeOffsetInHeader);
+                              row.bind(vm.heapFormatVersion);
+                              row.bind(vm.objectHeaderSize);
+                              row.bind(vm.pointerSize);
+                              return true;
+                          });
+    }});
+    tables.push_back(DatabaseTable{"strings", STRING_SCHEMA, crawler.managedObjects.size(), [&](sqlite3 *database, const char *name)
+    {
+        int32_t sequence = 0;
+        int32_t stringTypeIndex = snapshot.managedTypeIndex.system_String;
+        auto &objects = crawler.managedObjects;
+        return insertRows(database, name, 4, objects.size(), [&](int32_t i, SQLiteRow &row)
+                          {
+                              auto &mo = objects[i];
+                              if (stringTypeIndex != mo.typeIndex) {return false;}
+                              
+                              int32_t size = 0;
+                              auto target = crawler.getString(mo.address, size);
+                              if (target == nullptr || size < 0) {return false;}
+                              
+                              row.bind(sequence++);
+                              row.bind(size);
+                              row.bind(target, size);
+                              row.bind(mo.address);
+                              return true;
+                          });
+    }});
+    
+    // largest table goes straight into main database, others are written by workers into separate databases
+    char filepath[256];
+    sprintf(filepath, "%s/%s.db", __workspace, snapshot.uuid.c_str());
+    __database = openBulkDatabase(filepath);
+    
+    int32_t primary = 0;
+    for (auto i = 1; i < tables.size(); i++)
+    {
+        if (tables[i].capacity > tables[primary].capacity) {primary = i;}
+    }
+    
+    auto partpath = [&](char *buffer, DatabaseTable &table)
+    {
+        sprintf(buffer, "%s/%s.%s.db", __workspace, snapshot.uuid.c_str(), table.name);
+        return buffer;
+    };
+    
+    __sampler.begin("write_tables");
+    WorkStealingPool<int32_t> pool(std::min((int32_t)tables.size(), (int32_t)std::thread::hardware_concurrency()));
+    for (auto i = 0; i < tables.size(); i++) { pool.push(i, i); }
+    pool.run([&](int32_t worker, int32_t &index)
+             {
+                 char path[256];
+                 auto &table = tables[index];
+                 PerfScope scope("write_table");
+                 scope.annotate(table.name);
+                 auto database = index == primary ? __database : openBulkDatabase(partpath(path, table));
+                 
+                 auto start = high_resolution_clock::now();
+                 if (execute(database, table.schema)) { table.rows = table.write(database, table.name); }
+                 table.elapse = std::chrono::duration_cast<std::chrono::nanoseconds>(high_resolution_clock::now() - start).count();
+                 if (database != __database) { sqlite3_close(database); }
+             });
     __sampler.end();
     
-    __sampler.begin("create_native_types");
-    createNativeTypeTable();
+    __sampler.begin("merge_tables");
+    for (auto i = 0; i < tables.size(); i++)
+    {
+        auto &table = tables[i];
+        __sampler.begin(table.name);
+        if (i != primary)
+        {
+            char path[256];
+            sprintf(__buffer, "ATTACH DATABASE '%s' AS part;", partpath(path, table));
+            execute(__database, table.schema);
+            if (execute(__database, __buffer))
+            {
+                // identical schema lets sqlite copy rows without decoding
+                sprintf(__buffer, "INSERT INTO main.%s SELECT * FROM part.%s;", table.name, table.name);
+                execute(__database, __buffer);
+                execute(__database, "DETACH DATABASE part;");
+            }
+            remove(path);
+        }
+        
+        char note[128];
+        snprintf(note, sizeof(note), "rows=%lld write=%.1fms %.0f rows/s", (long long)table.rows, table.elapse / 1e6, table.elapse > 0 ? table.rows * 1e9 / table.elapse : 0.0);
+        __sampler.annotate(note);
+        __sampler.end();
+    }
     __sampler.end();
     
-    __sampler.begin("create_native_objects");
-    createNativeObjectTable();
+    sprintf(__buffer, "PRAGMA threads=%d;", pool.threadCount());
+    execute(__database, __buffer); // parallel sorter for index creation
+    __sampler.begin("create_indice");
+    for (auto i = 0; i < sizeof(DATABASE_INDICE) / sizeof(DATABASE_INDICE[0]); i++)
+    {
+        execute(__database, DATABASE_INDICE[i]);
+    }
     __sampler.end();
     
-    __sampler.begin("create_managed_types");
-    createTypeTable();
     __sampler.end();
     
-    __sampler.begin("create_type_fields");
-    createFieldTable();
     __sampler.end();
+    __sampler.summarize();
+}
+
+
+// flat file of 8-byte aligned blocks, each table is stored as one column per field
+class CacheWriter
+{
+    FileStream __fs;
+    size_t __position = 0;
+    std::vector<char> __strings;
+    std::vector<int32_t> __offsets;
+    std::unordered_map<string, int32_t> __indice;
+    std::vector<int32_t> __pooled;
     
-#if FULL_CACHE_ENABLED
-    __sampler.begin("create_joints");
-    createJointTable();
+public:
+    void open(const char *filepath)
+    {
+        __fs.open(filepath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    }
+    
+    void close() { __fs.close(); }
+    
+    void write(const char *data, size_t size)
+    {
+        static const char zeros[8] = {0};
+        auto padding = (8 - __position % 8) % 8;
+        if (padding > 0) { __fs.write(zeros, (int32_t)padding); }
+        if (size > 0) { __fs.write(data, (int32_t)size); }
+        __position += padding + size;
+    }
+    
+    template <typename T>
+    void write(const T &v)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain data can be written to cache");
+        write((const char *)&v, sizeof(T));
+    }
+    
+    template <typename T, typename F>
+    void column(int32_t count, F value)
+    {
+        std::vector<T> items(count);
+        for (auto i = 0; i < count; i++) { items[i] = (T)value(i); }
+        write((const char *)items.data(), count * sizeof(T));
+    }
+    
+    // index in string table
+    int32_t intern(const string &s)
+    {
+        auto iter = __indice.find(s);
+        if (iter != __indice.end()) {return iter->second;}
+        auto index = (int32_t)__offsets.size();
+        __indice.insert(std::make_pair(s, index));
+        __offsets.push_back((int32_t)__strings.size());
+        __strings.insert(__strings.end(), s.begin(), s.end());
+        return index;
+    }
+    
+    // pooled names are unique per id already
+    int32_t intern(const PooledString &s)
+    {
+        if (s.id < 0) {return intern(string(s));}
+        if (s.id >= __pooled.size()) { __pooled.resize(s.id + 1, -1); }
+        if (__pooled[s.id] < 0) { __pooled[s.id] = intern(string(s)); }
+        return __pooled[s.id];
+    }
+    
+    void writeStrings()
+    {
+        write<int32_t>((int32_t)__offsets.size());
+        __offsets.push_back((int32_t)__strings.size());
+        write((const char *)__offsets.data(), __offsets.size() * sizeof(int32_t));
+        write(__strings.data(), __strings.size());
+        __offsets.pop_back();
+    }
+};
+
+// every read is checked against mapping size, once failed all further reads return nullptr
+class CacheReader
+{
+    const char *__data;
+    size_t __size;
+    size_t __position = 0;
+    const int32_t *__offsets = nullptr;
+    const char *__strings = nullptr;
+    int32_t __count = 0;
+    bool __failed = false;
+    
+public:
+    CacheReader(const MappedFile &mapping): __data(mapping.data()), __size(mapping.size()) {}
+    
+    bool failed() const { return __failed; }
+    bool fail() { __failed = true; return false; }
+    
+    // bytes left after current position
+    size_t available() const { return __failed || __position >= __size ? 0 : __size - __position; }
+    
+    const char *read(size_t size)
+    {
+        if (__failed) {return nullptr;}
+        auto position = __position + (8 - __position % 8) % 8;
+        if (position > __size || size > __size - position)
+        {
+            __failed = true;
+            return nullptr;
+        }
+        
+        __position = position + size;
+        return __data + position;
+    }
+    
+    template <typename T>
+    T read()
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain data can be read from cache");
+        T v{};
+        auto ptr = read(sizeof(T));
+        if (ptr != nullptr) { memcpy(&v, ptr, sizeof(T)); }
+        return v;
+    }
+    
+    // column items point into mapping
+    template <typename T>
+    const T *column(int32_t count)
+    {
+        if (count < 0) {__failed = true;}
+        return (const T *)read((size_t)count * sizeof(T));
+    }
+    
+    PooledString text(int32_t index, StringPool &strings)
+    {
+        if (__failed || index < 0 || index >= __count)
+        {
+            fail();
+            return PooledString();
+        }
+        return strings.intern(__strings + __offsets[index], __offsets[index + 1] - __offsets[index]);
+    }
+    
+    bool readStrings()
+    {
+        auto count = read<int32_t>();
+        if (count < 0 || count == INT32_MAX) {return fail();}
+        auto offsets = column<int32_t>(count + 1);
+        if (offsets == nullptr || offsets[0] != 0) {return fail();}
+        
+        // offsets must ascend so that any valid index maps into string bytes
+        for (auto i = 0; i < count; i++)
+        {
+            if (offsets[i + 1] < offsets[i]) {return fail();}
+        }
+        
+        auto strings = read(offsets[count]);
+        if (strings == nullptr) {return false;}
+        
+        __offsets = offsets;
+        __strings = strings;
+        __count = count;
+        return true;
+    }
+};
+
+// indice read from cache are used to index arrays directly, so every one must be in [lower, upper)
+template <typename T>
+static bool inRange(const T *column, int32_t count, int32_t lower, int32_t upper)
+{
+    for (auto i = 0; i < count; i++)
+    {
+        if (column[i] < lower || column[i] >= upper) {return false;}
+    }
+    return true;
+}
+
+// connection end must be a valid object of its kind
+static bool inRange(int32_t index, uint8_t kind, int32_t managedCount, int32_t nativeCount)
+{
+    if (kind > CK_link) {return false;}
+    if (index < 0) {return true;}
+    if (kind == CK_managed) {return index < managedCount;}
+    if (kind == CK_native) {return index < nativeCount;}
+    return true;
+}
+
+void SnapshotCrawlerCache::write(CacheWriter &writer, MemorySnapshotCrawler &crawler)
+{
+    auto &snapshot = *crawler.snapshot;
+    auto &nativeTypes = *snapshot.nativeTypes;
+    auto &nativeObjects = *snapshot.nativeObjects;
+    auto &types = *snapshot.typeDescriptions;
+    
+    __sampler.begin("write_strings");
+    for (auto i = 0; i < nativeTypes.size; i++) { writer.intern(nativeTypes[i].name); }
+    for (auto i = 0; i < nativeObjects.size; i++) { writer.intern(nativeObjects[i].name); }
+    std::vector<FieldDescription *> fields;
+    for (auto i = 0; i < types.size; i++)
+    {
+        auto &t = types[i];
+        writer.intern(t.name);
+        writer.intern(t.assembly);
+        if (t.fields == nullptr) {continue;}
+        for (auto n = 0; n < t.fields->size; n++)
+        {
+            fields.push_back(&t.fields->items[n]);
+            writer.intern(t.fields->items[n].name);
+        }
+    }
+    writer.writeStrings();
     __sampler.end();
     
-    __sampler.begin("create_connections");
-    createConnectionTable();
+    __sampler.begin("write_vm");
+    auto &vm = snapshot.virtualMachineInformation;
+    int32_t vmFields[VM_FIELD_COUNT] = {vm.allocationGranularity, vm.arrayBoundsOffsetInHeader, vm.arrayHeaderSize, vm.arraySizeOffsetInHeader,
+                                        vm.heapFormatVersion, vm.objectHeaderSize, vm.pointerSize};
+    writer.write((const char *)vmFields, sizeof(vmFields));
+    writer.write(snapshot.managedTypeIndex);
+    writer.write(snapshot.nativeTypeIndex);
     __sampler.end();
-#endif
     
-    __sampler.begin("create_objects");
-    createObjectTable();
+    __sampler.begin("write_native_types");
+    writer.write<int32_t>(nativeTypes.size);
+    writer.column<int32_t>(nativeTypes.size, [&](int32_t i) { return writer.intern(nativeTypes[i].name); });
+    writer.column<int32_t>(nativeTypes.size, [&](int32_t i) { return nativeTypes[i].nativeBaseTypeArrayIndex; });
+    writer.column<int32_t>(nativeTypes.size, [&](int32_t i) { return nativeTypes[i].baseClassId; });
+    writer.column<int32_t>(nativeTypes.size, [&](int32_t i) { return nativeTypes[i].typeIndex; });
+    writer.column<int32_t>(nativeTypes.size, [&](int32_t i) { return nativeTypes[i].managedTypeArrayIndex; });
+    writer.column<int32_t>(nativeTypes.size, [&](int32_t i) { return nativeTypes[i].instanceCount; });
+    writer.column<int32_t>(nativeTypes.size, [&](int32_t i) { return nativeTypes[i].instanceMemory; });
     __sampler.end();
     
-    __sampler.begin("insert_native_types");
-    insert(*crawler.snapshot->nativeTypes);
+    __sampler.begin("write_native_objects");
+    writer.write<int32_t>(nativeObjects.size);
+    writer.column<int32_t>(nativeObjects.size, [&](int32_t i) { return writer.intern(nativeObjects[i].name); });
+    writer.column<address_t>(nativeObjects.size, [&](int32_t i) { return nativeObjects[i].nativeObjectAddress; });
+    writer.column<int32_t>(nativeObjects.size, [&](int32_t i) { return nativeObjects[i].flags; });
+    writer.column<int32_t>(nativeObjects.size, [&](int32_t i) { return nativeObjects[i].hideFlags; });
+    writer.column<int32_t>(nativeObjects.size, [&](int32_t i) { return nativeObjects[i].instanceId; });
+    writer.column<int32_t>(nativeObjects.size, [&](int32_t i) { return nativeObjects[i].nativeTypeArrayIndex; });
+    writer.column<int32_t>(nativeObjects.size, [&](int32_t i) { return nativeObjects[i].size; });
+    writer.column<int32_t>(nativeObjects.size, [&](int32_t i) { return nativeObjects[i].classId; });
+    writer.column<int32_t>(nativeObjects.size, [&](int32_t i) { return nativeObjects[i].managedObjectArrayIndex; });
+    writer.column<int32_t>(nativeObjects.size, [&](int32_t i) { return nativeObjects[i].nativeObjectArrayIndex; });
+    writer.column<uint8_t>(nativeObjects.size, [&](int32_t i) { return nativeObjects[i].isDontDestroyOnLoad; });
+    writer.column<uint8_t>(nativeObjects.size, [&](int32_t i) { return nativeObjects[i].isManager; });
+    writer.column<uint8_t>(nativeObjects.size, [&](int32_t i) { return nativeObjects[i].isPersistent; });
     __sampler.end();
     
-    __sampler.begin("insert_native_objects");
-    insert(*crawler.snapshot->nativeObjects);
+    __sampler.begin("write_native_connections");
+    auto &nativeConnections = *snapshot.connections;
+    writer.write<int32_t>(nativeConnections.size);
+    writer.column<int32_t>(nativeConnections.size, [&](int32_t i) { return nativeConnections[i].from; });
+    writer.column<int32_t>(nativeConnections.size, [&](int32_t i) { return nativeConnections[i].to; });
+    writer.column<uint8_t>(nativeConnections.size, [&](int32_t i) { return nativeConnections[i].fromKind; });
+    writer.column<uint8_t>(nativeConnections.size, [&](int32_t i) { return nativeConnections[i].toKind; });
     __sampler.end();
     
-    __sampler.begin("insert_managed_types");
-    insert(*crawler.snapshot->typeDescriptions);
+    __sampler.begin("write_managed_types");
+    writer.write<int32_t>(types.size);
+    writer.column<int32_t>(types.size, [&](int32_t i) { return writer.intern(types[i].name); });
+    writer.column<int32_t>(types.size, [&](int32_t i) { return writer.intern(types[i].assembly); });
+    writer.column<address_t>(types.size, [&](int32_t i) { return types[i].typeInfoAddress; });
+    writer.column<int32_t>(types.size, [&](int32_t i) { return types[i].arrayRank; });
+    writer.column<int32_t>(types.size, [&](int32_t i) { return types[i].baseOrElementTypeIndex; });
+    writer.column<int32_t>(types.size, [&](int32_t i) { return types[i].size; });
+    writer.column<int32_t>(types.size, [&](int32_t i) { return types[i].typeIndex; });
+    writer.column<int32_t>(types.size, [&](int32_t i) { return types[i].instanceCount; });
+    writer.column<int32_t>(types.size, [&](int32_t i) { return types[i].instanceMemory; });
+    writer.column<int32_t>(types.size, [&](int32_t i) { return types[i].nativeMemory; });
+    writer.column<int32_t>(types.size, [&](int32_t i) { return types[i].nativeTypeArrayIndex; });
+    writer.column<uint8_t>(types.size, [&](int32_t i) { return types[i].isArray; });
+    writer.column<uint8_t>(types.size, [&](int32_t i) { return types[i].isValueType; });
+    writer.column<uint8_t>(types.size, [&](int32_t i) { return types[i].isUnityEngineObjectType; });
+    writer.column<int32_t>(types.size, [&](int32_t i) { return types[i].fields == nullptr ? -1 : types[i].fields->size; });
+    writer.column<int32_t>(types.size, [&](int32_t i) { return types[i].staticFieldBytes == nullptr ? -1 : types[i].staticFieldBytes->size; });
+    for (auto i = 0; i < types.size; i++)
+    {
+        auto bytes = types[i].staticFieldBytes;
+        if (bytes != nullptr) { writer.write((const char *)bytes->items, bytes->size); }
+    }
     __sampler.end();
     
-    __sampler.begin("remove_redundants");
-    removeRedundants(crawler);
+    __sampler.begin("write_type_fields");
+    auto fieldCount = (int32_t)fields.size();
+    writer.write<int32_t>(fieldCount);
+    writer.column<int32_t>(fieldCount, [&](int32_t i) { return writer.intern(fields[i]->name); });
+    writer.column<int32_t>(fieldCount, [&](int32_t i) { return fields[i]->offset; });
+    writer.column<int32_t>(fieldCount, [&](int32_t i) { return fields[i]->typeIndex; });
+    writer.column<int32_t>(fieldCount, [&](int32_t i) { return fields[i]->hookTypeIndex; });
+    writer.column<int16_t>(fieldCount, [&](int32_t i) { return fields[i]->fieldSlotIndex; });
+    writer.column<uint8_t>(fieldCount, [&](int32_t i) { return fields[i]->isStatic; });
     __sampler.end();
     
-#if FULL_CACHE_ENABLED
-    __sampler.begin("insert_joints");
-    insert(crawler.joints);
+    __sampler.begin("write_managed_objects");
+    auto &objects = crawler.managedObjects;
+    writer.write<int32_t>(objects.size());
+    writer.column<address_t>(objects.size(), [&](int32_t i) { return objects[i].address; });
+    writer.column<int32_t>(objects.size(), [&](int32_t i) { return objects[i].typeIndex; });
+    writer.column<int32_t>(objects.size(), [&](int32_t i) { return objects[i].managedObjectIndex; });
+    writer.column<int32_t>(objects.size(), [&](int32_t i) { return objects[i].nativeObjectIndex; });
+    writer.column<int32_t>(objects.size(), [&](int32_t i) { return objects[i].size; });
+    writer.column<int32_t>(objects.size(), [&](int32_t i) { return objects[i].nativeSize; });
+    writer.column<uint8_t>(objects.size(), [&](int32_t i) { return objects[i].isValueType; });
     __sampler.end();
     
-    __sampler.begin("insert_connections");
-    insert(crawler.connections);
+    __sampler.begin("write_joints");
+    auto &joints = crawler.joints;
+    writer.write<int32_t>(joints.size());
+    writer.column<address_t>(joints.size(), [&](int32_t i) { return joints[i].hookObjectAddress; });
+    writer.column<address_t>(joints.size(), [&](int32_t i) { return joints[i].fieldAddress; });
+    writer.column<int32_t>(joints.size(), [&](int32_t i) { return joints[i].gcHandleIndex; });
+    writer.column<int32_t>(joints.size(), [&](int32_t i) { return joints[i].hookTypeIndex; });
+    writer.column<int32_t>(joints.size(), [&](int32_t i) { return joints[i].hookObjectIndex; });
+    writer.column<int32_t>(joints.size(), [&](int32_t i) { return joints[i].linkArrayIndex; });
+    writer.column<int32_t>(joints.size(), [&](int32_t i) { return joints[i].fieldTypeIndex; });
+    writer.column<int32_t>(joints.size(), [&](int32_t i) { return joints[i].fieldSlotIndex; });
+    writer.column<int32_t>(joints.size(), [&](int32_t i) { return joints[i].fieldOffset; });
+    writer.column<int32_t>(joints.size(), [&](int32_t i) { return joints[i].managedArrayIndex; });
+    writer.column<int32_t>(joints.size(), [&](int32_t i) { return joints[i].elementArrayIndex; });
+    writer.column<int32_t>(joints.size(), [&](int32_t i) { return joints[i].jointArrayIndex; });
+    writer.column<uint8_t>(joints.size(), [&](int32_t i) { return joints[i].isStatic; });
+    writer.column<uint8_t>(joints.size(), [&](int32_t i) { return joints[i].isConnected; });
     __sampler.end();
-#endif
     
-    __sampler.begin("insert_objects");
-    insert(crawler.managedObjects);
+    __sampler.begin("write_connections");
+    auto &connections = crawler.connections;
+    writer.write<int32_t>(connections.size());
+    writer.column<int32_t>(connections.size(), [&](int32_t i) { return connections[i].connectionArrayIndex; });
+    writer.column<int32_t>(connections.size(), [&](int32_t i) { return connections[i].from; });
+    writer.column<int32_t>(connections.size(), [&](int32_t i) { return connections[i].to; });
+    writer.column<int32_t>(connections.size(), [&](int32_t i) { return connections[i].jointArrayIndex; });
+    writer.column<uint8_t>(connections.size(), [&](int32_t i) { return connections[i].fromKind; });
+    writer.column<uint8_t>(connections.size(), [&](int32_t i) { return connections[i].toKind; });
     __sampler.end();
+}
 
-    __sampler.begin("insert_vm");
-    createVMTable();
-    insertVMTable(crawler.snapshot->virtualMachineInformation);
+bool SnapshotCrawlerCache::read(CacheReader &reader, MemorySnapshotCrawler &crawler)
+{
+    auto &snapshot = *crawler.snapshot;
+    
+    __sampler.begin("read_strings");
+    auto success = reader.readStrings();
+    __sampler.end();
+    if (!success) {return false;}
+    
+    __sampler.begin("read_vm");
+    {
+        auto fields = reader.column<int32_t>(VM_FIELD_COUNT);
+        if (fields == nullptr) {__sampler.end(); return false;}
+        auto &vm = snapshot.virtualMachineInformation;
+        vm.allocationGranularity = fields[0];
+        vm.arrayBoundsOffsetInHeader = fields[1];
+        vm.arrayHeaderSize = fields[2];
+        vm.arraySizeOffsetInHeader = fields[3];
+        vm.heapFormatVersion = fields[4];
+        vm.objectHeaderSize = fields[5];
+        vm.pointerSize = fields[6];
+    }
+    snapshot.managedTypeIndex = reader.read<ManagedTypeIndex>();
+    snapshot.nativeTypeIndex = reader.read<NativeTypeIndex>();
+    __sampler.end();
+    if (reader.failed()) {return false;}
+    
+    __sampler.begin("read_native_types");
+    {
+        auto count = reader.read<int32_t>();
+        auto name = reader.column<int32_t>(count);
+        auto nativeBaseTypeArrayIndex = reader.column<int32_t>(count);
+        auto baseClassId = reader.column<int32_t>(count);
+        auto typeIndex = reader.column<int32_t>(count);
+        auto managedTypeArrayIndex = reader.column<int32_t>(count);
+        auto instanceCount = reader.column<int32_t>(count);
+        auto instanceMemory = reader.column<int32_t>(count);
+        if (reader.failed() || !inRange(nativeBaseTypeArrayIndex, count, -1, count)) {__sampler.end(); return false;}
+        
+        snapshot.nativeTypes = Array<PackedNativeType>::create(snapshot.arena, count);
+        for (auto i = 0; i < count; i++)
+        {
+            auto &nt = snapshot.nativeTypes->items[i];
+            nt.name = reader.text(name[i], snapshot.strings);
+            nt.nativeBaseTypeArrayIndex = nativeBaseTypeArrayIndex[i];
+            nt.baseClassId = baseClassId[i];
+            nt.typeIndex = typeIndex[i];
+            nt.managedTypeArrayIndex = managedTypeArrayIndex[i];
+            nt.instanceCount = instanceCount[i];
+            nt.instanceMemory = instanceMemory[i];
+        }
+    }
+    __sampler.end();
+    if (reader.failed()) {return false;}
+    
+    __sampler.begin("read_native_objects");
+    {
+        auto count = reader.read<int32_t>();
+        auto name = reader.column<int32_t>(count);
+        auto nativeObjectAddress = reader.column<address_t>(count);
+        auto flags = reader.column<int32_t>(count);
+        auto hideFlags = reader.column<int32_t>(count);
+        auto instanceId = reader.column<int32_t>(count);
+        auto nativeTypeArrayIndex = reader.column<int32_t>(count);
+        auto size = reader.column<int32_t>(count);
+        auto classId = reader.column<int32_t>(count);
+        auto managedObjectArrayIndex = reader.column<int32_t>(count);
+        auto nativeObjectArrayIndex = reader.column<int32_t>(count);
+        auto isDontDestroyOnLoad = reader.column<uint8_t>(count);
+        auto isManager = reader.column<uint8_t>(count);
+        auto isPersistent = reader.column<uint8_t>(count);
+        if (reader.failed()
+            || !inRange(nativeTypeArrayIndex, count, -1, snapshot.nativeTypes->size)
+            || !inRange(nativeObjectArrayIndex, count, -1, count)) {__sampler.end(); return false;}
+        
+        snapshot.nativeObjects = Array<PackedNativeUnityEngineObject>::create(snapshot.arena, count);
+        for (auto i = 0; i < count; i++)
+        {
+            auto &no = snapshot.nativeObjects->items[i];
+            no.name = reader.text(name[i], snapshot.strings);
+            no.nativeObjectAddress = nativeObjectAddress[i];
+            no.flags = flags[i];
+            no.hideFlags = hideFlags[i];
+            no.instanceId = instanceId[i];
+            no.nativeTypeArrayIndex = nativeTypeArrayIndex[i];
+            no.size = size[i];
+            no.classId = classId[i];
+            no.managedObjectArrayIndex = managedObjectArrayIndex[i];
+            no.nativeObjectArrayIndex = nativeObjectArrayIndex[i];
+            no.isDontDestroyOnLoad = isDontDestroyOnLoad[i] != 0;
+            no.isManager = isManager[i] != 0;
+            no.isPersistent = isPersistent[i] != 0;
+        }
+    }
     __sampler.end();
+    if (reader.failed()) {return false;}
     
-    __sampler.begin("insert_strings");
-    createStringTable();
-    insertStringTable(crawler);
+    __sampler.begin("read_native_connections");
+    {
+        auto count = reader.read<int32_t>();
+        auto from = reader.column<int32_t>(count);
+        auto to = reader.column<int32_t>(count);
+        auto fromKind = reader.column<uint8_t>(count);
+        auto toKind = reader.column<uint8_t>(count);
+        if (reader.failed()) {__sampler.end(); return false;}
+        
+        // managed objects are not read yet, native connections only link native objects
+        auto nativeCount = snapshot.nativeObjects->size;
+        for (auto i = 0; i < count; i++)
+        {
+            if (!inRange(from[i], fromKind[i], 0, nativeCount) || !inRange(to[i], toKind[i], 0, nativeCount))
+            {
+                __sampler.end();
+                return false;
+            }
+        }
+        
+        snapshot.connections = Array<Connection>::create(snapshot.arena, count);
+        for (auto i = 0; i < count; i++)
+        {
+            auto &nc = snapshot.connections->items[i];
+            nc.connectionArrayIndex = i;
+            nc.from = from[i];
+            nc.to = to[i];
+            nc.fromKind = (ConnectionKind)fromKind[i];
+            nc.toKind = (ConnectionKind)toKind[i];
+            crawler.tryAcceptConnection(nc);
+        }
+    }
     __sampler.end();
+    if (reader.failed()) {return false;}
+    
+    __sampler.begin("read_managed_types");
+    {
+        auto count = reader.read<int32_t>();
+        auto name = reader.column<int32_t>(count);
+        auto assembly = reader.column<int32_t>(count);
+        auto typeInfoAddress = reader.column<address_t>(count);
+        auto arrayRank = reader.column<int32_t>(count);
+        auto baseOrElementTypeIndex = reader.column<int32_t>(count);
+        auto size = reader.column<int32_t>(count);
+        auto typeIndex = reader.column<int32_t>(count);
+        auto instanceCount = reader.column<int32_t>(count);
+        auto instanceMemory = reader.column<int32_t>(count);
+        auto nativeMemory = reader.column<int32_t>(count);
+        auto nativeTypeArrayIndex = reader.column<int32_t>(count);
+        auto isArray = reader.column<uint8_t>(count);
+        auto isValueType = reader.column<uint8_t>(count);
+        auto isUnityEngineObjectType = reader.column<uint8_t>(count);
+        auto fieldCount = reader.column<int32_t>(count);
+        auto staticFieldSize = reader.column<int32_t>(count);
+        auto &nativeTypes = *snapshot.nativeTypes;
+        if (reader.failed()
+            || !inRange(baseOrElementTypeIndex, count, -1, count)
+            || !inRange(typeIndex, count, 0, count)
+            || !inRange(nativeTypeArrayIndex, count, -1, nativeTypes.size)) {__sampler.end(); return false;}
+        
+        for (auto i = 0; i < nativeTypes.size; i++)
+        {
+            if (nativeTypes[i].managedTypeArrayIndex < -1 || nativeTypes[i].managedTypeArrayIndex >= count) {__sampler.end(); return false;}
+        }
+        
+        // fields and static bytes are allocated before they are read, so their sizes can not exceed what is left in cache
+        size_t fieldTotal = 0, staticTotal = 0;
+        for (auto i = 0; i < count; i++)
+        {
+            if (fieldCount[i] < -1 || staticFieldSize[i] < -1) {__sampler.end(); return false;}
+            if (fieldCount[i] > 0) { fieldTotal += fieldCount[i]; }
+            if (staticFieldSize[i] > 0) { staticTotal += staticFieldSize[i]; }
+        }
+        if (fieldTotal > reader.available() || staticTotal > reader.available()) {__sampler.end(); return false;}
+        
+        snapshot.typeDescriptions = Array<TypeDescription>::create(snapshot.arena, count);
+        for (auto i = 0; i < count; i++)
+        {
+            auto &mt = snapshot.typeDescriptions->items[i];
+            mt.name = reader.text(name[i], snapshot.strings);
+            mt.assembly = reader.text(assembly[i], snapshot.strings);
+            mt.typeInfoAddress = typeInfoAddress[i];
+            mt.arrayRank = arrayRank[i];
+            mt.baseOrElementTypeIndex = baseOrElementTypeIndex[i];
+            mt.size = size[i];
+            mt.typeIndex = typeIndex[i];
+            mt.instanceCount = instanceCount[i];
+            mt.instanceMemory = instanceMemory[i];
+            mt.nativeMemory = nativeMemory[i];
+            mt.nativeTypeArrayIndex = nativeTypeArrayIndex[i];
+            mt.isArray = isArray[i] != 0;
+            mt.isValueType = isValueType[i] != 0;
+            mt.isUnityEngineObjectType = isUnityEngineObjectType[i] != 0;
+            if (fieldCount[i] >= 0) { mt.fields = Array<FieldDescription>::create(snapshot.arena, fieldCount[i]); }
+            if (staticFieldSize[i] >= 0)
+            {
+                mt.staticFieldBytes = Array<byte_t>::create(snapshot.arena, staticFieldSize[i]);
+            }
+        }
+        
+        for (auto i = 0; i < count; i++)
+        {
+            auto bytes = snapshot.typeDescriptions->items[i].staticFieldBytes;
+            if (bytes == nullptr) {continue;}
+            auto data = reader.read(bytes->size);
+            if (data == nullptr) {__sampler.end(); return false;}
+            memcpy(bytes->items, data, bytes->size);
+        }
+    }
+    __sampler.end();
+    if (reader.failed()) {return false;}
+    
+    __sampler.begin("read_type_fields");
+    {
+        auto count = reader.read<int32_t>();
+        auto name = reader.column<int32_t>(count);
+        auto offset = reader.column<int32_t>(count);
+        auto typeIndex = reader.column<int32_t>(count);
+        auto hookTypeIndex = reader.column<int32_t>(count);
+        auto fieldSlotIndex = reader.column<int16_t>(count);
+        auto isStatic = reader.column<uint8_t>(count);
+        auto &types = *snapshot.typeDescriptions;
+        if (reader.failed()
+            || !inRange(typeIndex, count, 0, types.size)
+            || !inRange(hookTypeIndex, count, -1, types.size)) {__sampler.end(); return false;}
+        
+        auto n = 0;
+        for (auto i = 0; i < types.size; i++)
+        {
+            auto fields = types[i].fields;
+            if (fields == nullptr) {continue;}
+            for (auto m = 0; m < fields->size; m++, n++)
+            {
+                if (n >= count || fieldSlotIndex[n] < -1 || fieldSlotIndex[n] >= fields->size) {__sampler.end(); return false;}
+                auto &field = fields->items[m];
+                field.name = reader.text(name[n], snapshot.strings);
+                field.offset = offset[n];
+                field.typeIndex = typeIndex[n];
+                field.hookTypeIndex = hookTypeIndex[n];
+                field.fieldSlotIndex = fieldSlotIndex[n];
+                field.isStatic = isStatic[n] != 0;
+            }
+        }
+        if (n != count) {__sampler.end(); return false;}
+    }
+    __sampler.end();
+    if (reader.failed()) {return false;}
+    
+    __sampler.begin("read_managed_objects");
+    {
+        auto count = reader.read<int32_t>();
+        auto address = reader.column<address_t>(count);
+        auto typeIndex = reader.column<int32_t>(count);
+        auto managedObjectIndex = reader.column<int32_t>(count);
+        auto nativeObjectIndex = reader.column<int32_t>(count);
+        auto size = reader.column<int32_t>(count);
+        auto nativeSize = reader.column<int32_t>(count);
+        auto isValueType = reader.column<uint8_t>(count);
+        auto &nativeObjects = *snapshot.nativeObjects;
+        if (reader.failed()
+            || !inRange(typeIndex, count, 0, snapshot.typeDescriptions->size)
+            || !inRange(managedObjectIndex, count, 0, count)
+            || !inRange(nativeObjectIndex, count, -1, nativeObjects.size)) {__sampler.end(); return false;}
+        
+        for (auto i = 0; i < nativeObjects.size; i++)
+        {
+            if (nativeObjects[i].managedObjectArrayIndex < -1 || nativeObjects[i].managedObjectArrayIndex >= count) {__sampler.end(); return false;}
+        }
+        
+        for (auto i = 0; i < count; i++)
+        {
+            auto &mo = crawler.managedObjects.add();
+            mo.address = address[i];
+            mo.typeIndex = typeIndex[i];
+            mo.managedObjectIndex = managedObjectIndex[i];
+            mo.nativeObjectIndex = nativeObjectIndex[i];
+            mo.size = size[i];
+            mo.nativeSize = nativeSize[i];
+            mo.isValueType = isValueType[i] != 0;
+        }
+    }
+    __sampler.end();
+    if (reader.failed()) {return false;}
+    
+    __sampler.begin("read_joints");
+    {
+        auto count = reader.read<int32_t>();
+        auto hookObjectAddress = reader.column<address_t>(count);
+        auto fieldAddress = reader.column<address_t>(count);
+        auto gcHandleIndex = reader.column<int32_t>(count);
+        auto hookTypeIndex = reader.column<int32_t>(count);
+        auto hookObjectIndex = reader.column<int32_t>(count);
+        auto linkArrayIndex = reader.column<int32_t>(count);
+        auto fieldTypeIndex = reader.column<int32_t>(count);
+        auto fieldSlotIndex = reader.column<int32_t>(count);
+        auto fieldOffset = reader.column<int32_t>(count);
+        auto managedArrayIndex = reader.column<int32_t>(count);
+        auto elementArrayIndex = reader.column<int32_t>(count);
+        auto jointArrayIndex = reader.column<int32_t>(count);
+        auto isStatic = reader.column<uint8_t>(count);
+        auto isConnected = reader.column<uint8_t>(count);
+        auto &types = *snapshot.typeDescriptions;
+        auto objectCount = crawler.managedObjects.size();
+        if (reader.failed()
+            || !inRange(hookTypeIndex, count, -1, types.size)
+            || !inRange(fieldTypeIndex, count, -1, types.size)
+            || !inRange(hookObjectIndex, count, -1, objectCount)
+            || !inRange(managedArrayIndex, count, -1, objectCount)
+            || !inRange(jointArrayIndex, count, -1, count)) {__sampler.end(); return false;}
+        
+        // field slot indexes fields of hook type
+        for (auto i = 0; i < count; i++)
+        {
+            if (fieldSlotIndex[i] < 0) {continue;}
+            auto fields = hookTypeIndex[i] >= 0 ? types[hookTypeIndex[i]].fields : nullptr;
+            if (fields == nullptr || fieldSlotIndex[i] >= fields->size) {__sampler.end(); return false;}
+        }
+        
+        for (auto i = 0; i < count; i++)
+        {
+            auto &ej = crawler.joints.add();
+            ej.hookObjectAddress = hookObjectAddress[i];
+            ej.fieldAddress = fieldAddress[i];
+            ej.gcHandleIndex = gcHandleIndex[i];
+            ej.hookTypeIndex = hookTypeIndex[i];
+            ej.hookObjectIndex = hookObjectIndex[i];
+            ej.linkArrayIndex = linkArrayIndex[i];
+            ej.fieldTypeIndex = fieldTypeIndex[i];
+            ej.fieldSlotIndex = fieldSlotIndex[i];
+            ej.fieldOffset = fieldOffset[i];
+            ej.managedArrayIndex = managedArrayIndex[i];
+            ej.elementArrayIndex = elementArrayIndex[i];
+            ej.jointArrayIndex = jointArrayIndex[i];
+            ej.isStatic = isStatic[i] != 0;
+            ej.isConnected = isConnected[i] != 0;
+        }
+    }
+    __sampler.end();
+    if (reader.failed()) {return false;}
+    
+    __sampler.begin("read_connections");
+    {
+        auto count = reader.read<int32_t>();
+        auto connectionArrayIndex = reader.column<int32_t>(count);
+        auto from = reader.column<int32_t>(count);
+        auto to = reader.column<int32_t>(count);
+        auto jointArrayIndex = reader.column<int32_t>(count);
+        auto fromKind = reader.column<uint8_t>(count);
+        auto toKind = reader.column<uint8_t>(count);
+        auto objectCount = crawler.managedObjects.size();
+        auto nativeCount = snapshot.nativeObjects->size;
+        if (reader.failed()
+            || !inRange(connectionArrayIndex, count, 0, count)
+            || !inRange(jointArrayIndex, count, -1, crawler.joints.size())) {__sampler.end(); return false;}
+        
+        for (auto i = 0; i < count; i++)
+        {
+            if (!inRange(from[i], fromKind[i], objectCount, nativeCount) || !inRange(to[i], toKind[i], objectCount, nativeCount))
+            {
+                __sampler.end();
+                return false;
+            }
+        }
+        
+        for (auto i = 0; i < count; i++)
+        {
+            auto &ec = crawler.connections.add();
+            ec.connectionArrayIndex = connectionArrayIndex[i];
+            ec.from = from[i];
+            ec.to = to[i];
+            ec.jointArrayIndex = jointArrayIndex[i];
+            ec.fromKind = (ConnectionKind)fromKind[i];
+            ec.toKind = (ConnectionKind)toKind[i];
+            crawler.tryAcceptConnection(ec);
+        }
+    }
+    __sampler.end();
+    if (reader.failed()) {return false;}
+    
+    crawler.buildManagedGraph();
+    return true;
+}
+
+void SnapshotCrawlerCache::save(MemorySnapshotCrawler &crawler)
+{
+    if (crawler.snapshot->uuid == string()) {return;}
+    
+    __sampler.begin("SnapshotCrawlerCache::save");
+    mkdir(__workspace, 0777);
+    
+    char filepath[256];
+    sprintf(filepath, "%s/%s.mcc", __workspace, crawler.snapshot->uuid.c_str());
+    
+    CacheWriter writer;
+    writer.open(filepath);
+    writer.write<uint32_t>(MAGIC);
+    writer.write<uint32_t>(VERSION);
+    write(writer, crawler);
+    writer.close();
     
     __sampler.end();
     
@@ -675,6 +1528,51 @@ void SnapshotCrawlerCache::save(MemorySnapshotCrawler &crawler)
     __sampler.summarize();
 }
 
+void SnapshotCrawlerCache::read(const char *uuid, MemorySnapshotCrawler *crawler)
+{
+    char filepath[256];
+    sprintf(filepath, "%s/%s.mcc", __workspace, uuid);
+    
+    MappedFile mapping;
+    if (mapping.open(filepath))
+    {
+        __sampler.begin("SnapshotCrawlerCache::read");
+        CacheReader reader(mapping);
+        auto success = reader.read<uint32_t>() == MAGIC && reader.read<uint32_t>() == VERSION && read(reader, *crawler);
+        __sampler.end();
+        
+        if (success)
+        {
+            crawler->snapshot->uuid = uuid;
+            __sampler.end();
+            __sampler.summarize();
+            return;
+        }
+        
+        // treat incompatible or damaged cache as a miss, drop what was read before falling back
+        printf("\e[33mcache of %s is incompatible or damaged\e[0m\n", uuid);
+        auto nativeObjects = crawler->snapshot->nativeObjects;
+        for (auto i = 0; nativeObjects != nullptr && i < nativeObjects->size; i++)
+        {
+            std::vector<int32_t>().swap(nativeObjects->items[i].fromConnections);
+            std::vector<int32_t>().swap(nativeObjects->items[i].toConnections);
+        }
+        crawler->managedObjects.clear();
+        crawler->joints.clear();
+        crawler->connections.clear();
+        crawler->managedGraph.clear();
+        crawler->dominatorTree.clear();
+        crawler->snapshot->connections = nullptr;
+        crawler->snapshot->managedTypeIndex = ManagedTypeIndex();
+        crawler->snapshot->nativeTypeIndex = NativeTypeIndex();
+    }
+    
+    struct stat st;
+    sprintf(filepath, "%s/%s.db", __workspace, uuid);
+    if (stat(filepath, &st) == 0) { readDatabase(uuid, crawler); }
+    else { printf("\e[31mcache of %s not found\e[0m\n", uuid); }
+}
+
 SnapshotCrawlerCache::~SnapshotCrawlerCache()
 {
     if (__database != nullptr)
@@ -15,6 +15,9 @@
 #include "crawler.h"
 #include "perf.h"
 
+class CacheWriter;
+class CacheReader;
+
 class SnapshotCrawlerCache
 {
     char __buffer[32*1024];
@@ -25,73 +28,37 @@ class SnapshotCrawlerCache
 public:
     SnapshotCrawlerCache();
     void open(const char *filepath);
+    
+    // binary columnar cache at __cpp_cache/{uuid}.mcc, falls back to sqlite database on read
     void save(MemorySnapshotCrawler &crawler);
     void read(const char *uuid, MemorySnapshotCrawler *crawler);
+    
+    // sqlite database at __cpp_cache/{uuid}.db for ad-hoc queries
+    void saveDatabase(MemorySnapshotCrawler &crawler);
+    void readDatabase(const char *uuid, MemorySnapshotCrawler *crawler);
     ~SnapshotCrawlerCache();
     
 private:
-    void createNativeTypeTable();
-    void insert(Array<PackedNativeType> &nativeTypes);
-    void createNativeObjectTable();
-    void insert(Array<PackedNativeUnityEngineObject> &nativeObjects);
-    void createTypeTable();
-    void createFieldTable();
-    void insert(Array<TypeDescription> &types);
-    void createJointTable();
-    void insert(InstanceManager<EntityJoint> &joints);
-    void createConnectionTable();
-    void insert(InstanceManager<EntityConnection> &connections);
-    void createObjectTable();
-    void insert(InstanceManager<ManagedObject> &objects);
+    static constexpr uint32_t MAGIC = 0x43434D4D; // MMCC
+    static constexpr uint32_t VERSION = 1;
+    static constexpr int32_t VM_FIELD_COUNT = 7;
     
-    void createVMTable();
-    void insertVMTable(VirtualMachineInformation &vm);
-    
-    void createStringTable();
-    void insertStringTable(MemorySnapshotCrawler &crawler);
-    
-    template <typename T>
-    void insert(const char * sql, InstanceManager<T> &manager, std::function<void(T &item, sqlite3_stmt *stmt)> eachcall);
+    void write(CacheWriter &writer, MemorySnapshotCrawler &crawler);
+    bool read(CacheReader &reader, MemorySnapshotCrawler &crawler);
     
     template <typename T>
     void select(const char * sql, int32_t size, InstanceManager<T> &manager, std::function<void(T &item, sqlite3_stmt *stmt)> eachcall);
     
-    template <typename T>
-    void insert(const char * sql, Array<T> &array, std::function<bool(T &item, sqlite3_stmt *stmt)> eachcall);
-    
     template <typename T>
     void select(const char * sql, Array<T> &array, std::function<void(T &item, sqlite3_stmt *stmt)> eachcall);
     
     void select(const char * sql, int32_t size, std::function<void(sqlite3_stmt *stmt)> eachcall);
     
-    void create(const char *sql);
     int32_t selectCount(const char *name);
     
     void removeRedundants(MemorySnapshotCrawler &crawler);
 };
 
-template <typename T>
-void SnapshotCrawlerCache::insert(const char * sql, Array<T> &array, std::function<bool(T &item, sqlite3_stmt *stmt)> eachcall)
-{
-    char *errmsg;
-    sqlite3_stmt *stmt;
-    
-    sqlite3_exec(__database, "BEGIN TRANSACTION", nullptr, nullptr, &errmsg);
-    sqlite3_prepare_v2(__database, sql, (int)strlen(sql), &stmt, nullptr);
-    
-    for (auto i = 0; i < array.size; i++)
-    {
-        if (eachcall(array[i], stmt))
-        {
-            if (sqlite3_step(stmt) != SQLITE_DONE) {}
-            sqlite3_reset(stmt);
-        }
-    }
-    
-    sqlite3_exec(__database, "COMMIT TRANSACTION", nullptr, nullptr, &errmsg);
-    sqlite3_finalize(stmt);
-}
-
 template <typename T>
 void SnapshotCrawlerCache::select(const char * sql, Array<T> &array, std::function<void(T &item, sqlite3_stmt *stmt)> eachcall)
 {
@@ -107,27 +74,6 @@ void SnapshotCrawlerCache::select(const char * sql, Array<T> &array, std::functi
     sqlite3_finalize(stmt);
 }
 
-template <typename T>
-void SnapshotCrawlerCache::insert(const char * sql, InstanceManager<T> &manager, std::function<void(T &item, sqlite3_stmt *stmt)> eachcall)
-{
-    char *errmsg;
-    sqlite3_stmt *stmt;
-    
-    sqlite3_exec(__database, "BEGIN TRANSACTION", nullptr, nullptr, &errmsg);
-    sqlite3_prepare_v2(__database, sql, (int)strlen(sql), &stmt, nullptr);
-    
-    for (auto i = 0; i < manager.size(); i++)
-    {
-        eachcall(manager[i], stmt);
-        
-        if (sqlite3_step(stmt) != SQLITE_DONE) {}
-        sqlite3_reset(stmt);
-    }
-    
-    sqlite3_exec(__database, "COMMIT TRANSACTION", nullptr, nullptr, &errmsg);
-    sqlite3_finalize(stmt);
-}
-
 template <typename T>
 void SnapshotCrawlerCache::select(const char * sql, int32_t size, InstanceManager<T> &manager, std::function<void(T &item, sqlite3_stmt *stmt)> eachcall)
 {
@@ -10,19 +10,37 @@
 
 std::string comma(uint64_t v, uint32_t width = 0);
 
-MemorySnapshotCrawler::MemorySnapshotCrawler()
+constexpr int64_t MemorySnapshotCrawler::CRAWL_BACKLOG_LIMIT;
+
+MemorySnapshotCrawler::MemorySnapshotCrawler(): __crawlingBacklog(0), __crawlingStopped(false)
 {
     
 }
 
-MemorySnapshotCrawler &MemorySnapshotCrawler::crawl()
+MemorySnapshotCrawler &MemorySnapshotCrawler::crawl(int32_t concurrency)
 {
+    if (concurrency <= 0) {concurrency = (int32_t)std::thread::hardware_concurrency();}
+    
     __sampler.begin("MemorySnapshotCrawler");
     prepare();
+    if (concurrency > 1)
+    {
+        startParallelCrawling(concurrency);
+    }
     crawlGCHandles();
     crawlStatic();
     crawlLinks();
+    if (concurrency > 1)
+    {
+        stopParallelCrawling();
+    }
+    buildManagedGraph();
+    std::vector<CrawlEntry>().swap(__crawlingEntries);
+    std::vector<CrawlFrame>().swap(__crawlingFrames);
     summarize();
+    char note[64];
+    snprintf(note, sizeof(note), " vtables=%d", __vtableTypeCache.size());
+    __sampler.annotate(__memoryReader->stats().summary() + " " + __memoryReader->resolveStats().summary() + note);
     __sampler.end();
 #if PERF_DEBUG
     __sampler.summarize();
@@ -79,6 +97,9 @@ void MemorySnapshotCrawler::summarize()
 void MemorySnapshotCrawler::prepare()
 {
     __sampler.begin("Prepare");
+    __sampler.begin("InitTypeHierarchy");
+    buildTypeHierarchy();
+    __sampler.end();
     __sampler.begin("InitManagedTypes");
     Array<TypeDescription> &typeDescriptions = *snapshot->typeDescriptions;
     for (auto i = 0; i < typeDescriptions.size; i++)
@@ -87,6 +108,28 @@ void MemorySnapshotCrawler::prepare()
         type.isUnityEngineObjectType = deriveFromMType(type, snapshot->managedTypeIndex.unityengine_Object);
     }
     __sampler.end();
+    __sampler.begin("InitTypeAddressMap");
+    if (typeDescriptions.size > 0)
+    {
+        findTypeAtTypeAddress(typeDescriptions[0].typeInfoAddress);
+    }
+    __vtableTypeCache.reset(4 * typeDescriptions.size);
+    auto &heapSections = *snapshot->sortedHeapSections;
+    for (auto iter = heapSections.begin(); iter != heapSections.end(); iter++)
+    {
+        auto &section = **iter;
+        if (section.bytes == nullptr) {continue;}
+        auto stopAddress = section.startAddress + section.bytes->size;
+        if (__heapStopAddress == 0 || section.startAddress < __heapStartAddress) { __heapStartAddress = section.startAddress; }
+        if (stopAddress > __heapStopAddress) { __heapStopAddress = stopAddress; }
+    }
+    __sampler.end();
+    __sampler.begin("InitReferenceMaps");
+    compileReferenceMaps();
+    char note[64];
+    snprintf(note, sizeof(note), "slots=%zu", __referenceSlots.size());
+    __sampler.annotate(note);
+    __sampler.end();
     __sampler.begin("InitNativeConnections");
     
     auto offset = snapshot->gcHandles->size;
@@ -124,102 +167,79 @@ void MemorySnapshotCrawler::prepare()
 
 void MemorySnapshotCrawler::compare(MemorySnapshotCrawler &crawler)
 {
-    map<address_t, int64_t> container;
+    SnapshotBaseline baseline;
+    baseline.capture(crawler);
+    compare(baseline);
+}
+
+void MemorySnapshotCrawler::compare(SnapshotBaseline &baseline)
+{
+    __sampler.begin("CompareSnapshots");
+    SnapshotBaseline current;
+    current.capture(*this);
+    __diff.uuid = baseline.uuid;
     
     // Compare managed objects
-    for (auto i = 0; i < crawler.managedObjects.size(); i++)
-    {
-        auto &mo = crawler.managedObjects[i];
-        if (!mo.isValueType)
-        {
-            auto &type = crawler.snapshot->typeDescriptions->items[mo.typeIndex];
-            container.insert(pair<address_t, int64_t>(mo.address, type.typeInfoAddress));
-        }
-    }
-    
-    for (auto i = 0; i < managedObjects.size(); i++)
-    {
-        auto &mo = managedObjects[i];
-        if (!mo.isValueType)
-        {
-            auto &type = snapshot->typeDescriptions->items[mo.typeIndex];
-            auto iter = container.find(mo.address);
-            mo.state = (iter == container.end() || iter->second != type.typeInfoAddress)? MS_allocated : MS_persistent;
-        }
-        else
-        {
-            mo.state = MS_none;
-        }
-    }
+    std::vector<MemoryState> states;
+    for (auto i = 0; i < managedObjects.size(); i++) { managedObjects[i].state = MS_none; }
+    SnapshotDiff::merge(current.managed, baseline.managed, __diff.managed, states);
+    for (auto i = 0; i < states.size(); i++) { managedObjects[current.managed.indice[i]].state = states[i]; }
     
     // Compare native objects
-    container.clear();
-    for (auto i = 0; i < crawler.snapshot->nativeObjects->size; i++)
+    SnapshotDiff::merge(current.native, baseline.native, __diff.native, states);
+    for (auto i = 0; i < states.size(); i++) { snapshot->nativeObjects->items[current.native.indice[i]].state = states[i]; }
+    
+    // Compare Memory
+    SnapshotDiff::merge(current.sections, baseline.sections, __concations);
+    __sampler.end();
+}
+
+void MemorySnapshotCrawler::dumpDiff(int32_t rank)
+{
+    if (__diff.empty())
     {
-        auto &no = crawler.snapshot->nativeObjects->items[i];
-        container.insert(pair<address_t, int32_t>(no.nativeObjectAddress, no.nativeTypeArrayIndex));
+        printf("\e[31mno snapshot compared yet\e[0m\n");
+        return;
     }
     
-    for (auto i = 0; i < snapshot->nativeObjects->size; i++)
+    printf("\e[37m%s => %s\e[0m\n", __diff.uuid.c_str(), snapshot->uuid.c_str());
+    auto dump = [&](const char *kind, ObjectDelta &delta)
     {
-        auto &no = snapshot->nativeObjects->items[i];
-        auto iter = container.find(no.nativeObjectAddress);
+        printf("\e[36m[%s] \e[32mnew=%d %s \e[31mfreed=%d %s \e[33msurvived=%d %s\e[0m\n", kind,
+               delta.allocatedCount, comma(delta.allocatedMemory).c_str(),
+               delta.freedCount, comma(delta.freedMemory).c_str(),
+               delta.survivedCount, comma(delta.survivedMemory).c_str());
         
-        if (iter == container.end())
+        vector<TypeDelta *> types;
+        for (auto iter = delta.types.begin(); iter != delta.types.end(); iter++)
         {
-            no.state = MS_allocated;
+            if (iter->count[0] != iter->count[1] || iter->memory[0] != iter->memory[1]) {types.push_back(&*iter);}
         }
-        else
+        
+        auto count = rank <= 0 ? types.size() : std::min<size_t>(rank, types.size());
+        std::partial_sort(types.begin(), types.begin() + count, types.end(), [](TypeDelta *a, TypeDelta *b)
+                          {
+                              auto da = std::abs(a->memory[1] - a->memory[0]);
+                              auto db = std::abs(b->memory[1] - b->memory[0]);
+                              return da != db ? da > db : a->name < b->name;
+                          });
+        for (auto i = 0; i < count; i++)
         {
-            auto &typeA = crawler.snapshot->nativeTypes->items[iter->second];
-            auto &typeB = snapshot->nativeTypes->items[no.nativeTypeArrayIndex];
-            no.state = typeA.name == typeB.name ? MS_persistent : MS_allocated;
+            auto t = types[i];
+            auto memory = t->memory[1] - t->memory[0];
+            printf("    \e[%dm%c%s \e[90m%+d \e[32m%s \e[90m%s => %s\e[0m\n", memory >= 0 ? 33 : 36, memory >= 0 ? '+' : '-',
+                   comma(std::abs(memory)).c_str(), t->count[1] - t->count[0], t->name.c_str(),
+                   comma(t->memory[0]).c_str(), comma(t->memory[1]).c_str());
         }
-    }
+    };
     
-    // Compare Memory
-    __concations.clear();
-    auto &sections = *snapshot->sortedHeapSections;
-    auto &referSections = *crawler.snapshot->sortedHeapSections;
-    auto position = 0;
-    for (auto i = 0; i < sections.size(); i++)
-    {
-        auto s = sections[i];
-        MemoryConcation concat(s->startAddress, s->size, i, CT_IDENTICAL);
-        while(position < referSections.size())
-        {
-            auto rs = referSections[position];
-            if (rs->startAddress < s->startAddress)
-            {
-                ++position;
-                __concations.emplace_back(MemoryConcation(rs->startAddress, rs->size, position, CT_DEALLOC));
-            }
-            else if (rs->startAddress >= s->startAddress && rs->startAddress + rs->size <= s->startAddress + s->size)
-            {
-                concat.fragments.emplace_back(MemoryFragment(rs->startAddress, rs->size, position));
-                ++position;
-            } else {break;}
-        }
-        switch (concat.fragments.size())
-        {
-            case 0:
-            {
-                concat.type = CT_ALLOC;
-            } break;
-            
-            case 1:
-            {
-                auto &frag = concat.fragments[0];
-                concat.type = (frag.address == concat.address && frag.size == concat.size) ? CT_IDENTICAL : CT_CONCAT;
-            } break;
-            
-            default:
-            {
-                concat.type = CT_CONCAT;
-            } break;
-        }
-        __concations.emplace_back(concat);
-    }
+    dump("managed", __diff.managed);
+    dump("native", __diff.native);
+    
+    int32_t counts[4] = {0, 0, 0, 0};
+    for (auto iter = __concations.begin(); iter != __concations.end(); iter++) { counts[iter->type] += 1; }
+    printf("\e[36m[heap] \e[37midentical=%d \e[32malloc=%d \e[31mdealloc=%d \e[33mconcat=%d\e[0m\n",
+           counts[CT_IDENTICAL], counts[CT_ALLOC], counts[CT_DEALLOC], counts[CT_CONCAT]);
 }
 
 void MemorySnapshotCrawler::dumpAllClasses()
@@ -232,42 +252,17 @@ void MemorySnapshotCrawler::dumpAllClasses()
     }
 }
 
-bool MemorySnapshotCrawler::search(std::string &keyword, std::string &content, bool reverseSearching)
-{
-    if (content.size() < keyword.size()) {return false;}
-    if (reverseSearching)
-    {
-        auto k = keyword.rbegin();
-        auto c = content.rbegin();
-        while (k != keyword.rend())
-        {
-            if (*k != *c) { return false; }
-            ++k;
-            ++c;
-        }
-    }
-    else
-    {
-        auto k = keyword.begin();
-        auto c = content.begin();
-        while (k != keyword.end())
-        {
-            if (*k != *c) { return false; }
-            ++k;
-            ++c;
-        }
-    }
-    return true;
-}
-
 void MemorySnapshotCrawler::findNObject(string name, bool reverseMatching)
 {
+    std::vector<uint8_t> matches;
+    snapshot->strings.search(name, reverseMatching ? SM_suffix : SM_prefix, matches);
+    
     auto &nativeObjects = snapshot->nativeObjects->items;
     for (auto i = 0; i < snapshot->nativeObjects->size; i++)
     {
         auto &no = nativeObjects[i];
         auto &nt = snapshot->nativeTypes->items[no.nativeTypeArrayIndex];
-        if (search(name, no.name, reverseMatching))
+        if (no.name.id >= 0 && matches[no.name.id])
         {
             printf("\e[36m0x%llx \e[32m'%s' \e[33m%s\n", no.nativeObjectAddress, no.name.c_str(), nt.name.c_str());
         }
@@ -276,11 +271,14 @@ void MemorySnapshotCrawler::findNObject(string name, bool reverseMatching)
 
 void MemorySnapshotCrawler::findClass(string name, bool reverseMatching)
 {
+    std::vector<uint8_t> matches;
+    snapshot->strings.search(name, reverseMatching ? SM_suffix : SM_prefix, matches);
+    
     auto &typeDescriptions = snapshot->typeDescriptions->items;
     for (auto i = 0; i < snapshot->typeDescriptions->size; i++)
     {
         auto &type = typeDescriptions[i];
-        if (search(name, type.name, reverseMatching))
+        if (type.name.id >= 0 && matches[type.name.id])
         {
             printf("\e[36m%d \e[32m%s \e[37m%s\n", type.typeIndex, type.name.c_str(), type.assembly.c_str());
         }
@@ -703,6 +701,200 @@ void MemorySnapshotCrawler::topNObjects(int32_t rank)
     }
 }
 
+void MemorySnapshotCrawler::buildDominatorTree()
+{
+    __sampler.begin("BuildDominatorTree");
+    auto &nativeObjects = *snapshot->nativeObjects;
+    auto &nativeConnections = *snapshot->connections;
+    int32_t managedCount = managedObjects.size();
+    int32_t nodeCount = 1 + managedCount + nativeObjects.size;
+    auto nativeBase = 1 + managedCount;
+    
+    // roots are gcHandles/statics/links, managed objects and their native objects refer to each other
+    std::vector<int32_t> offsets(nodeCount + 1, 0);
+    std::vector<int32_t> edges;
+    for (auto pass = 0; pass < 2; pass++)
+    {
+        std::vector<int32_t> cursors;
+        if (pass == 1)
+        {
+            for (auto i = 1; i <= nodeCount; i++) { offsets[i] += offsets[i - 1]; }
+            edges.resize(offsets[nodeCount]);
+            cursors.assign(offsets.begin(), offsets.end() - 1);
+        }
+        
+        auto connect = [&](int32_t from, int32_t to)
+        {
+            if (pass == 0) { ++offsets[from + 1]; }
+            else { edges[cursors[from]++] = to; }
+        };
+        
+        for (auto i = 0; i < connections.size(); i++)
+        {
+            auto &ec = connections[i];
+            if (ec.toKind != CK_managed || ec.to < 0) {continue;}
+            connect(ec.fromKind == CK_managed ? 1 + ec.from : 0, 1 + ec.to);
+        }
+        
+        for (auto i = 0; i < managedCount; i++)
+        {
+            auto &mo = managedObjects[i];
+            if (mo.nativeObjectIndex < 0) {continue;}
+            connect(1 + i, nativeBase + mo.nativeObjectIndex);
+            connect(nativeBase + mo.nativeObjectIndex, 1 + i);
+        }
+        
+        // native references to gcHandles are skipped since gcHandle targets hang on root already
+        for (auto i = 0; i < nativeConnections.size; i++)
+        {
+            auto &nc = nativeConnections[i];
+            if (nc.toKind != CK_native) {continue;}
+            connect(nc.fromKind == CK_native ? nativeBase + nc.from : 0, nativeBase + nc.to);
+        }
+    }
+    
+    std::vector<int64_t> sizes(nodeCount, 0);
+    for (auto i = 0; i < managedCount; i++)
+    {
+        auto &mo = managedObjects[i];
+        if (!mo.isValueType) { sizes[1 + i] = mo.size; } // value objects are embedded in their holders
+    }
+    for (auto i = 0; i < nativeObjects.size; i++) { sizes[nativeBase + i] = nativeObjects[i].size; }
+    
+    dominatorTree.build(offsets, edges, sizes);
+    
+    char note[64];
+    snprintf(note, sizeof(note), "nodes=%d edges=%zu memory=%zu", nodeCount, edges.size(), dominatorTree.memory());
+    __sampler.annotate(note);
+    auto elapse = __sampler.end();
+    printf("\e[90mdominators nodes=%d edges=%zu elapse=%.3fms\e[0m\n", nodeCount, edges.size(), elapse / 1e6);
+}
+
+void MemorySnapshotCrawler::printDominatorNode(int32_t node)
+{
+    auto retainedSize = comma(dominatorTree.retainedSize(node));
+    if (node == 0)
+    {
+        printf("\e[37m<ROOT> \e[36m%s\e[0m\n", retainedSize.c_str());
+        return;
+    }
+    
+    int32_t managedCount = managedObjects.size();
+    if (node <= managedCount)
+    {
+        auto &mo = managedObjects[node - 1];
+        auto &type = snapshot->typeDescriptions->items[mo.typeIndex];
+        printf("\e[36m0x%llx \e[32m%s \e[36m%s \e[90m%s\e[0m\n", mo.address, type.name.c_str(),
+               retainedSize.c_str(), comma(mo.isValueType ? 0 : mo.size).c_str());
+    }
+    else
+    {
+        auto &no = snapshot->nativeObjects->items[node - 1 - managedCount];
+        auto &type = snapshot->nativeTypes->items[no.nativeTypeArrayIndex];
+        printf("\e[36m0x%llx \e[32m%s \e[33m'%s' \e[36m%s \e[90m%s\e[0m\n", no.nativeObjectAddress, type.name.c_str(), no.name.c_str(),
+               retainedSize.c_str(), comma(no.size).c_str());
+    }
+}
+
+void MemorySnapshotCrawler::topRetainers(int32_t rank)
+{
+    if (dominatorTree.empty()) {buildDominatorTree();}
+    
+    std::vector<int32_t> nodes;
+    nodes.reserve(dominatorTree.size());
+    for (auto i = 1; i < dominatorTree.size(); i++)
+    {
+        if (dominatorTree.retainedSize(i) > 0) {nodes.push_back(i);}
+    }
+    
+    if (rank > nodes.size() || rank <= 0) { rank = (int32_t)nodes.size(); }
+    std::partial_sort(nodes.begin(), nodes.begin() + rank, nodes.end(), [&](int32_t a, int32_t b)
+                      {
+                          auto sa = dominatorTree.retainedSize(a);
+                          auto sb = dominatorTree.retainedSize(b);
+                          return sa != sb ? sa > sb : a < b;
+                      });
+    
+    printDominatorNode(0);
+    for (auto i = 0; i < rank; i++) { printDominatorNode(nodes[i]); }
+}
+
+void MemorySnapshotCrawler::dumpDominatorTree(address_t address, int32_t depth, int32_t rank)
+{
+    if (dominatorTree.empty()) {buildDominatorTree();}
+    
+    int32_t node = 0;
+    if (address != 0)
+    {
+        auto managedObjectIndex = findMObjectAtAddress(address);
+        if (managedObjectIndex >= 0)
+        {
+            node = 1 + managedObjectIndex;
+        }
+        else
+        {
+            auto nativeObjectIndex = findNObjectAtAddress(address);
+            if (nativeObjectIndex == -1)
+            {
+                printf("\e[31mnot found object at address 0x%llx\e[0m\n", address);
+                return;
+            }
+            node = 1 + managedObjects.size() + nativeObjectIndex;
+        }
+        
+        // dominator chain up to root
+        std::vector<int32_t> chain;
+        for (auto n = dominatorTree.dominator(node); n > 0; n = dominatorTree.dominator(n)) { chain.push_back(n); }
+        for (auto iter = chain.rbegin(); iter != chain.rend(); iter++)
+        {
+            printf("\e[90m↓ \e[0m");
+            printDominatorNode(*iter);
+        }
+    }
+    
+    printDominatorNode(node);
+    dumpDominatorHierarchy(node, depth, rank, "");
+}
+
+void MemorySnapshotCrawler::dumpDominatorHierarchy(int32_t node, int32_t depth, int32_t rank, const char *indent)
+{
+    if (depth <= 0) {return;}
+    
+    auto children = dominatorTree.children(node);
+    std::vector<int32_t> nodes(children.begin(), children.end());
+    auto count = std::min<size_t>(rank <= 0 ? nodes.size() : rank, nodes.size());
+    std::partial_sort(nodes.begin(), nodes.begin() + count, nodes.end(), [&](int32_t a, int32_t b)
+                      {
+                          auto sa = dominatorTree.retainedSize(a);
+                          auto sb = dominatorTree.retainedSize(b);
+                          return sa != sb ? sa > sb : a < b;
+                      });
+    
+    auto __size = strlen(indent);
+    char __indent[__size + 2*3 + 1]; // indent + 2×tabulator + \0
+    memset(__indent, 0, sizeof(__indent));
+    memcpy(__indent, indent, __size);
+    char *tabular = __indent + __size;
+    memcpy(tabular + 3, "─", 3);
+    
+    for (auto i = 0; i < count; i++)
+    {
+        auto closed = i + 1 == count && count == nodes.size();
+        closed ? memcpy(tabular, "└", 3) : memcpy(tabular, "├", 3);
+        printf("%s", __indent);
+        printDominatorNode(nodes[i]);
+        dumpDominatorHierarchy(nodes[i], depth - 1, rank, getNestIndent(__indent, __size, closed).c_str());
+    }
+    
+    if (count < nodes.size())
+    {
+        int64_t remain = 0;
+        for (auto i = count; i < nodes.size(); i++) { remain += dominatorTree.retainedSize(nodes[i]); }
+        memcpy(tabular, "└", 3);
+        printf("%s\e[90m+%zu more %s\e[0m\n", __indent, nodes.size() - count, comma(remain).c_str());
+    }
+}
+
 void MemorySnapshotCrawler::barMMemory(MemoryState state, int32_t rank)
 {
     int64_t totalMemory = 0;
@@ -1338,46 +1530,29 @@ void MemorySnapshotCrawler::dumpSubclassesOf(int32_t typeIndex)
     auto &base = snapshot->typeDescriptions->items[typeIndex];
     if (base.typeIndex != typeIndex) {return;}
     printf("# %s *%d\n", base.name.c_str(), base.typeIndex);
-    auto &typeDescriptions = snapshot->typeDescriptions->items;
-    for (auto i = 0; i < snapshot->typeDescriptions->size; i++)
+    auto subclasses = findSubclassesOfMType(typeIndex);
+    std::sort(subclasses.begin(), subclasses.end());
+    for (auto iter = subclasses.begin(); iter != subclasses.end(); iter++)
     {
-        auto &type = typeDescriptions[i];
-        if (subclassOf(type, typeIndex))
-        {
-            printf("\e[32m%s \e[33m%s \e[37m*%d\n", type.name.c_str(), type.assembly.c_str(), type.typeIndex);
-        }
+        auto &type = snapshot->typeDescriptions->items[*iter];
+        printf("\e[32m%s \e[33m%s \e[37m*%d\n", type.name.c_str(), type.assembly.c_str(), type.typeIndex);
     }
 }
 
 void MemorySnapshotCrawler::statSubclasses()
 {
+    buildTypeHierarchy();
+    
     vector<int32_t> indice;
-    map<int32_t, int32_t> stats;
-    auto &typeDescriptions = snapshot->typeDescriptions->items;
-    for (auto i = 0; i < snapshot->typeDescriptions->size; i++)
+    for (auto i = 0; i < __managedHierarchy.size(); i++)
     {
-        auto type = &typeDescriptions[i];
-        while (type->baseOrElementTypeIndex >= 0)
-        {
-            auto match = stats.find(type->baseOrElementTypeIndex);
-            if (match == stats.end())
-            {
-                stats.insert(pair<int32_t, int32_t>(type->baseOrElementTypeIndex, 1));
-                indice.push_back(type->baseOrElementTypeIndex);
-            }
-            else
-            {
-                match->second++;
-            }
-            
-            type = &snapshot->typeDescriptions->items[type->baseOrElementTypeIndex];
-        }
+        if (__managedHierarchy.countSubclasses(i) > 0) { indice.push_back(i); }
     }
     
     std::sort(indice.begin(), indice.end(), [&](int32_t a, int32_t b)
               {
-                  auto na = stats[a];
-                  auto nb = stats[b];
+                  auto na = __managedHierarchy.countSubclasses(a);
+                  auto nb = __managedHierarchy.countSubclasses(b);
                   if (na != nb) {return na > nb;}
                   return a < b;
               });
@@ -1385,52 +1560,69 @@ void MemorySnapshotCrawler::statSubclasses()
     for (auto i = indice.begin(); i != indice.end(); ++i)
     {
         auto &type = snapshot->typeDescriptions->items[*i];
-        printf("\e[36m#%d \e[32m%s \e[33m%s \e[37m*%d\n", stats[*i], type.name.c_str(), type.assembly.c_str(), type.typeIndex);
+        printf("\e[36m#%d \e[32m%s \e[33m%s \e[37m*%d\n", __managedHierarchy.countSubclasses(*i), type.name.c_str(), type.assembly.c_str(), type.typeIndex);
     }
 }
 
-bool MemorySnapshotCrawler::subclassOf(TypeDescription &type, int32_t baseTypeIndex)
+vector<int32_t> MemorySnapshotCrawler::findSubclassesOfMType(int32_t typeIndex)
 {
-    if (baseTypeIndex < 0) {return false;}
-    
-    auto iter = &type;
-    while (iter->baseOrElementTypeIndex >= 0 && !iter->isArray)
+    buildTypeHierarchy();
+    if (typeIndex < 0 || typeIndex >= __managedHierarchy.size()) {return vector<int32_t>();}
+    return vector<int32_t>(__managedHierarchy.beginSubclasses(typeIndex), __managedHierarchy.endSubclasses(typeIndex));
+}
+
+vector<int32_t> MemorySnapshotCrawler::findSubclassesOfNType(int32_t typeIndex)
+{
+    buildTypeHierarchy();
+    if (typeIndex < 0 || typeIndex >= __nativeHierarchy.size()) {return vector<int32_t>();}
+    return vector<int32_t>(__nativeHierarchy.beginSubclasses(typeIndex), __nativeHierarchy.endSubclasses(typeIndex));
+}
+
+void MemorySnapshotCrawler::buildTypeHierarchy()
+{
+    auto &typeDescriptions = *snapshot->typeDescriptions;
+    if (__managedHierarchy.size() != typeDescriptions.size)
     {
-        if (iter->baseOrElementTypeIndex == baseTypeIndex) {return true;}
-        iter = &snapshot->typeDescriptions->items[iter->baseOrElementTypeIndex];
+        // element type of an array is not its base class
+        vector<int32_t> parents(typeDescriptions.size);
+        for (auto i = 0; i < typeDescriptions.size; i++)
+        {
+            auto &type = typeDescriptions[i];
+            parents[i] = type.isArray ? -1 : type.baseOrElementTypeIndex;
+        }
+        __managedHierarchy.build(parents);
     }
     
-    return false;
+    auto &nativeTypes = *snapshot->nativeTypes;
+    if (__nativeHierarchy.size() != nativeTypes.size)
+    {
+        vector<int32_t> parents(nativeTypes.size);
+        for (auto i = 0; i < nativeTypes.size; i++)
+        {
+            parents[i] = nativeTypes[i].nativeBaseTypeArrayIndex;
+        }
+        __nativeHierarchy.build(parents);
+    }
+}
+
+bool MemorySnapshotCrawler::subclassOf(TypeDescription &type, int32_t baseTypeIndex)
+{
+    buildTypeHierarchy();
+    return __managedHierarchy.subclass(type.typeIndex, baseTypeIndex);
 }
 
 bool MemorySnapshotCrawler::deriveFromMType(TypeDescription &type, int32_t baseTypeIndex)
 {
     if (type.typeIndex == baseTypeIndex) { return true; }
-    if (type.typeIndex < 0 || baseTypeIndex < 0) { return false; }
-    
-    TypeDescription *iter = &type;
-    while (iter->baseOrElementTypeIndex != -1 && !iter->isArray)
-    {
-        iter = &snapshot->typeDescriptions->items[iter->baseOrElementTypeIndex];
-        if (iter->typeIndex == baseTypeIndex) { return true; }
-    }
-    
-    return false;
+    buildTypeHierarchy();
+    return __managedHierarchy.derive(type.typeIndex, baseTypeIndex);
 }
 
 bool MemorySnapshotCrawler::deriveFromNType(PackedNativeType &type, int32_t baseTypeIndex)
 {
     if (type.typeIndex == baseTypeIndex) { return true; }
-    if (type.typeIndex < 0 || baseTypeIndex < 0) { return false; }
-    
-    PackedNativeType *iter = &type;
-    while (iter->nativeBaseTypeArrayIndex != -1)
-    {
-        iter = &snapshot->nativeTypes->items[iter->nativeBaseTypeArrayIndex];
-        if (iter->typeIndex == baseTypeIndex) { return true; }
-    }
-    
-    return false;
+    buildTypeHierarchy();
+    return __nativeHierarchy.derive(type.typeIndex, baseTypeIndex);
 }
 
 bool MemorySnapshotCrawler::isPremitiveType(int32_t typeIndex)
@@ -1487,8 +1679,8 @@ void MemorySnapshotCrawler::printPremitiveValue(address_t address, int32_t typeI
 void MemorySnapshotCrawler::dumpVRefChain(address_t address)
 {
     auto candidates = findVObjectAtAddress(address);
-    if (candidates == nullptr) {return;}
-    for (auto index = candidates->begin(); index != candidates->end(); index++)
+    if (candidates.empty()) {return;}
+    for (auto index = candidates.begin(); index != candidates.end(); index++)
     {
         auto *mo = &managedObjects[*index];
         auto *type = &snapshot->typeDescriptions->items[mo->typeIndex];
@@ -1496,7 +1688,7 @@ void MemorySnapshotCrawler::dumpVRefChain(address_t address)
         
         while (type->isValueType)
         {
-            auto &fromConnections = mo->fromConnections;
+            auto fromConnections = managedGraph.fromConnections(mo->managedObjectIndex);
             if (fromConnections.size() == 0) {break;}
             
             auto fromIndex = fromConnections[0];
@@ -1529,7 +1721,7 @@ EntityConnection* MemorySnapshotCrawler::getMRefNode(ManagedObject *mo, int32_t
     auto target = mo;
     while (target != nullptr && depth-- > 0)
     {
-        auto &fromConnections = target->fromConnections;
+        auto fromConnections = managedGraph.fromConnections(target->managedObjectIndex);
         if (fromConnections.size() == 0) {break;}
         
         auto iter = fromConnections.begin();
@@ -1549,13 +1741,73 @@ EntityConnection* MemorySnapshotCrawler::getMRefNode(ManagedObject *mo, int32_t
     return relation;
 }
 
+// managed objects with connections from gcHandles/statics/links as roots
+struct ManagedRetentionGraph
+{
+    MemorySnapshotCrawler *crawler;
+    
+    int32_t size() const { return crawler->managedObjects.size(); }
+    int32_t inDegree(int32_t node) const { return (int32_t)crawler->managedGraph.fromConnections(node).size(); }
+    
+    template <class F>
+    void forEachIncoming(int32_t node, F fn) const
+    {
+        for (auto ci: crawler->managedGraph.fromConnections(node))
+        {
+            auto &ec = crawler->connections[ci];
+            fn(ci, ec.fromKind == CK_managed && ec.from >= 0 ? ec.from : -1);
+        }
+    }
+    
+    template <class F>
+    void forEachOutgoing(int32_t node, F fn) const
+    {
+        for (auto ci: crawler->managedGraph.toConnections(node)) { fn(crawler->connections[ci].to); }
+    }
+};
+
+// native objects with connections from gcHandles as roots
+struct NativeRetentionGraph
+{
+    PackedMemorySnapshot *snapshot;
+    
+    int32_t size() const { return snapshot->nativeObjects->size; }
+    int32_t inDegree(int32_t node) const { return (int32_t)snapshot->nativeObjects->items[node].fromConnections.size(); }
+    
+    template <class F>
+    void forEachIncoming(int32_t node, F fn) const
+    {
+        for (auto ci: snapshot->nativeObjects->items[node].fromConnections)
+        {
+            auto &nc = snapshot->connections->items[ci];
+            fn(ci, nc.fromKind == CK_native ? nc.from : -1);
+        }
+    }
+    
+    template <class F>
+    void forEachOutgoing(int32_t node, F fn) const
+    {
+        for (auto ci: snapshot->nativeObjects->items[node].toConnections)
+        {
+            auto &nc = snapshot->connections->items[ci];
+            if (nc.toKind == CK_native) { fn(nc.to); }
+        }
+    }
+};
+
 void MemorySnapshotCrawler::dumpMRefChain(address_t address, bool includeCircular, int32_t route, int32_t depth)
 {
     auto objectIndex = findMObjectAtAddress(address);
     if (objectIndex == -1) {return;}
     
-    auto *mo = &managedObjects[objectIndex];
-    auto fullChains = iterateMRefChain(mo, route, depth, vector<int32_t>(), set<int64_t>());
+    ManagedRetentionGraph graph{this};
+    if (__managedRootDistances.size() != managedObjects.size())
+    {
+        RetentionPathFinder<ManagedRetentionGraph>::measure(graph, __managedRootDistances);
+    }
+    
+    RetentionPathFinder<ManagedRetentionGraph> finder(graph, __managedRootDistances);
+    auto fullChains = finder.find(objectIndex, route > 0 ? route : INT32_MAX, depth, REF_ITERATE_CAPACITY, includeCircular);
     for (auto c = fullChains.begin(); c != fullChains.end(); c++)
     {
         auto &chain = *c;
@@ -1626,83 +1878,20 @@ void MemorySnapshotCrawler::dumpMRefChain(address_t address, bool includeCircula
     }
 }
 
-vector<vector<int32_t>> MemorySnapshotCrawler::iterateMRefChain(ManagedObject *mo, int32_t routeMaximum, int32_t depthMaximum,
-                                                                vector<int32_t> chain, set<int64_t> antiCircular, int64_t __iter_capacity, int32_t __iter_depth)
-{
-    vector<vector<int32_t>> result;
-    if (mo->fromConnections.size() > 0)
-    {
-        set<int64_t> unique;
-        for (auto i = 0; i < mo->fromConnections.size(); i++)
-        {
-            if (routeMaximum > 0 && unique.size() >= routeMaximum) {break;}
-            auto ci = mo->fromConnections[i];
-            auto &ec = connections[ci];
-            auto fromIndex = ec.from;
-            
-            vector<int32_t> __chain(chain);
-            __chain.push_back(ci);
-            
-            if (ec.fromKind == CK_static || ec.fromKind == CK_gcHandle || ec.fromKind == CK_link || fromIndex < 0)
-            {
-                result.push_back(__chain);
-                continue;
-            }
-            
-            int64_t uuid = ((int64_t)ec.fromKind << 30 | (int64_t)ec.from) << 32 | ((int64_t)ec.toKind << 30 | ec.to);
-            if (unique.find(uuid) != unique.end()) {continue;}
-            unique.insert(uuid);
-            
-            if (antiCircular.find(uuid) == antiCircular.end())
-            {
-                set<int64_t> __antiCircular(antiCircular);
-                __antiCircular.insert(uuid);
-                
-                auto *fromObject = &managedObjects[fromIndex];
-                auto depthCapacity = fromObject->fromConnections.size();
-                if ((__iter_capacity * depthCapacity >= REF_ITERATE_CAPACITY && routeMaximum <= 0) || (routeMaximum > 1 && __iter_depth >= REF_ITERATE_DEPTH))
-                {
-                    __chain.push_back(-2); // interruptted signal
-                    result.push_back(__chain);
-                    continue;
-                }
-                
-                if (depthMaximum > 0 && depthMaximum <= __iter_depth + 1)
-                {
-                    if (depthCapacity > 0) {__chain.push_back(-2);}
-                    result.push_back(__chain);
-                    continue;
-                }
-                
-                auto branches = iterateMRefChain(fromObject, routeMaximum, depthMaximum, __chain, __antiCircular, __iter_capacity * depthCapacity, __iter_depth + 1);
-                if (branches.size() != 0)
-                {
-                    result.insert(result.end(), branches.begin(), branches.end());
-                }
-            }
-            else
-            {
-                __chain.push_back(-1); // circular signal
-                result.push_back(__chain); // circular reference situation
-            }
-        }
-    }
-    else
-    {
-        if (chain.size() != 0){result.push_back(chain);}
-    }
-    
-    return result;
-}
-
 void MemorySnapshotCrawler::dumpNRefChain(address_t address, bool includeCircular, int32_t route, int32_t depth)
 {
     auto objectIndex = findNObjectAtAddress(address);
     if (objectIndex == -1) {return;}
     
-    auto *no = &snapshot->nativeObjects->items[objectIndex];
     auto &nativeConnections = *snapshot->connections;
-    auto fullChains = iterateNRefChain(no, route, depth, vector<int32_t>(), set<int64_t>());
+    NativeRetentionGraph graph{snapshot};
+    if (__nativeRootDistances.size() != snapshot->nativeObjects->size)
+    {
+        RetentionPathFinder<NativeRetentionGraph>::measure(graph, __nativeRootDistances);
+    }
+    
+    RetentionPathFinder<NativeRetentionGraph> finder(graph, __nativeRootDistances);
+    auto fullChains = finder.find(objectIndex, route > 0 ? route : INT32_MAX, depth, REF_ITERATE_CAPACITY, includeCircular);
     for (auto c = fullChains.begin(); c != fullChains.end(); c++)
     {
         auto &chain = *c;
@@ -1769,75 +1958,6 @@ void MemorySnapshotCrawler::dumpNRefChain(address_t address, bool includeCircula
     }
 }
 
-vector<vector<int32_t>> MemorySnapshotCrawler::iterateNRefChain(PackedNativeUnityEngineObject *no, int32_t routeMaximum, int32_t depthMaximum,
-                                                                vector<int32_t> chain, set<int64_t> antiCircular, int64_t __iter_capacity, int32_t __iter_depth)
-{
-    vector<vector<int32_t>> result;
-    if (no->fromConnections.size() > 0)
-    {
-        set<int64_t> unique;
-        for (auto i = 0; i < no->fromConnections.size(); i++)
-        {
-            if (routeMaximum > 0 && unique.size() >= routeMaximum) {break;}
-            auto ci = no->fromConnections[i];
-            auto &nc = snapshot->connections->items[ci];
-            auto fromIndex = nc.from;
-            
-            vector<int32_t> __chain(chain);
-            __chain.push_back(ci);
-            
-            if (nc.fromKind != CK_native)
-            {
-                result.push_back(__chain);
-                continue;
-            }
-            
-            int64_t uuid = (int64_t)nc.from << 32 | nc.to;
-            if (unique.find(uuid) != unique.end()){continue;}
-            unique.insert(uuid);
-            
-            if (antiCircular.find(uuid) == antiCircular.end())
-            {
-                set<int64_t> __antiCircular(antiCircular);
-                __antiCircular.insert(uuid);
-                
-                auto *fromObject = &snapshot->nativeObjects->items[fromIndex];
-                auto depthCapacity = fromObject->fromConnections.size();
-                if ((__iter_capacity * depthCapacity >= REF_ITERATE_CAPACITY && routeMaximum <= 0) || (routeMaximum > 1 && __iter_depth >= REF_ITERATE_DEPTH))
-                {
-                    __chain.push_back(-2); // interruptted signal
-                    result.push_back(__chain);
-                    continue;
-                }
-                
-                if (depthMaximum > 0 && depthMaximum <= __iter_depth + 1)
-                {
-                    if (depthCapacity > 0) {__chain.push_back(-2);}
-                    result.push_back(__chain);
-                    continue;
-                }
-                
-                auto branches = iterateNRefChain(fromObject, routeMaximum, depthMaximum, __chain, __antiCircular, __iter_capacity * depthCapacity, __iter_depth + 1);
-                if (branches.size() != 0)
-                {
-                    result.insert(result.end(), branches.begin(), branches.end());
-                }
-            }
-            else
-            {
-                __chain.push_back(-1); // circular signal
-                result.push_back(__chain); // circular reference situation
-            }
-        }
-    }
-    else
-    {
-        if (chain.size() != 0){result.push_back(chain);}
-    }
-    
-    return result;
-}
-
 void MemorySnapshotCrawler::tryAcceptConnection(Connection &nc)
 {
     if (nc.from >= 0 && nc.fromKind == CK_native)
@@ -1855,17 +1975,19 @@ void MemorySnapshotCrawler::tryAcceptConnection(Connection &nc)
 
 void MemorySnapshotCrawler::tryAcceptConnection(EntityConnection &ec)
 {
-    if (ec.fromKind == CK_managed && ec.from >= 0)
-    {
-        auto &mo = managedObjects[ec.from];
-        mo.toConnections.push_back(ec.connectionArrayIndex);
-    }
+    managedGraph.accept(ec);
+}
+
+void MemorySnapshotCrawler::buildManagedGraph()
+{
+    __sampler.begin("BuildManagedGraph");
+    managedGraph.build(connections, managedObjects.size());
+    dominatorTree.clear(); // rebuilt lazily from the new graph
     
-    if (ec.toKind == CK_managed && ec.to >= 0)
-    {
-        auto &mo = managedObjects[ec.to];
-        mo.fromConnections.push_back(ec.connectionArrayIndex);
-    }
+    char note[64];
+    snprintf(note, sizeof(note), "memory=%zu", managedGraph.memory());
+    __sampler.annotate(note);
+    __sampler.end();
 }
 
 int32_t MemorySnapshotCrawler::findTypeAtTypeAddress(address_t address)
@@ -1887,97 +2009,398 @@ int32_t MemorySnapshotCrawler::findTypeAtTypeAddress(address_t address)
 
 int32_t MemorySnapshotCrawler::findTypeOfAddress(address_t address)
 {
+    return findTypeOfAddress(address, *__memoryReader);
+}
+
+int32_t MemorySnapshotCrawler::findTypeOfAddress(address_t address, HeapMemoryReader &memoryReader)
+{
+    auto &stats = memoryReader.resolveStats();
+    ++stats.lookups;
     auto typeIndex = findTypeAtTypeAddress(address); // il2cpp
-    if (typeIndex != -1) {return typeIndex;}
+    if (typeIndex != -1)
+    {
+        ++stats.direct;
+        return typeIndex;
+    }
     // MonoObject->vtable->kclass
-    auto vtable = __memoryReader->readPointer(address);
-    if (vtable == 0) {return -1;}
-    auto klass = __memoryReader->readPointer(vtable);
-    if (klass != 0)
+    auto vtable = memoryReader.readPointer(address);
+    if (vtable == 0)
     {
-        return findTypeAtTypeAddress(klass);
+        ++stats.nulls;
+        return -1;
     }
-    return findTypeAtTypeAddress(vtable);
+    
+    return findTypeOfVTable(vtable, memoryReader);
 }
 
-void MemorySnapshotCrawler::dumpRepeatedObjects(int32_t typeIndex, int32_t condition)
+int32_t MemorySnapshotCrawler::findTypeOfVTable(address_t vtable, HeapMemoryReader &memoryReader, bool cacheNegative)
 {
-    auto &type = snapshot->typeDescriptions->items[typeIndex];
+    auto &stats = memoryReader.resolveStats();
+    auto typeIndex = -1;
+    
+    // objects of one type share vtable, so klass is read once per vtable
+    auto cachable = !memoryReader.isStatic();
+    if (cachable)
+    {
+        if (__vtableTypeCache.capacity() == 0) { __vtableTypeCache.reset(4 * snapshot->typeDescriptions->size); }
+        if (__vtableTypeCache.find(vtable, typeIndex))
+        {
+            if (typeIndex >= 0) { ++stats.hits; } else { ++stats.negativeHits; }
+            return typeIndex;
+        }
+    }
+    
+    ++stats.misses;
+    auto klass = memoryReader.readPointer(vtable);
+    typeIndex = findTypeAtTypeAddress(klass != 0 ? klass : vtable);
+    if (cachable && (typeIndex >= 0 || cacheNegative) && !__vtableTypeCache.insert(vtable, typeIndex)) { ++stats.dropped; }
+    return typeIndex;
+}
+
+void MemorySnapshotCrawler::findDuplicateObjects(std::vector<DuplicateGroup> &groups, int32_t typeIndex, int32_t concurrency)
+{
+    if (concurrency <= 0) {concurrency = (int32_t)std::thread::hardware_concurrency();}
+    __sampler.begin("FindDuplicateObjects");
+    
+    struct ObjectKey
+    {
+        int32_t typeIndex;
+        int32_t size;
+        Hash128 hash;
+        int32_t object;
+        const char *data;
+    };
     
-    map<size_t, vector<int32_t>> stats;
+    auto &typeDescriptions = *snapshot->typeDescriptions;
+    auto locate = [&](HeapMemoryReader &reader, ManagedObject &mo)
+    {
+        auto address = typeDescriptions[mo.typeIndex].isValueType ? mo.address + __vm->objectHeaderSize : mo.address;
+        return reader.readMemory(address, mo.size);
+    };
+    
+    __sampler.begin("HashObjects");
+    std::vector<ObjectKey> keys;
     for (auto i = 0; i < managedObjects.size(); i++)
     {
         auto &mo = managedObjects[i];
-        if (mo.typeIndex == typeIndex)
+        if (mo.size <= 0 || mo.typeIndex < 0) {continue;}
+        if (typeIndex >= 0 ? mo.typeIndex != typeIndex : mo.isValueType) {continue;}
+        keys.push_back(ObjectKey{mo.typeIndex, mo.size, Hash128(), i, nullptr});
+    }
+    
+    const int32_t BLOCK_SIZE = 4096;
+    WorkStealingPool<int32_t> pool(concurrency);
+    for (auto offset = 0, n = 0; offset < keys.size(); offset += BLOCK_SIZE, n++) { pool.push(n, offset); }
+    
+    vector<std::unique_ptr<HeapMemoryReader>> readers;
+    for (auto i = 0; i < pool.threadCount(); i++) { readers.emplace_back(new HeapMemoryReader(snapshot)); }
+    pool.run([&](int32_t worker, int32_t &offset)
+             {
+                 auto &reader = *readers[worker];
+                 auto limit = std::min((int32_t)keys.size(), offset + BLOCK_SIZE);
+                 for (auto i = offset; i < limit; i++)
+                 {
+                     auto &key = keys[i];
+                     key.data = locate(reader, managedObjects[key.object]);
+                     if (key.data != nullptr) { key.hash = hash128(key.data, key.size); }
+                 }
+             });
+    keys.erase(std::remove_if(keys.begin(), keys.end(), [](const ObjectKey &key) { return key.data == nullptr; }), keys.end());
+    __sampler.end();
+    
+    __sampler.begin("GroupObjects");
+    std::sort(keys.begin(), keys.end(), [](const ObjectKey &a, const ObjectKey &b)
+              {
+                  if (a.typeIndex != b.typeIndex) {return a.typeIndex < b.typeIndex;}
+                  if (a.size != b.size) {return a.size < b.size;}
+                  if (a.hash != b.hash) {return a.hash < b.hash;}
+                  return a.object < b.object;
+              });
+    
+    groups.clear();
+    std::vector<std::pair<const char *, DuplicateGroup>> buckets;
+    for (size_t begin = 0, end = 0; begin < keys.size(); begin = end)
+    {
+        auto &first = keys[begin];
+        end = begin + 1;
+        while (end < keys.size() && keys[end].typeIndex == first.typeIndex && keys[end].size == first.size && keys[end].hash == first.hash) { ++end; }
+        if (end - begin < 2) {continue;}
+        
+        // equal hashes are expected to be equal bytes, collisions fall into separate buckets
+        buckets.clear();
+        for (auto i = begin; i < end; i++)
         {
-            size_t hash = 0;
-            if (type.isValueType)
-            {
-                auto *data = __memoryReader->readMemory(mo.address + __vm->objectHeaderSize);
-                 hash = __hash.get(data, mo.size);
-            }
-            else
-            {
-                auto *data = __memoryReader->readMemory(mo.address);
-                hash = __hash.get(data, mo.size);
-            }
-            
-            auto match = stats.find(hash);
-            if (match == stats.end())
+            auto &key = keys[i];
+            auto match = std::find_if(buckets.begin(), buckets.end(), [&](const std::pair<const char *, DuplicateGroup> &bucket)
+                                      {
+                                          return memcmp(bucket.first, key.data, key.size) == 0;
+                                      });
+            if (match == buckets.end())
             {
-                match = stats.insert(pair<size_t, vector<int32_t>>(hash, vector<int32_t>())).first;
+                DuplicateGroup group;
+                group.typeIndex = key.typeIndex;
+                group.size = key.size;
+                buckets.emplace_back(key.data, group);
+                match = buckets.end() - 1;
             }
-            
-            match->second.push_back(mo.managedObjectIndex);
+            match->second.objects.push_back(key.object);
+        }
+        
+        for (auto iter = buckets.begin(); iter != buckets.end(); iter++)
+        {
+            if (iter->second.objects.size() >= 2) { groups.emplace_back(std::move(iter->second)); }
         }
     }
+    __sampler.end();
+    __sampler.end();
+}
+
+void MemorySnapshotCrawler::dumpRepeatedObjects(int32_t typeIndex, int32_t condition)
+{
+    auto &type = snapshot->typeDescriptions->items[typeIndex];
+    
+    std::vector<DuplicateGroup> groups;
+    findDuplicateObjects(groups, typeIndex);
+    groups.erase(std::remove_if(groups.begin(), groups.end(), [&](const DuplicateGroup &group)
+                                {
+                                    return condition > 0 && group.objects.size() < condition;
+                                }), groups.end());
+    std::sort(groups.begin(), groups.end(), [](const DuplicateGroup &a, const DuplicateGroup &b)
+              {
+                  auto ma = a.size * a.objects.size();
+                  auto mb = b.size * b.objects.size();
+                  if (ma != mb) { return ma < mb; }
+                  return a.objects.size() > b.objects.size();
+              });
+    
+    printf("%s typeIndex=%d instanceCount=%d instanceMemory=%d\n", type.name.c_str(), typeIndex, type.instanceCount, type.instanceMemory);
+    auto isString = type.typeIndex == snapshot->managedTypeIndex.system_String;
+    for (auto iter = groups.begin(); iter != groups.end(); iter++)
+    {
+        auto &children = iter->objects;
+        printf("\e[36m%s #%-2d", comma(iter->size * children.size()).c_str(), (int32_t)children.size());
+        
+        bool extraComplate = false;
+        for (auto n= children.begin(); n != children.end(); n++)
+        {
+            auto &mo = managedObjects[*n];
+            auto size = 0;
+            if (!extraComplate && isString) {printf(" \e[32m'%s'", getUTFString(mo.address, size, true).c_str());}
+            printf(" \e[33m0x%08llx", mo.address);
+            extraComplate = true;
+        }
+        printf("\n");
+    }
+}
+
+void MemorySnapshotCrawler::dumpDuplicateObjects(int32_t rank)
+{
+    std::vector<DuplicateGroup> groups;
+    findDuplicateObjects(groups);
+    
+    struct TypeWaste
+    {
+        int32_t typeIndex = -1;
+        int32_t groupCount = 0;
+        int32_t redundantCount = 0;
+        int64_t wasted = 0;
+    };
+    
+    std::map<int32_t, TypeWaste> types;
+    int64_t totalWasted = 0;
+    int32_t totalRedundant = 0;
+    for (auto iter = groups.begin(); iter != groups.end(); iter++)
+    {
+        auto &stat = types[iter->typeIndex];
+        stat.typeIndex = iter->typeIndex;
+        stat.groupCount += 1;
+        stat.redundantCount += (int32_t)iter->objects.size() - 1;
+        stat.wasted += iter->wasted();
+        totalWasted += iter->wasted();
+        totalRedundant += (int32_t)iter->objects.size() - 1;
+    }
+    
+    std::vector<TypeWaste> ranks;
+    for (auto iter = types.begin(); iter != types.end(); iter++) { ranks.push_back(iter->second); }
+    std::sort(ranks.begin(), ranks.end(), [](const TypeWaste &a, const TypeWaste &b)
+              {
+                  return a.wasted != b.wasted ? a.wasted > b.wasted : a.typeIndex < b.typeIndex;
+              });
+    
+    auto &typeDescriptions = *snapshot->typeDescriptions;
+    printf("\e[37mgroups=%d redundant=%d wasted=%s types=%d\n", (int32_t)groups.size(), totalRedundant, comma(totalWasted).c_str(), (int32_t)ranks.size());
+    for (auto i = 0; i < ranks.size() && i < rank; i++)
+    {
+        auto &stat = ranks[i];
+        printf("\e[36m%s \e[32m%s \e[37mtypeIndex=%d groups=%d redundant=%d\n", comma(stat.wasted).c_str(), typeDescriptions[stat.typeIndex].name.c_str(), stat.typeIndex, stat.groupCount, stat.redundantCount);
+    }
+    
+    std::sort(groups.begin(), groups.end(), [](const DuplicateGroup &a, const DuplicateGroup &b)
+              {
+                  return a.wasted() != b.wasted() ? a.wasted() > b.wasted() : a.objects.front() < b.objects.front();
+              });
+    printf("\e[37m--- top groups ---\n");
+    for (auto i = 0; i < groups.size() && i < rank; i++)
+    {
+        auto &group = groups[i];
+        auto &mo = managedObjects[group.objects.front()];
+        printf("\e[36m%s #%-2d \e[32m%s", comma(group.wasted()).c_str(), (int32_t)group.objects.size(), typeDescriptions[group.typeIndex].name.c_str());
+        if (group.typeIndex == snapshot->managedTypeIndex.system_String)
+        {
+            auto size = 0;
+            printf(" \e[32m'%s'", getUTFString(mo.address, size, true).c_str());
+        }
+        printf(" \e[33m0x%08llx\n", mo.address);
+    }
+}
+
+void MemorySnapshotCrawler::sweepHeap(HeapSweep &sweep, int32_t concurrency)
+{
+    if (concurrency <= 0) {concurrency = (int32_t)std::thread::hardware_concurrency();}
+    __sampler.begin("SweepHeap");
+    
+    // lazy tables are filled before workers share them
+    auto &typeDescriptions = *snapshot->typeDescriptions;
+    if (typeDescriptions.size > 0) { findTypeAtTypeAddress(typeDescriptions[0].typeInfoAddress); }
+    if (__vtableTypeCache.capacity() == 0) { __vtableTypeCache.reset(4 * typeDescriptions.size); }
+    
+    // reachable reference objects in address order, walked along with the sweep
+    vector<std::pair<address_t, int64_t>> reachables;
+    for (auto i = 0; i < managedObjects.size(); i++)
+    {
+        auto &mo = managedObjects[i];
+        if (!mo.isValueType && mo.size > 0) { reachables.emplace_back(mo.address, mo.size); }
+    }
+    std::sort(reachables.begin(), reachables.end());
     
-    map<size_t, int32_t> memory;
-    vector<size_t> target;
+    auto &heapSections = *snapshot->sortedHeapSections;
+    WorkStealingPool<int32_t> pool(concurrency);
+    for (auto i = 0; i < heapSections.size(); i++) { pool.push(i, i); }
+    
+    struct SweepContext
+    {
+        std::unique_ptr<HeapMemoryReader> reader;
+        std::vector<UnreachableStat> stats;
+        int64_t reachableMemory = 0;
+    };
+    
+    vector<SweepContext> contexts(pool.threadCount());
+    for (auto iter = contexts.begin(); iter != contexts.end(); iter++)
+    {
+        iter->reader.reset(new HeapMemoryReader(snapshot));
+        iter->stats.resize(typeDescriptions.size);
+    }
+    
+    auto alignment = (address_t)__vm->pointerSize;
+    auto align = [&](int64_t size) { return ((address_t)size + alignment - 1) & ~(alignment - 1); };
+    auto complete = __vtableTypeCache.dropped() == 0;
+    pool.run([&](int32_t worker, int32_t &index)
+             {
+                 auto &context = contexts[worker];
+                 auto &reader = *context.reader;
+                 auto &section = *heapSections[index];
+                 if (section.bytes == nullptr) {return;}
+                 
+                 auto memory = (const char *)section.bytes->items;
+                 auto stopAddress = section.startAddress + section.bytes->size;
+                 auto address = (section.startAddress + alignment - 1) & ~(alignment - 1);
+                 auto next = std::lower_bound(reachables.begin(), reachables.end(), std::make_pair(address, (int64_t)0));
+                 while (address + alignment <= stopAddress)
+                 {
+                     while (next != reachables.end() && next->first < address) { ++next; }
+                     auto reachable = next != reachables.end() && next->first == address;
+                     
+                     // a header is a vtable resolved while crawling or a type info address, other words are skipped without reading memory
+                     int64_t size = 0;
+                     address_t vtable = 0;
+                     memcpy(&vtable, memory + (address - section.startAddress), alignment);
+                     auto typeIndex = -1;
+                     if (vtable != 0 && !__vtableTypeCache.find(vtable, typeIndex))
+                     {
+                         // vtables dropped by a full cache can only be found by reading them
+                         typeIndex = complete ? findTypeAtTypeAddress(vtable) : findTypeOfVTable(vtable, reader, false);
+                     }
+                     if (typeIndex >= 0)
+                     {
+                         auto &type = typeDescriptions[typeIndex];
+                         size = type.isValueType ? __vm->objectHeaderSize + type.size : reader.readObjectSize(address, type);
+                         if (size < __vm->objectHeaderSize || address + size > stopAddress) { size = 0; }
+                     }
+                     if (size == 0 && reachable && address + next->second <= stopAddress) { size = next->second; }
+                     if (!reachable && next != reachables.end() && address + size > next->first) { size = 0; } // must not swallow a reachable object
+                     
+                     if (size == 0)
+                     {
+                         address += alignment;
+                         continue;
+                     }
+                     
+                     if (reachable)
+                     {
+                         context.reachableMemory += size;
+                     }
+                     else
+                     {
+                         auto &stat = context.stats[typeIndex];
+                         stat.typeIndex = typeIndex;
+                         stat.count += 1;
+                         stat.memory += size;
+                     }
+                     address += align(size);
+                 }
+             });
+    
+    sweep = HeapSweep();
+    for (auto iter = heapSections.begin(); iter != heapSections.end(); iter++)
+    {
+        if ((*iter)->bytes != nullptr) { sweep.heapMemory += (*iter)->bytes->size; }
+    }
     
-    printf("%s typeIndex=%d instanceCount=%d instanceMemory=%d\n", type.name.c_str(), typeIndex, type.instanceCount, type.instanceMemory);
-    for (auto iter = stats.begin(); iter != stats.end(); iter++)
+    std::vector<UnreachableStat> stats(typeDescriptions.size);
+    for (auto iter = contexts.begin(); iter != contexts.end(); iter++)
     {
-        auto &children = iter->second;
-        if ((condition > 0 && children.size() < condition) || children.size() < 2) {continue;}
-        
-        auto total = 0;
-        for (auto n = children.begin(); n != children.end(); n++)
+        sweep.reachableMemory += iter->reachableMemory;
+        for (auto i = 0; i < typeDescriptions.size; i++)
         {
-            auto &mo = managedObjects[*n];
-            total += mo.size;
+            auto &stat = iter->stats[i];
+            if (stat.count == 0) {continue;}
+            stats[i].typeIndex = i;
+            stats[i].count += stat.count;
+            stats[i].memory += stat.memory;
+            sweep.unreachableCount += stat.count;
+            sweep.unreachableMemory += stat.memory;
         }
-        
-        memory.insert(pair<size_t, int32_t>(iter->first, total));
-        target.push_back(iter->first);
     }
+    for (auto iter = stats.begin(); iter != stats.end(); iter++)
+    {
+        if (iter->count > 0) { sweep.types.push_back(*iter); }
+    }
+    
+    TypeResolveStats resolveStats;
+    for (auto iter = contexts.begin(); iter != contexts.end(); iter++) { resolveStats.merge(iter->reader->resolveStats()); }
+    __sampler.annotate(resolveStats.summary());
+    __sampler.end();
+}
+
+void MemorySnapshotCrawler::dumpUnreachableObjects(int32_t rank)
+{
+    HeapSweep sweep;
+    sweepHeap(sweep);
     
-    std::sort(target.begin(), target.end(), [&](size_t a, size_t b)
+    auto &types = sweep.types;
+    std::sort(types.begin(), types.end(), [](const UnreachableStat &a, const UnreachableStat &b)
               {
-                  auto ma = memory.at(a);
-                  auto mb = memory.at(b);
-                  if (ma != mb) { return ma < mb; }
-                  auto &ca = stats.at(a);
-                  auto &cb = stats.at(b);
-                  return ca.size() > cb.size();
+                  return a.memory != b.memory ? a.memory > b.memory : a.typeIndex < b.typeIndex;
               });
-    auto isString = type.typeIndex == snapshot->managedTypeIndex.system_String;
-    for (auto iter = target.begin(); iter != target.end(); iter++)
+    
+    auto &typeDescriptions = *snapshot->typeDescriptions;
+    printf("\e[37mheap=%s reachable=%s unreachable=%s #%lld types=%d\n", comma(sweep.heapMemory).c_str(), comma(sweep.reachableMemory).c_str(),
+           comma(sweep.unreachableMemory).c_str(), sweep.unreachableCount, (int32_t)types.size());
+    for (auto i = 0; i < types.size() && i < rank; i++)
     {
-        auto hash = *iter;
-        auto &children = stats.at(hash);
-        printf("\e[36m%s #%-2d", comma(memory.at(hash)).c_str(), (int32_t)children.size());
-        
-        bool extraComplate = false;
-        for (auto n= children.begin(); n != children.end(); n++)
-        {
-            auto &mo = managedObjects[*n];
-            auto size = 0;
-            if (!extraComplate && isString) {printf(" \e[32m'%s'", getUTFString(mo.address, size, true).c_str());}
-            printf(" \e[33m0x%08llx", mo.address);
-            extraComplate = true;
-        }
-        printf("\n");
+        auto &stat = types[i];
+        printf("\e[36m%s #%lld \e[32m%s \e[37mtypeIndex=%d\n", comma(stat.memory).c_str(), stat.count,
+               typeDescriptions[stat.typeIndex].name.c_str(), stat.typeIndex);
     }
 }
 
@@ -1992,13 +2415,14 @@ address_t MemorySnapshotCrawler::findMObjectOfNObject(address_t address)
             if (mo.nativeObjectIndex >= 0)
             {
                 auto &no = snapshot->nativeObjects->items[mo.nativeObjectIndex];
-                __managedNativeAddressMap.insert(pair<address_t, int32_t>(no.nativeObjectAddress, mo.managedObjectIndex));
+                __managedNativeAddressMap.add(no.nativeObjectAddress, mo.managedObjectIndex);
             }
         }
+        __managedNativeAddressMap.build();
     }
     
     auto iter = __managedNativeAddressMap.find(address);
-    if (iter == __managedNativeAddressMap.end())
+    if (iter == nullptr)
     {
         auto &link = snapshot->nativeAppendingCollection.nmAddressMap;
         auto match = link.find(address);
@@ -2006,7 +2430,7 @@ address_t MemorySnapshotCrawler::findMObjectOfNObject(address_t address)
     }
     else
     {
-        return managedObjects[iter->second].address;
+        return managedObjects[*iter].address;
     }
 }
 
@@ -2020,13 +2444,14 @@ address_t MemorySnapshotCrawler::findNObjectOfMObject(address_t address)
             auto &mo = managedObjects[i];
             if (mo.nativeObjectIndex >= 0)
             {
-                __nativeManagedAddressMap.insert(pair<address_t, int32_t>(mo.address, mo.nativeObjectIndex));
+                __nativeManagedAddressMap.add(mo.address, mo.nativeObjectIndex);
             }
         }
+        __nativeManagedAddressMap.build();
     }
     
     auto iter = __nativeManagedAddressMap.find(address);
-    if (iter == __nativeManagedAddressMap.end())
+    if (iter == nullptr)
     {
         auto &link = snapshot->nativeAppendingCollection.mnAddressMap;
         auto match = link.find(address);
@@ -2034,13 +2459,13 @@ address_t MemorySnapshotCrawler::findNObjectOfMObject(address_t address)
     }
     else
     {
-        return snapshot->nativeObjects->items[iter->second].nativeObjectAddress;
+        return snapshot->nativeObjects->items[*iter].nativeObjectAddress;
     }
 }
 
-vector<int32_t> *MemorySnapshotCrawler::findVObjectAtAddress(address_t address)
+AddressRange<int32_t> MemorySnapshotCrawler::findVObjectAtAddress(address_t address)
 {
-    if (address < 0xFFFF){return nullptr;}
+    if (address < 0xFFFF){return AddressRange<int32_t>{nullptr, nullptr};}
     if (__valueAddressMap.size() == 0)
     {
         for (auto i = 0; i < managedObjects.size(); i++)
@@ -2050,19 +2475,13 @@ vector<int32_t> *MemorySnapshotCrawler::findVObjectAtAddress(address_t address)
             
             if (type.isValueType)
             {
-                auto iter = __valueAddressMap.find(mo.address);
-                if (iter == __valueAddressMap.end())
-                {
-                    iter = __valueAddressMap.insert(pair<address_t, vector<int32_t>>(mo.address, {})).first;
-                }
-                
-                iter->second.push_back(mo.managedObjectIndex);
+                __valueAddressMap.add(mo.address, mo.managedObjectIndex);
             }
         }
+        __valueAddressMap.build();
     }
     
-    auto iter = __valueAddressMap.find(address);
-    return iter != __valueAddressMap.end() ? &iter->second : nullptr;
+    return __valueAddressMap.range(address);
 }
 
 int32_t MemorySnapshotCrawler::findMObjectAtAddress(address_t address)
@@ -2076,13 +2495,14 @@ int32_t MemorySnapshotCrawler::findMObjectAtAddress(address_t address)
             auto &type = snapshot->typeDescriptions->items[mo.typeIndex];
             if (!type.isValueType)
             {
-                __managedObjectAddressMap.insert(pair<address_t, int32_t>(mo.address, mo.managedObjectIndex));
+                __managedObjectAddressMap.add(mo.address, mo.managedObjectIndex);
             }
         }
+        __managedObjectAddressMap.build();
     }
     
     auto iter = __managedObjectAddressMap.find(address);
-    return iter != __managedObjectAddressMap.end() ? iter->second : -1;
+    return iter != nullptr ? *iter : -1;
 }
 
 int32_t MemorySnapshotCrawler::findNObjectAtAddress(address_t address)
@@ -2146,15 +2566,77 @@ bool MemorySnapshotCrawler::isCrawlable(TypeDescription &type)
     return !type.isValueType || type.size > 8; // vm->pointerSize
 }
 
-bool MemorySnapshotCrawler::crawlManagedArrayAddress(address_t address, TypeDescription &type, HeapMemoryReader &memoryReader, EntityJoint &joint, int32_t depth)
+void MemorySnapshotCrawler::compileReferenceMaps()
 {
-    auto isStaticCrawling = memoryReader.isStatic();
-    if (address < 0 || (!isStaticCrawling && address == 0)){return false;}
+    auto &typeDescriptions = *snapshot->typeDescriptions;
+    __referenceSlots.clear();
+    __referenceMaps.assign(typeDescriptions.size + 1, 0);
+    for (auto i = 0; i < typeDescriptions.size; i++)
+    {
+        __referenceMaps[i] = (int32_t)__referenceSlots.size();
+        if (typeDescriptions[i].isArray) {continue;}
+        
+        // fields of derived type come first, then fields of every base type
+        auto iterType = &typeDescriptions[i];
+        for (auto depth = 0; iterType != nullptr && depth < typeDescriptions.size; depth++)
+        {
+            for (auto n = 0; n < iterType->fields->size; n++)
+            {
+                auto &field = iterType->fields->items[n];
+                if (field.isStatic){continue;}
+                
+                auto &fieldType = typeDescriptions[field.typeIndex];
+                if (!isCrawlable(fieldType)){continue;}
+                
+                ReferenceSlot slot;
+                slot.offset = field.offset;
+                slot.fieldTypeIndex = field.typeIndex;
+                slot.hookTypeIndex = iterType->typeIndex;
+                slot.fieldSlotIndex = field.fieldSlotIndex;
+                slot.isValueType = fieldType.isValueType;
+                __referenceSlots.push_back(slot);
+            }
+            
+            auto baseTypeIndex = iterType->baseOrElementTypeIndex;
+            iterType = baseTypeIndex == -1 ? nullptr : &typeDescriptions[baseTypeIndex];
+        }
+    }
+    __referenceMaps[typeDescriptions.size] = (int32_t)__referenceSlots.size();
+}
+
+int32_t MemorySnapshotCrawler::resolveEntryType(address_t address, TypeDescription *type, HeapMemoryReader &memoryReader, bool isActualType)
+{
+    if (type != nullptr && (type->isValueType || isActualType)) {return type->typeIndex;}
+    
+    auto typeIndex = findTypeOfAddress(address, memoryReader);
+    if (typeIndex == -1 && type != nullptr) {typeIndex = type->typeIndex;}
+    return typeIndex;
+}
+
+void MemorySnapshotCrawler::appendCrawlEntry(vector<CrawlEntry> &entries, CrawlEntry &entry, HeapMemoryReader &memoryReader, HeapMemoryReader &heapReader, int32_t nest)
+{
+    if (!memoryReader.isStatic() && entry.address == 0) {entry.typeIndex = -1;}
+    
+    auto index = entries.size();
+    entries.push_back(entry);
+    if (entry.typeIndex == -1) {return;}
+    
+    auto &entryType = snapshot->typeDescriptions->items[entry.typeIndex];
+    if (!entryType.isValueType) {return;}
+    
+    // value type is crawled in place, so its slots are nested right after it
+    entries[index].size = memoryReader.readObjectSize(entry.address, entryType);
+    if (nest >= CRAWL_NEST_LIMIT) {return;} // guard against broken metadata
     
+    expandManagedObject(entries, entry.address, entryType, memoryReader, heapReader, nest + 1);
+    entries[index].span = (int32_t)(entries.size() - index - 1);
+}
+
+void MemorySnapshotCrawler::expandManagedArray(vector<CrawlEntry> &entries, address_t address, TypeDescription &type, HeapMemoryReader &memoryReader, HeapMemoryReader &heapReader, int32_t nest)
+{
     auto elementType = &snapshot->typeDescriptions->items[type.baseOrElementTypeIndex];
-    if (!isCrawlable(*elementType)) {return false;}
+    if (!isCrawlable(*elementType)) {return;}
     
-    auto successCount = 0;
     address_t elementAddress = 0;
     auto elementCount = memoryReader.readArrayLength(address, type);
     if (elementCount >= 1E+8) // 100 million
@@ -2162,6 +2644,18 @@ bool MemorySnapshotCrawler::crawlManagedArrayAddress(address_t address, TypeDesc
         printf("\e[31m[E] huge array[size=%u] at *0x%08llx\n\e[0m", elementCount, address);
         abort();
     }
+    
+    // reference elements are scanned in bulk when they sit in one heap section
+    if (!elementType->isValueType && __vm->pointerSize == 8 && !memoryReader.isStatic() && elementCount > 0)
+    {
+        auto elements = memoryReader.readMemory(address + __vm->arrayHeaderSize, (int32_t)elementCount * 8);
+        if (elements != nullptr)
+        {
+            expandPointerArray(entries, elements, elementCount, *elementType, memoryReader, heapReader, nest);
+            return;
+        }
+    }
+    
     for (auto i = 0; i < elementCount; i++)
     {
         elementType = &snapshot->typeDescriptions->items[type.baseOrElementTypeIndex];
@@ -2175,7 +2669,7 @@ bool MemorySnapshotCrawler::crawlManagedArrayAddress(address_t address, TypeDesc
             elementAddress = memoryReader.readPointer(ptrAddress);
             if (elementAddress == 0) {continue;}
             
-            auto typeIndex = findTypeOfAddress(elementAddress);
+            auto typeIndex = findTypeOfAddress(elementAddress, heapReader);
             if (typeIndex >= 0)
             {
                 auto derivedType = &snapshot->typeDescriptions->items[typeIndex];
@@ -2186,68 +2680,198 @@ bool MemorySnapshotCrawler::crawlManagedArrayAddress(address_t address, TypeDesc
             }
         }
         
-        auto &elementJoint = joints.add();
-        elementJoint.jointArrayIndex = joints.size() - 1;
-        elementJoint.isConnected = false;
-        
-        // set field hook info
-        elementJoint.hookObjectAddress = address;
-        elementJoint.hookObjectIndex = joint.managedArrayIndex;
-        elementJoint.hookTypeIndex = joint.fieldTypeIndex;
+        CrawlEntry entry;
+        entry.address = elementAddress;
+        entry.typeIndex = elementType->typeIndex;
+        entry.fieldTypeIndex = elementType->typeIndex;
+        entry.elementArrayIndex = i;
+        appendCrawlEntry(entries, entry, memoryReader, heapReader, nest);
+    }
+}
+
+void MemorySnapshotCrawler::expandPointerArray(vector<CrawlEntry> &entries, const char *elements, uint32_t elementCount, TypeDescription &elementType, HeapMemoryReader &memoryReader, HeapMemoryReader &heapReader, int32_t nest)
+{
+    constexpr int32_t CHUNK_SIZE = 64;
+    address_t pointers[CHUNK_SIZE];
+    int32_t typeIndice[CHUNK_SIZE];
+    
+    auto &typeDescriptions = *snapshot->typeDescriptions;
+    auto heapSize = __heapStopAddress - __heapStartAddress;
+    auto resolvedTypeIndex = -2;
+    TypeDescription *resolvedType = nullptr;
+    
+    for (uint32_t base = 0; base < elementCount; base += CHUNK_SIZE)
+    {
+        auto count = (int32_t)std::min<uint32_t>(CHUNK_SIZE, elementCount - base);
+        memcpy(pointers, elements + (size_t)base * 8, count * 8);
         
-        // set field info
-        elementJoint.fieldAddress = elementAddress;
-        elementJoint.fieldTypeIndex = elementType->typeIndex;
+        // branch free compares so the compiler can vectorize them
+        uint64_t valid = 0;
+        uint64_t inside = 0;
+        for (auto n = 0; n < count; n++)
+        {
+            valid |= (uint64_t)(pointers[n] != 0) << n;
+            inside |= (uint64_t)(pointers[n] - __heapStartAddress < heapSize) << n;
+        }
         
-        // set element info
-        elementJoint.elementArrayIndex = i;
+        // resolve types of the whole chunk before emitting entries
+        for (auto bits = valid; bits != 0; bits &= bits - 1)
+        {
+            auto n = __builtin_ctzll(bits);
+            auto address = pointers[n];
+            auto typeIndex = (inside >> n & 1) ? findTypeOfAddress(address, heapReader) : findTypeAtTypeAddress(address);
+            if (typeIndex != resolvedTypeIndex)
+            {
+                resolvedTypeIndex = typeIndex;
+                resolvedType = &elementType;
+                if (typeIndex >= 0)
+                {
+                    auto derivedType = &typeDescriptions[typeIndex];
+                    if (elementType.baseOrElementTypeIndex == -1 || deriveFromMType(*derivedType, elementType.typeIndex)) // sometimes get wrong type from object type pointer
+                    {
+                        resolvedType = derivedType;
+                    }
+                }
+            }
+            typeIndice[n] = resolvedType->typeIndex;
+        }
         
-        auto success = crawlManagedEntryAddress(elementAddress, elementType, memoryReader, elementJoint, true, depth + 1);
-        if (success) { successCount += 1; }
+        for (auto bits = valid; bits != 0; bits &= bits - 1)
+        {
+            auto n = __builtin_ctzll(bits);
+            CrawlEntry entry;
+            entry.address = pointers[n];
+            entry.typeIndex = typeIndice[n];
+            entry.fieldTypeIndex = typeIndice[n];
+            entry.elementArrayIndex = (int32_t)base + n;
+            appendCrawlEntry(entries, entry, memoryReader, heapReader, nest);
+        }
     }
-    
-    return successCount != 0;
 }
 
-bool MemorySnapshotCrawler::crawlManagedEntryAddress(address_t address, TypeDescription *type, HeapMemoryReader &memoryReader, EntityJoint &joint, bool isActualType, int32_t depth)
+void MemorySnapshotCrawler::expandManagedObject(vector<CrawlEntry> &entries, address_t address, TypeDescription &type, HeapMemoryReader &memoryReader, HeapMemoryReader &heapReader, int32_t nest)
 {
-    auto isStaticCrawling = memoryReader.isStatic();
-    if (address < 0 || (!isStaticCrawling && address == 0)){return false;}
-    if (depth >= 1024) {return false;}
-    
-    int32_t typeIndex = -1;
-    if (type != nullptr && type->isValueType)
+    if (type.isArray)
     {
-        typeIndex = type->typeIndex;
+        expandManagedArray(entries, address, type, memoryReader, heapReader, nest);
+        return;
     }
-    else
+    
+    auto &typeDescriptions = *snapshot->typeDescriptions;
+    auto pointerOffset = memoryReader.isStatic() ? -__vm->objectHeaderSize : 0;
+    auto slot = __referenceSlots.data() + __referenceMaps[type.typeIndex];
+    auto stop = __referenceSlots.data() + __referenceMaps[type.typeIndex + 1];
+    for (; slot != stop; slot++)
     {
-        if (isActualType)
+        auto *fieldType = &typeDescriptions[slot->fieldTypeIndex];
+        
+        address_t fieldAddress = 0;
+        if (slot->isValueType)
         {
-            typeIndex = type->typeIndex;
+            fieldAddress = address + slot->offset - __vm->objectHeaderSize;
         }
         else
         {
-            typeIndex = findTypeOfAddress(address);
-            if (typeIndex == -1 && type != nullptr) {typeIndex = type->typeIndex;}
+            fieldAddress = memoryReader.readPointer(address + slot->offset + pointerOffset);
+            if (fieldAddress == 0) {continue;}
+            
+            auto fieldTypeIndex = findTypeOfAddress(fieldAddress, heapReader);
+            if (fieldTypeIndex != -1)
+            {
+                auto derivedType = &typeDescriptions[fieldTypeIndex];
+                if (fieldType->baseOrElementTypeIndex == -1 || deriveFromMType(*derivedType, fieldType->typeIndex)) // sometimes get wrong type from object type pointer
+                {
+                    fieldType = derivedType;
+                }
+            }
         }
+        
+        CrawlEntry entry;
+        entry.address = fieldAddress;
+        entry.typeIndex = fieldType->typeIndex;
+        entry.hookTypeIndex = slot->hookTypeIndex;
+        entry.fieldTypeIndex = slot->fieldTypeIndex;
+        entry.fieldSlotIndex = slot->fieldSlotIndex;
+        entry.fieldOffset = slot->offset;
+        appendCrawlEntry(entries, entry, fieldType->isValueType ? memoryReader : heapReader, heapReader, nest);
     }
-    if (typeIndex == -1){return false;}
+}
+
+bool MemorySnapshotCrawler::acceptManagedEntry(CrawlRecord *source, int32_t index, EntityJoint &joint)
+{
+    // copy entry, expansion below may grow the shared entry stack
+    auto entry = (source != nullptr ? source->entries : __crawlingEntries)[index];
+    if (entry.typeIndex == -1) {return false;}
+    
+    auto &entryType = snapshot->typeDescriptions->items[entry.typeIndex];
     
-    auto &entryType = snapshot->typeDescriptions->items[typeIndex];
+    if (__crawlingDepth == __crawlingFrames.size()) {__crawlingFrames.emplace_back();}
+    auto &frame = __crawlingFrames[__crawlingDepth];
+    frame.successCount = 0;
+    frame.owner = false;
+    
+    // value type slots follow the entry, reference object slots come from its record or own expansion
+    frame.record = source;
+    frame.slot = index + 1;
+    frame.stop = frame.slot + entry.span;
     
     ManagedObject *mo;
-    auto iter = __crawlingVisit.find(address);
-    if (entryType.isValueType || iter == __crawlingVisit.end())
+    auto visit = __crawlingVisit.find(entry.address);
+    if (entryType.isValueType || visit == nullptr)
     {
-        mo = &createManagedObject(address, typeIndex);
-        mo->size = memoryReader.readObjectSize(mo->address, entryType);
+        auto size = entry.size;
+        if (!entryType.isValueType)
+        {
+            auto record = entry.record;
+            if (record != nullptr)
+            {
+                // expand it here if no worker has started on it, otherwise wait for the worker
+                auto state = (int32_t)CrawlRecord::CR_queued;
+                if (!record->state.compare_exchange_strong(state, CrawlRecord::CR_taken))
+                {
+                    while (state == CrawlRecord::CR_expanding)
+                    {
+                        std::this_thread::yield();
+                        state = record->state.load(std::memory_order_acquire);
+                    }
+                }
+                
+                auto matched = record->typeIndex == entry.typeIndex;
+                if (state == CrawlRecord::CR_ready && !matched) {releaseCrawlRecord(*record);}
+                if (state != CrawlRecord::CR_ready || !matched) {record = nullptr;}
+            }
+            
+            if (record == nullptr)
+            {
+                size = __memoryReader->readObjectSize(entry.address, entryType);
+                frame.record = nullptr;
+                frame.base = (int32_t)__crawlingEntries.size();
+                expandManagedObject(__crawlingEntries, entry.address, entryType, *__memoryReader, *__memoryReader, 1);
+                frame.slot = frame.base;
+                frame.stop = (int32_t)__crawlingEntries.size();
+                if (__crawlingParallel)
+                {
+                    claimCrawlEntries(0, __crawlingEntries.data() + frame.slot, __crawlingEntries.data() + frame.stop);
+                }
+            }
+            else
+            {
+                size = record->size;
+                frame.record = record;
+                frame.slot = 0;
+                frame.stop = (int32_t)record->entries.size();
+            }
+            frame.owner = true;
+        }
+        
+        mo = &createManagedObject(entry.address, entry.typeIndex);
+        mo->size = size;
         mo->isValueType = entryType.isValueType;
-        assert(typeIndex < snapshot->typeDescriptions->size);
+        assert(entry.typeIndex < snapshot->typeDescriptions->size);
     }
     else
     {
-        auto managedObjectIndex = iter->second;
+        auto managedObjectIndex = *visit;
         mo = &managedObjects[managedObjectIndex];
     }
     
@@ -2286,92 +2910,93 @@ bool MemorySnapshotCrawler::crawlManagedEntryAddress(address_t address, TypeDesc
     
     if (!entryType.isValueType)
     {
-        if (iter != __crawlingVisit.end()) {return false;}
-        __crawlingVisit.insert(pair<address_t, int32_t>(address, mo->managedObjectIndex));
+        if (visit != nullptr) {return false;}
+        __crawlingVisit.insert(entry.address, mo->managedObjectIndex);
     }
     
-    if (entryType.isArray)
-    {
-        return crawlManagedArrayAddress(address, entryType, memoryReader, joint, depth + 1);
-    }
+    // push object on crawling stack
+    frame.address = entry.address;
+    frame.managedObjectIndex = mo->managedObjectIndex;
+    frame.hookTypeIndex = joint.fieldTypeIndex;
+    frame.isArray = entryType.isArray;
+    __crawlingDepth += 1;
+    return true;
+}
+
+// an entry succeeds when it is a newly crawled object with at least one succeeded slot, the same as recursive crawling did
+bool MemorySnapshotCrawler::crawlManagedEntry(CrawlRecord *source, int32_t index, EntityJoint &joint)
+{
+    auto base = __crawlingDepth;
+    if (!acceptManagedEntry(source, index, joint)) {return false;}
     
-    auto successCount = 0;
-    auto iterType = &entryType;
-    while (iterType != nullptr)
+    auto success = false;
+    while (__crawlingDepth > base)
     {
-        for (auto i = 0; i < iterType->fields->size; i++)
+        auto &frame = __crawlingFrames[__crawlingDepth - 1];
+        if (frame.slot >= frame.stop)
         {
-            auto &field = iterType->fields->items[i];
-            if (field.isStatic){continue;}
-            
-            auto *fieldType = &snapshot->typeDescriptions->items[field.typeIndex];
-            if (!isCrawlable(*fieldType)){continue;}
-            
-            address_t fieldAddress = 0;
-            if (fieldType->isValueType)
-            {
-                fieldAddress = address + field.offset - __vm->objectHeaderSize;
-            }
-            else
-            {
-                address_t ptrAddress = 0;
-                if (memoryReader.isStatic())
-                {
-                    ptrAddress = address + field.offset - __vm->objectHeaderSize;
-                }
-                else
-                {
-                    ptrAddress = address + field.offset;
-                }
-                fieldAddress = memoryReader.readPointer(ptrAddress);
-                if (fieldAddress == 0) {continue;}
-                
-                auto fieldTypeIndex = findTypeOfAddress(fieldAddress);
-                if (fieldTypeIndex != -1)
-                {
-                    auto derivedType = &snapshot->typeDescriptions->items[fieldTypeIndex];
-                    if (fieldType->baseOrElementTypeIndex == -1 || deriveFromMType(*derivedType, fieldType->typeIndex)) // sometimes get wrong type from object type pointer
-                    {
-                        fieldType = derivedType;
-                    }
-                }
-            }
-            
-            auto *reader = &memoryReader;
-            if (!fieldType->isValueType)
+            if (frame.owner)
             {
-                reader = this->__memoryReader;
+                if (frame.record != nullptr) { releaseCrawlRecord(*frame.record); }
+                else { __crawlingEntries.resize(frame.base); }
             }
             
-            auto &ej = joints.add();
-            
-            // set field hook info
-            ej.jointArrayIndex = joints.size() - 1;
-            ej.hookObjectAddress = address;
-            ej.hookObjectIndex = mo->managedObjectIndex;
-            ej.hookTypeIndex = iterType->typeIndex;
-            
-            // set field info
-            ej.fieldAddress = fieldAddress;
-            ej.fieldTypeIndex = field.typeIndex;
-            ej.fieldSlotIndex = field.fieldSlotIndex;
-            ej.fieldOffset = field.offset;
-            
-            auto success = crawlManagedEntryAddress(fieldAddress, fieldType, *reader, ej, true, depth + 1);
-            if (success) { successCount += 1; }
+            auto succeeded = frame.successCount > 0;
+            __crawlingDepth -= 1;
+            if (__crawlingDepth > base) { __crawlingFrames[__crawlingDepth - 1].successCount += succeeded; }
+            else { success = succeeded; }
+            continue;
         }
         
-        if (iterType->baseOrElementTypeIndex == -1)
+        auto record = frame.record;
+        auto slotIndex = frame.slot;
+        auto &slot = (record != nullptr ? record->entries : __crawlingEntries)[slotIndex];
+        frame.slot += 1 + slot.span;
+        
+        auto &ej = joints.add();
+        ej.jointArrayIndex = joints.size() - 1;
+        ej.hookObjectAddress = frame.address;
+        ej.hookObjectIndex = frame.managedObjectIndex;
+        ej.fieldAddress = slot.address;
+        ej.fieldTypeIndex = slot.fieldTypeIndex;
+        if (frame.isArray)
         {
-            iterType = nullptr;
+            // set element info
+            ej.hookTypeIndex = frame.hookTypeIndex;
+            ej.elementArrayIndex = slot.elementArrayIndex;
         }
         else
         {
-            iterType = &snapshot->typeDescriptions->items[iterType->baseOrElementTypeIndex];
+            // set field info
+            ej.hookTypeIndex = slot.hookTypeIndex;
+            ej.fieldSlotIndex = slot.fieldSlotIndex;
+            ej.fieldOffset = slot.fieldOffset;
         }
+        
+        acceptManagedEntry(record, slotIndex, ej);
     }
     
-    return successCount != 0;
+    return success;
+}
+
+bool MemorySnapshotCrawler::crawlManagedEntryAddress(address_t address, TypeDescription *type, HeapMemoryReader &memoryReader, EntityJoint &joint, bool isActualType)
+{
+    auto isStaticCrawling = memoryReader.isStatic();
+    if (!isStaticCrawling && address == 0){return false;}
+    
+    CrawlEntry entry;
+    entry.address = address;
+    entry.typeIndex = resolveEntryType(address, type, *__memoryReader, isActualType);
+    
+    auto base = __crawlingEntries.size();
+    appendCrawlEntry(__crawlingEntries, entry, memoryReader, *__memoryReader, 0);
+    if (__crawlingParallel)
+    {
+        claimCrawlEntries(0, __crawlingEntries.data() + base, __crawlingEntries.data() + __crawlingEntries.size());
+    }
+    auto success = crawlManagedEntry(nullptr, (int32_t)base, joint);
+    __crawlingEntries.resize(base);
+    return success;
 }
 
 int32_t MemorySnapshotCrawler::getReferencedMemoryOf(address_t address, TypeDescription *type, std::set<address_t> &antiCircular, bool verbose)
@@ -2539,9 +3164,9 @@ void MemorySnapshotCrawler::dumpGCHandles()
 void MemorySnapshotCrawler::inspectVObject(address_t address)
 {
     auto candidates = findVObjectAtAddress(address);
-    if (candidates == nullptr) {return;}
+    if (candidates.empty()) {return;}
     
-    for (auto index = candidates->begin(); index != candidates->end(); index++)
+    for (auto index = candidates.begin(); index != candidates.end(); index++)
     {
         auto &mo = managedObjects[*index];
         auto &type = snapshot->typeDescriptions->items[mo.typeIndex];
@@ -3303,9 +3928,9 @@ void MemorySnapshotCrawler::listMulticastDelegates()
     
     vector<address_t> roots;
     map<address_t, bool> visit;
-    for (auto i = __multicastForwardAddressMap.begin(); i != __multicastForwardAddressMap.end(); i++)
+    for (auto i = 0; i < __multicastForwardAddressMap.size(); i++)
     {
-        auto address = i->first;
+        auto address = __multicastForwardAddressMap.address(i);
         auto match = visit.find(address);
         if (match == visit.end())
         {
@@ -3314,14 +3939,14 @@ void MemorySnapshotCrawler::listMulticastDelegates()
             while (true)
             {
                 auto iter = __multicastReverseAddressMap.find(position);
-                if (iter == __multicastReverseAddressMap.end())
+                if (iter == nullptr)
                 {
                     roots.push_back(position);
                     break;
                 }
                 else
                 {
-                    position = match->second;
+                    position = *iter;
                 }
             }
         }
@@ -3340,8 +3965,8 @@ void MemorySnapshotCrawler::listMulticastDelegates()
         {
             refCount++;
             auto iter = __multicastForwardAddressMap.find(position);
-            if (iter == __multicastForwardAddressMap.end()){break;}
-            position = iter->second;
+            if (iter == nullptr){break;}
+            position = *iter;
         }
         indice.push_back(index);
         counts.insert(pair<int32_t, int32_t>(index, refCount));
@@ -3411,14 +4036,13 @@ void MemorySnapshotCrawler::retrieveMulticastDelegate(address_t address)
                 auto pointer = __memoryReader->readPointer(mo.address + prevOffset);
                 if (pointer != 0)
                 {
-                    auto match = __multicastForwardAddressMap.find(mo.address);
-                    assert(match == __multicastForwardAddressMap.end());
-                    
-                    __multicastForwardAddressMap.insert(pair<address_t, address_t>(mo.address, pointer));
-                    __multicastReverseAddressMap.insert(pair<address_t, address_t>(pointer, mo.address));
+                    __multicastForwardAddressMap.add(mo.address, pointer);
+                    __multicastReverseAddressMap.add(pointer, mo.address);
                 }
             }
         }
+        __multicastForwardAddressMap.build();
+        __multicastReverseAddressMap.build();
     }
     
     auto entityObjectIndex = findMObjectAtAddress(address);
@@ -3428,8 +4052,8 @@ void MemorySnapshotCrawler::retrieveMulticastDelegate(address_t address)
     while (true)
     {
         auto iter = __multicastReverseAddressMap.find(position);
-        if (iter == __multicastReverseAddressMap.end()) {break;}
-        position = iter->second;
+        if (iter == nullptr) {break;}
+        position = *iter;
     }
     
     vector<FieldDescription *> fields{members.at(prevOffset), members.at(targetOffset)};
@@ -3769,7 +4393,7 @@ void MemorySnapshotCrawler::crawlLinks()
                 if (typeIndex != -1)
                 {
                     auto &type = snapshot->typeDescriptions->items[typeIndex];
-                    crawlManagedEntryAddress(iter->link.managedAddress, &type, *__memoryReader, joint, true, 0);
+                    crawlManagedEntryAddress(iter->link.managedAddress, &type, *__memoryReader, joint, true);
                 }
             }
         }
@@ -3777,6 +4401,170 @@ void MemorySnapshotCrawler::crawlLinks()
     __sampler.end();
 }
 
+void MemorySnapshotCrawler::claimCrawlEntries(int32_t worker, CrawlEntry *begin, CrawlEntry *end)
+{
+    auto &typeDescriptions = *snapshot->typeDescriptions;
+    for (auto iter = begin; iter != end; iter++)
+    {
+        if (iter->typeIndex == -1 || typeDescriptions[iter->typeIndex].isValueType) {continue;}
+        
+        bool claimed;
+        iter->record = __crawlingRecords.claim(iter->address, claimed, iter->typeIndex);
+        if (claimed)
+        {
+            CrawlTask task;
+            task.address = iter->address;
+            task.record = iter->record;
+            __crawlingPool->push(worker, task);
+        }
+    }
+}
+
+void MemorySnapshotCrawler::releaseCrawlRecord(CrawlRecord &record)
+{
+    int64_t count = record.entries.size();
+    std::vector<CrawlEntry>().swap(record.entries);
+    auto backlog = __crawlingBacklog.fetch_sub(count);
+    if (backlog > CRAWL_BACKLOG_LIMIT && backlog - count <= CRAWL_BACKLOG_LIMIT)
+    {
+        std::lock_guard<std::mutex> lock(__crawlingMutex);
+        __crawlingSignal.notify_all();
+    }
+}
+
+void MemorySnapshotCrawler::startParallelCrawling(int32_t concurrency)
+{
+    __sampler.begin("StartParallelCrawling");
+    // ordered crawl runs on this thread, so one worker less
+    __crawlingPool.reset(new WorkStealingPool<CrawlTask>(concurrency - 1));
+    __crawlingBacklog = 0;
+    __crawlingStopped = false;
+    
+    auto &typeDescriptions = *snapshot->typeDescriptions;
+    // resolve roots the same way crawlGCHandles/crawlStatic/crawlLinks do
+    vector<CrawlEntry> roots;
+    auto &gcHandles = *snapshot->gcHandles;
+    for (auto i = 0; i < gcHandles.size; i++)
+    {
+        CrawlEntry entry;
+        entry.address = gcHandles[i].target;
+        if (entry.address == 0) {continue;}
+        entry.typeIndex = resolveEntryType(entry.address, nullptr, *__memoryReader, false);
+        appendCrawlEntry(roots, entry, *__memoryReader, *__memoryReader, 0);
+    }
+    
+    for (auto i = 0; i < typeDescriptions.size; i++)
+    {
+        auto &type = typeDescriptions[i];
+        if (type.staticFieldBytes == nullptr || type.staticFieldBytes->size == 0){continue;}
+        __staticMemoryReader->load(*type.staticFieldBytes);
+        for (auto n = 0; n < type.fields->size; n++)
+        {
+            auto &field = type.fields->items[n];
+            if (!field.isStatic){continue;}
+            
+            CrawlEntry entry;
+            HeapMemoryReader *reader;
+            auto *fieldType = &typeDescriptions[field.typeIndex];
+            if (fieldType->isValueType)
+            {
+                entry.address = field.offset - __vm->objectHeaderSize;
+                reader = __staticMemoryReader;
+            }
+            else
+            {
+                entry.address = __staticMemoryReader->readPointer(field.offset);
+                reader = __memoryReader;
+                if (entry.address == 0) {continue;}
+            }
+            
+            entry.typeIndex = resolveEntryType(entry.address, fieldType, *__memoryReader, false);
+            appendCrawlEntry(roots, entry, *reader, *__memoryReader, 0);
+        }
+    }
+    
+    auto &appendings = snapshot->nativeAppendingCollection.appendings;
+    for (auto iter = appendings.begin(); iter != appendings.end(); iter++)
+    {
+        if (iter->link.managedTypeAddress == 0 || iter->link.managedAddress == 0) {continue;}
+        auto typeIndex = findTypeAtTypeAddress(iter->link.managedTypeAddress);
+        if (typeIndex == -1) {continue;}
+        
+        CrawlEntry entry;
+        entry.address = iter->link.managedAddress;
+        entry.typeIndex = typeIndex;
+        appendCrawlEntry(roots, entry, *__memoryReader, *__memoryReader, 0);
+    }
+    
+    for (auto i = 0; i < roots.size(); i++)
+    {
+        claimCrawlEntries(i, &roots[i], &roots[i] + 1);
+    }
+    
+    for (auto i = 0; i < __crawlingPool->threadCount(); i++)
+    {
+        __crawlingReaders.emplace_back(new HeapMemoryReader(snapshot));
+    }
+    
+    // workers stay alive until stopParallelCrawling, the ordered crawl keeps claiming entries
+    __crawlingPool->hold();
+    __crawlingDriver = std::thread([this]()
+    {
+        auto &typeDescriptions = *snapshot->typeDescriptions;
+        __crawlingPool->run([&](int32_t worker, CrawlTask &task)
+        {
+            if (__crawlingBacklog.load() > CRAWL_BACKLOG_LIMIT)
+            {
+                std::unique_lock<std::mutex> lock(__crawlingMutex);
+                __crawlingSignal.wait(lock, [&]() { return __crawlingBacklog.load() <= CRAWL_BACKLOG_LIMIT || __crawlingStopped.load(); });
+            }
+            if (__crawlingStopped.load()) {return;}
+            
+            auto &record = *task.record;
+            auto state = (int32_t)CrawlRecord::CR_queued;
+            if (!record.state.compare_exchange_strong(state, CrawlRecord::CR_expanding)) {return;}
+            
+            auto &reader = *__crawlingReaders[worker];
+            auto &type = typeDescriptions[record.typeIndex];
+            record.size = reader.readObjectSize(task.address, type);
+            expandManagedObject(record.entries, task.address, type, reader, reader, 1);
+            claimCrawlEntries(worker, record.entries.data(), record.entries.data() + record.entries.size());
+            __crawlingBacklog.fetch_add(record.entries.size());
+            record.state.store(CrawlRecord::CR_ready, std::memory_order_release);
+        });
+    });
+    
+    __crawlingParallel = true;
+    __sampler.end();
+}
+
+void MemorySnapshotCrawler::stopParallelCrawling()
+{
+    __sampler.begin("StopParallelCrawling");
+    {
+        std::lock_guard<std::mutex> lock(__crawlingMutex);
+        __crawlingStopped = true;
+        __crawlingSignal.notify_all();
+    }
+    __crawlingPool->release();
+    __crawlingDriver.join();
+    
+    HeapLookupStats stats;
+    TypeResolveStats resolveStats;
+    for (auto iter = __crawlingReaders.begin(); iter != __crawlingReaders.end(); iter++)
+    {
+        stats.merge((*iter)->stats());
+        resolveStats.merge((*iter)->resolveStats());
+    }
+    __sampler.annotate(stats.summary() + " " + resolveStats.summary());
+    
+    __crawlingReaders.clear();
+    __crawlingPool.reset();
+    __crawlingRecords.clear();
+    __crawlingParallel = false;
+    __sampler.end();
+}
+
 void MemorySnapshotCrawler::crawlGCHandles()
 {
     __sampler.begin("CrawlGCHandles");
@@ -3791,7 +4579,7 @@ void MemorySnapshotCrawler::crawlGCHandles()
         // set gcHandle info
         joint.gcHandleIndex = item.gcHandleArrayIndex;
         
-        crawlManagedEntryAddress(item.target, nullptr, *__memoryReader, joint, false, 0);
+        crawlManagedEntryAddress(item.target, nullptr, *__memoryReader, joint, false);
     }
     __sampler.end();
 }
@@ -3834,7 +4622,7 @@ void MemorySnapshotCrawler::crawlStatic()
             joint.fieldTypeIndex = field.typeIndex;
             joint.isStatic = true;
             
-            crawlManagedEntryAddress(fieldAddress, fieldType, *reader, joint, false, 0);
+            crawlManagedEntryAddress(fieldAddress, fieldType, *reader, joint, false);
         }
     }
     __sampler.end();
@@ -23,6 +23,13 @@
 #include "serialize.h"
 #include "stat.h"
 #include "fragment.h"
+#include "parallel.h"
+#include "graph.h"
+#include "dominator.h"
+#include "path.h"
+#include "diff.h"
+#include "hash.h"
+#include "hierarchy.h"
 
 using std::vector;
 using std::set;
@@ -54,11 +61,98 @@ struct EntityConnection: public Connection
     int32_t jointEntryIndex = -1;
 };
 
-struct ManagedObject
+struct CrawlRecord;
+
+// field/element slot discovered while expanding a managed object, value type slots are followed by their own nested slots
+struct CrawlEntry
+{
+    CrawlRecord *record = nullptr; // claimed record of reference slot, set while parallel crawling
+    address_t address = 0;
+    int32_t typeIndex = -1;
+    int32_t hookTypeIndex = -1;
+    int32_t fieldTypeIndex = -1;
+    int32_t fieldSlotIndex = -1;
+    int32_t fieldOffset = 0;
+    int32_t elementArrayIndex = -1;
+    int32_t size = 0;
+    int32_t span = 0;
+};
+
+// non-static crawlable field of a type or one of its bases, compiled once in crawling order
+struct ReferenceSlot
 {
-    std::vector<int32_t> fromConnections;
-    std::vector<int32_t> toConnections;
+    int32_t offset = 0;
+    int32_t fieldTypeIndex = -1;
+    int32_t hookTypeIndex = -1;
+    int32_t fieldSlotIndex = -1;
+    bool isValueType = false;
+};
+
+// expanded slots of a reference object, created by crawling workers ahead of the ordered crawl
+struct CrawlRecord
+{
+    enum State: int32_t { CR_queued = 0, CR_expanding, CR_ready, CR_taken };
+    
+    std::atomic<int32_t> state;
+    int32_t typeIndex = -1;
+    int32_t size = 0;
+    std::vector<CrawlEntry> entries;
     
+    CrawlRecord(int32_t typeIndex): state(CR_queued), typeIndex(typeIndex) {}
+};
+
+struct CrawlTask
+{
+    address_t address = 0;
+    CrawlRecord *record = nullptr;
+};
+
+// pending slots of an object on the explicit crawling stack, slots are [slot, stop) of record entries or of the shared entry stack
+struct CrawlFrame
+{
+    CrawlRecord *record = nullptr;
+    int32_t slot = 0;
+    int32_t stop = 0;
+    int32_t base = 0; // slots owned by frame start here on the shared entry stack
+    bool owner = false; // frame releases its slots when popped
+    int32_t successCount = 0;
+    
+    address_t address = 0;
+    int32_t managedObjectIndex = -1;
+    int32_t hookTypeIndex = -1;
+    bool isArray = false;
+};
+
+// managed objects of one type with identical bytes, verified by memcmp
+struct DuplicateGroup
+{
+    int32_t typeIndex = -1;
+    int32_t size = 0;
+    std::vector<int32_t> objects; // managed object indice
+    
+    int64_t wasted() const { return (int64_t)size * (objects.size() - 1); }
+};
+
+// objects found by heap sweep that no crawled reference reaches
+struct UnreachableStat
+{
+    int32_t typeIndex = -1;
+    int64_t count = 0;
+    int64_t memory = 0;
+};
+
+struct HeapSweep
+{
+    int64_t heapMemory = 0;
+    int64_t reachableMemory = 0; // crawled objects lying inside heap sections
+    int64_t unreachableMemory = 0;
+    int64_t unreachableCount = 0;
+    std::vector<UnreachableStat> types;
+};
+
+// connections of managed objects live in MemorySnapshotCrawler::managedGraph
+struct ManagedObject
+{
     address_t address = 0;
     int32_t typeIndex = -1;
     int32_t managedObjectIndex = -1;
@@ -72,9 +166,11 @@ struct ManagedObject
 #include <memory>
 #include <new>
 
+// chunks are allocated from an arena owned by manager, so releasing millions of items costs a few munmap calls
 template <class T>
 class InstanceManager
 {
+    MemoryArena __arena;
     std::vector<T *> __manager;
     int32_t __cursor;
     int32_t __deltaCount;
@@ -89,6 +185,7 @@ public:
     T &operator[](const int32_t index);
     T &clone(T &item);
     void rollback();
+    void clear();
     int32_t size();
     
     ~InstanceManager();
@@ -103,18 +200,26 @@ public:
     InstanceManager<ManagedObject> managedObjects;
     InstanceManager<EntityConnection> connections;
     InstanceManager<EntityJoint> joints;
+    ConnectionGraph managedGraph;
+    DominatorTree dominatorTree; // node 0 is root, then managed objects and native objects
     
     PackedMemorySnapshot *snapshot;
     
 private:
+    static constexpr int64_t CRAWL_BACKLOG_LIMIT = 1 << 20;
+    
     static constexpr int64_t REF_ITERATE_CAPACITY = 1 << 20;
-    static constexpr int32_t REF_ITERATE_DEPTH = 32;
     static constexpr int32_t SEP_DASH_COUNT = 40;
+    static constexpr int32_t CRAWL_NEST_LIMIT = 1024;
     
     HeapMemoryReader *__memoryReader;
     StaticMemoryReader *__staticMemoryReader;
     VirtualMachineInformation *__vm;
     std::vector<MemoryConcation> __concations;
+    SnapshotDiff __diff;
+    
+    TypeHierarchy __managedHierarchy;
+    TypeHierarchy __nativeHierarchy;
     
     std::wstring_convert<std::codecvt_utf8<char16_t>, char16_t> __convertor;
     
@@ -122,21 +227,44 @@ private:
     address_t *__mirror = nullptr;
     
     // crawling map
-    map<address_t, int32_t> __crawlingVisit;
+    AddressHashMap<int32_t> __crawlingVisit;
+    ShardedAddressMap<CrawlRecord> __crawlingRecords;
+    bool __crawlingParallel = false;
+    std::unique_ptr<WorkStealingPool<CrawlTask>> __crawlingPool;
+    std::vector<std::unique_ptr<HeapMemoryReader>> __crawlingReaders;
+    std::thread __crawlingDriver;
+    std::atomic<int64_t> __crawlingBacklog; // expanded entries not yet replayed by ordered crawl
+    std::atomic<bool> __crawlingStopped;
+    std::mutex __crawlingMutex;
+    std::condition_variable __crawlingSignal;
+    std::vector<CrawlFrame> __crawlingFrames;
+    std::vector<CrawlEntry> __crawlingEntries; // expanded slots of objects on crawling stack, one contiguous range per frame
+    int32_t __crawlingDepth = 0;
     
     // address map
     std::unordered_map<address_t, int32_t> __typeAddressMap;
+    VTableTypeCache __vtableTypeCache;
+    
+    // slots of type i are __referenceSlots[__referenceMaps[i], __referenceMaps[i + 1])
+    std::vector<ReferenceSlot> __referenceSlots;
+    std::vector<int32_t> __referenceMaps;
+    
+    // address span covered by heap sections
+    address_t __heapStartAddress = 0;
+    address_t __heapStopAddress = 0;
     std::unordered_map<address_t, int32_t> __nativeObjectAddressMap;
-    map<address_t, int32_t> __managedObjectAddressMap;
-    map<address_t, vector<int32_t>> __valueAddressMap;
+    AddressIndex<int32_t> __managedObjectAddressMap;
+    AddressIndex<int32_t> __valueAddressMap;
     
-    map<address_t, int32_t> __managedNativeAddressMap;
-    map<address_t, int32_t> __nativeManagedAddressMap;
+    AddressIndex<int32_t> __managedNativeAddressMap;
+    AddressIndex<int32_t> __nativeManagedAddressMap;
     
-    map<address_t, address_t> __multicastForwardAddressMap;
-    map<address_t, address_t> __multicastReverseAddressMap;
+    AddressIndex<address_t> __multicastForwardAddressMap;
+    AddressIndex<address_t> __multicastReverseAddressMap;
     
-    HashCaculator __hash;
+    // connection count from nearest root, measured on first reference chain query
+    std::vector<int32_t> __managedRootDistances;
+    std::vector<int32_t> __nativeRootDistances;
 
 public:
     MemorySnapshotCrawler();
@@ -148,13 +276,15 @@ public:
         debug();
     }
     
-    MemorySnapshotCrawler &crawl();
+    // concurrency=0 uses all hardware threads, concurrency=1 crawls serially
+    MemorySnapshotCrawler &crawl(int32_t concurrency = 0);
     
     const char16_t *getString(address_t address, int32_t &size);
     const string getUTFString(address_t address, int32_t &size, bool compactMode = false);
     
     void tryAcceptConnection(EntityConnection &connection);
     void tryAcceptConnection(Connection &connection);
+    void buildManagedGraph();
     
     void trackMStatistics(MemoryState state, int32_t depth = 5);
     void trackNStatistics(MemoryState state, int32_t depth = 5);
@@ -165,8 +295,15 @@ public:
     void findMObject(address_t address);
     void findNObject(address_t address);
     
+    // typeIndex -1 scans whole heap except embedded value type objects
+    void findDuplicateObjects(std::vector<DuplicateGroup> &groups, int32_t typeIndex = -1, int32_t concurrency = 0);
     void dumpRepeatedObjects(int32_t typeIndex, int32_t condition = 2);
     
+    // scans heap sections linearly for object headers, conservative as any word may look like a vtable
+    void sweepHeap(HeapSweep &sweep, int32_t concurrency = 0);
+    void dumpUnreachableObjects(int32_t rank = 20);
+    void dumpDuplicateObjects(int32_t rank = 20);
+    
     void dumpUnbalancedEvents(MemoryState state);
     void listMulticastDelegates();
     void retrieveMulticastDelegate(address_t address);
@@ -196,6 +333,10 @@ public:
     void topMObjects(int32_t rank = 100, address_t address = 0, bool keepAddressOrder = false);
     void topNObjects(int32_t rank = 100);
     
+    void buildDominatorTree();
+    void topRetainers(int32_t rank = 50);
+    void dumpDominatorTree(address_t address, int32_t depth = 2, int32_t rank = 10);
+    
     void statHeap(int32_t rank = 20);
     void inspectHeap(const char *filename = nullptr);
     void drawHeapGraph(const char *filename, bool comparisonEnabled = false);
@@ -207,10 +348,6 @@ public:
     void dumpVRefChain(address_t address);
     void dumpMRefChain(address_t address, bool includeCircular, int32_t route = 2, int32_t depth = -1);
     void dumpNRefChain(address_t address, bool includeCircular, int32_t route = 2, int32_t depth = -1);
-    vector<vector<int32_t>> iterateNRefChain(PackedNativeUnityEngineObject *no, int32_t routeMaximum, int32_t depthMaximum,
-                                             vector<int32_t> chain, set<int64_t> antiCircular, int64_t __iter_capacity = 1, int32_t __iter_depth = 0);
-    vector<vector<int32_t>> iterateMRefChain(ManagedObject *mo, int32_t routeMaximum, int32_t depthMaximum,
-                                             vector<int32_t> chain, set<int64_t> antiCircular, int64_t __iter_capacity = 1, int32_t __iter_depth = 0);
     
     address_t findMObjectOfNObject(address_t address);
     address_t findNObjectOfMObject(address_t address);
@@ -227,8 +364,12 @@ public:
     
     void statSubclasses();
     void dumpSubclassesOf(int32_t typeIndex);
+    vector<int32_t> findSubclassesOfMType(int32_t typeIndex);
+    vector<int32_t> findSubclassesOfNType(int32_t typeIndex);
     
     void compare(MemorySnapshotCrawler &crawler);
+    void compare(SnapshotBaseline &baseline);
+    void dumpDiff(int32_t rank = 20);
     
     ~MemorySnapshotCrawler();
     
@@ -237,15 +378,23 @@ private:
     void crawlGCHandles();
     void crawlStatic();
     void crawlLinks();
+    // workers expand objects ahead of the ordered crawl, at most CRAWL_BACKLOG_LIMIT entries ahead
+    void startParallelCrawling(int32_t concurrency);
+    void stopParallelCrawling();
+    void claimCrawlEntries(int32_t worker, CrawlEntry *begin, CrawlEntry *end);
+    void releaseCrawlRecord(CrawlRecord &record);
     void debug();
     
     int32_t findTypeOfAddress(address_t address);
+    int32_t findTypeOfAddress(address_t address, HeapMemoryReader &memoryReader);
     int32_t findTypeAtTypeAddress(address_t address);
+    int32_t findTypeOfVTable(address_t vtable, HeapMemoryReader &memoryReader, bool cacheNegative = true);
     
-    vector<int32_t> *findVObjectAtAddress(address_t address);
+    AddressRange<int32_t> findVObjectAtAddress(address_t address);
     int32_t findMObjectAtAddress(address_t address);
     int32_t findNObjectAtAddress(address_t address);
     
+    void buildTypeHierarchy();
     bool deriveFromMType(TypeDescription &type, int32_t baseTypeIndex);
     bool deriveFromNType(PackedNativeType &type, int32_t baseTypeIndex);
     bool subclassOf(TypeDescription &type, int32_t baseTypeIndex);
@@ -255,19 +404,28 @@ private:
     ManagedObject &createManagedObject(address_t address, int32_t typeIndex);
     
     bool isCrawlable(TypeDescription &type);
+    void compileReferenceMaps();
     
-    bool crawlManagedArrayAddress(address_t address,
-                                  TypeDescription &type,
-                                  HeapMemoryReader &memoryReader,
-                                  EntityJoint &joint,
-                                  int32_t depth);
+    int32_t resolveEntryType(address_t address, TypeDescription *type, HeapMemoryReader &memoryReader, bool isActualType);
+    
+    void appendCrawlEntry(vector<CrawlEntry> &entries, CrawlEntry &entry,
+                          HeapMemoryReader &memoryReader, HeapMemoryReader &heapReader, int32_t nest);
+    void expandManagedObject(vector<CrawlEntry> &entries, address_t address, TypeDescription &type,
+                             HeapMemoryReader &memoryReader, HeapMemoryReader &heapReader, int32_t nest);
+    void expandManagedArray(vector<CrawlEntry> &entries, address_t address, TypeDescription &type,
+                            HeapMemoryReader &memoryReader, HeapMemoryReader &heapReader, int32_t nest);
+    void expandPointerArray(vector<CrawlEntry> &entries, const char *elements, uint32_t elementCount, TypeDescription &elementType,
+                            HeapMemoryReader &memoryReader, HeapMemoryReader &heapReader, int32_t nest);
+    
+    // entry index is into record entries, or into __crawlingEntries for nullptr record
+    bool acceptManagedEntry(CrawlRecord *source, int32_t index, EntityJoint &joint);
+    bool crawlManagedEntry(CrawlRecord *source, int32_t index, EntityJoint &joint);
     
     bool crawlManagedEntryAddress(address_t address,
                                   TypeDescription *type,
                                   HeapMemoryReader &memoryReader,
                                   EntityJoint &joint,
-                                  bool isRealType,
-                                  int32_t depth);
+                                  bool isRealType);
     bool isPremitiveType(int32_t typeIndex);
     void printPremitiveValue(address_t address, int32_t typeIndex, HeapMemoryReader *explicitReader = nullptr);
     void printByteArray(const char *data, int32_t size);
@@ -275,7 +433,8 @@ private:
     string getNestIndent(const char *__indent, size_t __preindent_size, bool closed);
     void dumpTransform(NativeTransform &transform);
     
-    bool search(std::string &keyword, std::string &content, bool reverseSearching);
+    void printDominatorNode(int32_t node);
+    void dumpDominatorHierarchy(int32_t node, int32_t depth, int32_t rank, const char *indent);
     
     void summarize();
 };
@@ -284,7 +443,7 @@ template<class T>
 InstanceManager<T>::InstanceManager(int32_t deltaCount)
 {
     __deltaCount = deltaCount;
-    __current = new T[__deltaCount];
+    __current = __arena.create<T>(__deltaCount);
     __manager.push_back(__current);
     __nestCursor = 0;
     __cursor = 0;
@@ -302,7 +461,7 @@ T &InstanceManager<T>::add()
         }
         else
         {
-            __current = new T[__deltaCount];
+            __current = __arena.create<T>(__deltaCount);
             __manager.push_back(__current);
         }
         
@@ -317,7 +476,7 @@ template<class T>
 T &InstanceManager<T>::clone(T &item)
 {
     auto &newObject = add();
-    std::memcpy(&newObject, &item, sizeof(item));
+    newObject = item;
     return newObject;
 }
 
@@ -336,8 +495,17 @@ void InstanceManager<T>::rollback()
         __nestCursor = __deltaCount - 1;
     }
     
-    auto *ptr = &(*this)[__cursor];
-    memset(ptr, 0, sizeof(T));
+    (*this)[__cursor] = T();
+}
+
+template<class T>
+void InstanceManager<T>::clear()
+{
+    // keep chunks for reuse, add() hands out items as new
+    for (auto i = 0; i < __cursor; i++) { (*this)[i] = T(); }
+    __current = __manager[0];
+    __nestCursor = 0;
+    __cursor = 0;
 }
 
 template<class T>
@@ -356,10 +524,7 @@ T &InstanceManager<T>::operator[](const int32_t index)
 template<class T>
 InstanceManager<T>::~InstanceManager<T>()
 {
-    for (auto iter = __manager.begin(); iter != __manager.end(); iter++)
-    {
-        delete [] *iter;
-    }
+    __arena.reset();
 }
 
 struct Rectangle
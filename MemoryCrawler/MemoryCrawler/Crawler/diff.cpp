@@ -0,0 +1,330 @@
+//
+//  diff.cpp
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/22.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include "diff.h"
+#include "crawler.h"
+#include "stream.h"
+
+static void sortTable(BaselineTable &table)
+{
+    std::vector<BaselineObject> objects(table.objects.size());
+    std::vector<int32_t> indice(table.indice.size());
+    std::vector<int32_t> order(table.objects.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int32_t a, int32_t b)
+              {
+                  auto &oa = table.objects[a];
+                  auto &ob = table.objects[b];
+                  return oa.address != ob.address ? oa.address < ob.address : a < b;
+              });
+    for (auto i = 0; i < order.size(); i++)
+    {
+        objects[i] = table.objects[order[i]];
+        indice[i] = table.indice[order[i]];
+    }
+    std::swap(objects, table.objects);
+    std::swap(indice, table.indice);
+}
+
+void SnapshotBaseline::capture(MemorySnapshotCrawler &crawler)
+{
+    auto snapshot = crawler.snapshot;
+    uuid = snapshot->uuid;
+
+    auto &typeDescriptions = *snapshot->typeDescriptions;
+    managed.types.resize(typeDescriptions.size);
+    for (auto i = 0; i < typeDescriptions.size; i++)
+    {
+        auto &type = typeDescriptions[i];
+        managed.types[i] = BaselineType{type.name, type.typeInfoAddress};
+    }
+
+    managed.objects.clear();
+    managed.indice.clear();
+    for (auto i = 0; i < crawler.managedObjects.size(); i++)
+    {
+        auto &mo = crawler.managedObjects[i];
+        if (mo.isValueType) {continue;}
+        managed.objects.push_back(BaselineObject{mo.address, mo.typeIndex, mo.size});
+        managed.indice.push_back(i);
+    }
+    sortTable(managed);
+
+    auto &nativeTypes = *snapshot->nativeTypes;
+    native.types.resize(nativeTypes.size);
+    for (auto i = 0; i < nativeTypes.size; i++)
+    {
+        native.types[i] = BaselineType{nativeTypes[i].name, 0};
+    }
+
+    auto &nativeObjects = *snapshot->nativeObjects;
+    native.objects.resize(nativeObjects.size);
+    native.indice.resize(nativeObjects.size);
+    for (auto i = 0; i < nativeObjects.size; i++)
+    {
+        auto &no = nativeObjects[i];
+        native.objects[i] = BaselineObject{no.nativeObjectAddress, no.nativeTypeArrayIndex, no.size};
+        native.indice[i] = i;
+    }
+    sortTable(native);
+
+    sections.clear();
+    if (snapshot->sortedHeapSections == nullptr) {return;} // restored from cache without heap
+    auto &heapSections = *snapshot->sortedHeapSections;
+    sections.resize(heapSections.size());
+    for (auto i = 0; i < heapSections.size(); i++)
+    {
+        auto s = heapSections[i];
+        sections[i] = MemoryFragment(s->startAddress, (uint32_t)s->size, i);
+    }
+}
+
+static void writeTable(FileStream &fs, BaselineTable &table)
+{
+    fs.write<int32_t>((int32_t)table.types.size());
+    for (auto iter = table.types.begin(); iter != table.types.end(); iter++)
+    {
+        fs.writeUTFString(iter->name.c_str());
+        fs.write<address_t>(iter->typeInfoAddress);
+    }
+
+    fs.write<int32_t>((int32_t)table.objects.size());
+    fs.write((const char *)table.objects.data(), (int32_t)(table.objects.size() * sizeof(BaselineObject)));
+}
+
+// bytes left in reading stream, counts read from file are checked against it before any allocation
+static size_t remain(FileStream &fs)
+{
+    auto position = fs.tell();
+    return position < fs.size() ? fs.size() - position : 0;
+}
+
+static bool readCount(FileStream &fs, size_t unitSize, size_t &count)
+{
+    auto value = fs.readInt32();
+    if (!fs.byteAvailable() || value < 0 || (size_t)value > remain(fs) / unitSize) {return false;}
+    count = value;
+    return true;
+}
+
+static bool readTable(FileStream &fs, BaselineTable &table)
+{
+    size_t count;
+    if (!readCount(fs, sizeof(uint32_t) + sizeof(address_t), count)) {return false;}
+    table.types.resize(count);
+    for (auto iter = table.types.begin(); iter != table.types.end(); iter++)
+    {
+        size_t length;
+        if (!readCount(fs, 1, length)) {return false;}
+        iter->name = fs.readString(length);
+        iter->typeInfoAddress = fs.readUInt64();
+        if (!fs.byteAvailable()) {return false;}
+    }
+
+    if (!readCount(fs, sizeof(BaselineObject), count)) {return false;}
+    table.objects.resize(count);
+    fs.readArray(table.objects.data(), table.objects.size());
+    if (!fs.byteAvailable()) {return false;}
+    
+    // merge indexes types by typeIndex and walks objects in address order
+    auto typeCount = (int32_t)table.types.size();
+    for (auto i = 0; i < count; i++)
+    {
+        auto &o = table.objects[i];
+        if (o.typeIndex < 0 || o.typeIndex >= typeCount) {return false;}
+        if (i > 0 && o.address < table.objects[i - 1].address) {return false;}
+    }
+    table.indice.resize(table.objects.size());
+    std::iota(table.indice.begin(), table.indice.end(), 0);
+    return true;
+}
+
+bool SnapshotBaseline::save(const char *filepath)
+{
+    FileStream fs;
+    fs.open(filepath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    if (!fs.isOpen()) {return false;}
+
+    fs.write<uint32_t>(MAGIC);
+    fs.write<uint32_t>(VERSION);
+    fs.writeUTFString(uuid.c_str());
+    writeTable(fs, managed);
+    writeTable(fs, native);
+
+    fs.write<int32_t>((int32_t)sections.size());
+    fs.write((const char *)sections.data(), (int32_t)(sections.size() * sizeof(MemoryFragment)));
+    fs.close();
+    return fs.good();
+}
+
+bool SnapshotBaseline::load(const char *filepath)
+{
+    FileStream fs;
+    fs.open(filepath);
+    auto success = fs.readUInt32() == MAGIC && fs.readUInt32() == VERSION && fs.byteAvailable();
+
+    size_t length = 0;
+    success = success && readCount(fs, 1, length);
+    if (success) {uuid = fs.readString(length);}
+    success = success && fs.byteAvailable();
+    success = success && readTable(fs, managed);
+    success = success && readTable(fs, native);
+
+    size_t count = 0;
+    success = success && readCount(fs, sizeof(MemoryFragment), count);
+    if (success)
+    {
+        sections.resize(count);
+        fs.readArray(sections.data(), sections.size());
+        success = fs.byteAvailable();
+        for (auto i = 1; success && i < count; i++)
+        {
+            success = sections[i - 1].address <= sections[i].address;
+        }
+    }
+    fs.close();
+
+    if (!success)
+    {
+        uuid.clear();
+        managed = BaselineTable();
+        native = BaselineTable();
+        sections.clear();
+    }
+    return success;
+}
+
+void SnapshotDiff::merge(const BaselineTable &current, const BaselineTable &baseline, ObjectDelta &delta, std::vector<MemoryState> &states)
+{
+    delta = ObjectDelta();
+
+    // match types of both tables by name
+    std::unordered_map<std::string, int32_t> slots;
+    std::vector<int32_t> currentSlots(current.types.size());
+    std::vector<int32_t> baselineSlots(baseline.types.size());
+    auto locate = [&](const std::string &name)
+    {
+        auto iter = slots.find(name);
+        if (iter != slots.end()) {return iter->second;}
+        auto slot = (int32_t)delta.types.size();
+        slots.insert(std::make_pair(name, slot));
+        delta.types.emplace_back();
+        delta.types.back().name = name;
+        return slot;
+    };
+    for (auto i = 0; i < current.types.size(); i++) { currentSlots[i] = locate(current.types[i].name); }
+    for (auto i = 0; i < baseline.types.size(); i++) { baselineSlots[i] = locate(baseline.types[i].name); }
+
+    auto &objects = current.objects;
+    auto &referObjects = baseline.objects;
+    states.assign(objects.size(), MS_allocated);
+
+    auto allocate = [&](size_t i)
+    {
+        auto &o = objects[i];
+        auto &t = delta.types[currentSlots[o.typeIndex]];
+        t.count[1] += 1;
+        t.memory[1] += o.size;
+        delta.allocatedCount += 1;
+        delta.allocatedMemory += o.size;
+    };
+
+    auto release = [&](size_t j)
+    {
+        auto &o = referObjects[j];
+        auto &t = delta.types[baselineSlots[o.typeIndex]];
+        t.count[0] += 1;
+        t.memory[0] += o.size;
+        delta.freedCount += 1;
+        delta.freedMemory += o.size;
+    };
+
+    size_t i = 0, j = 0;
+    while (i < objects.size() || j < referObjects.size())
+    {
+        if (j == referObjects.size() || (i < objects.size() && objects[i].address < referObjects[j].address))
+        {
+            allocate(i++);
+        }
+        else if (i == objects.size() || referObjects[j].address < objects[i].address)
+        {
+            release(j++);
+        }
+        else
+        {
+            auto &typeA = current.types[objects[i].typeIndex];
+            auto &typeB = baseline.types[referObjects[j].typeIndex];
+            auto identical = typeA.typeInfoAddress != 0 || typeB.typeInfoAddress != 0 ? typeA.typeInfoAddress == typeB.typeInfoAddress : typeA.name == typeB.name;
+            if (identical)
+            {
+                auto &o = objects[i];
+                auto &t = delta.types[currentSlots[o.typeIndex]];
+                t.count[1] += 1;
+                t.memory[1] += o.size;
+                t.count[0] += 1;
+                t.memory[0] += referObjects[j].size;
+                delta.survivedCount += 1;
+                delta.survivedMemory += o.size;
+                states[i] = MS_persistent;
+                ++i; ++j;
+            }
+            else
+            {
+                allocate(i++);
+                release(j++);
+            }
+        }
+    }
+}
+
+void SnapshotDiff::merge(const std::vector<MemoryFragment> &sections, const std::vector<MemoryFragment> &referSections, std::vector<MemoryConcation> &concations)
+{
+    concations.clear();
+    auto position = 0;
+    for (auto i = 0; i < sections.size(); i++)
+    {
+        auto &s = sections[i];
+        MemoryConcation concat(s.address, s.size, i, CT_IDENTICAL);
+        while(position < referSections.size())
+        {
+            auto &rs = referSections[position];
+            if (rs.address < s.address)
+            {
+                ++position;
+                concations.emplace_back(MemoryConcation(rs.address, rs.size, position, CT_DEALLOC));
+            }
+            else if (rs.address >= s.address && rs.address + rs.size <= s.address + s.size)
+            {
+                concat.fragments.emplace_back(MemoryFragment(rs.address, rs.size, position));
+                ++position;
+            } else {break;}
+        }
+        switch (concat.fragments.size())
+        {
+            case 0:
+            {
+                concat.type = CT_ALLOC;
+            } break;
+
+            case 1:
+            {
+                auto &frag = concat.fragments[0];
+                concat.type = (frag.address == concat.address && frag.size == concat.size) ? CT_IDENTICAL : CT_CONCAT;
+            } break;
+
+            default:
+            {
+                concat.type = CT_CONCAT;
+            } break;
+        }
+        concations.emplace_back(concat);
+    }
+}
@@ -0,0 +1,93 @@
+//
+//  diff.h
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/22.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#ifndef diff_h
+#define diff_h
+
+#include <string>
+#include <vector>
+#include "types.h"
+#include "snapshot.h"
+#include "fragment.h"
+
+class MemorySnapshotCrawler;
+
+struct BaselineObject
+{
+    address_t address;
+    int32_t typeIndex;
+    int32_t size;
+};
+
+struct BaselineType
+{
+    std::string name;
+    address_t typeInfoAddress; // 0 for native types
+};
+
+// objects of one kind sorted by address
+struct BaselineTable
+{
+    std::vector<BaselineType> types;
+    std::vector<BaselineObject> objects;
+    std::vector<int32_t> indice; // object index in captured crawler, not persisted
+};
+
+// compact address sorted view of a crawled snapshot, can be saved and compared without re-crawling
+class SnapshotBaseline
+{
+public:
+    std::string uuid;
+    BaselineTable managed;
+    BaselineTable native;
+    std::vector<MemoryFragment> sections;
+
+    void capture(MemorySnapshotCrawler &crawler);
+
+    bool save(const char *filepath);
+    bool load(const char *filepath);
+
+private:
+    static constexpr uint32_t MAGIC = 0x4C42434D; // MCBL
+    static constexpr uint32_t VERSION = 1;
+};
+
+struct TypeDelta
+{
+    std::string name;
+    int32_t count[2] = {0, 0}; // baseline, current
+    int64_t memory[2] = {0, 0};
+};
+
+struct ObjectDelta
+{
+    int32_t allocatedCount = 0;
+    int32_t freedCount = 0;
+    int32_t survivedCount = 0;
+    int64_t allocatedMemory = 0;
+    int64_t freedMemory = 0;
+    int64_t survivedMemory = 0;
+    std::vector<TypeDelta> types;
+};
+
+class SnapshotDiff
+{
+public:
+    std::string uuid;
+    ObjectDelta managed;
+    ObjectDelta native;
+
+    bool empty() const { return uuid.size() == 0; }
+
+    // linear merge of address sorted tables, states[i] is the state of current.objects[i]
+    // objects survive with same address and type, type identity is typeInfoAddress if present otherwise type name
+    static void merge(const BaselineTable &current, const BaselineTable &baseline, ObjectDelta &delta, std::vector<MemoryState> &states);
+    static void merge(const std::vector<MemoryFragment> &current, const std::vector<MemoryFragment> &baseline, std::vector<MemoryConcation> &concations);
+};
+
+#endif /* diff_h */
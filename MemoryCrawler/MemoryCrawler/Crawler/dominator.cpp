@@ -0,0 +1,160 @@
+//
+//  dominator.cpp
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/20.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#include "dominator.h"
+
+void DominatorTree::build(const std::vector<int32_t> &offsets, const std::vector<int32_t> &edges, const std::vector<int64_t> &sizes)
+{
+    clear();
+
+    int32_t nodeCount = (int32_t)offsets.size() - 1;
+    if (nodeCount <= 0) {return;}
+
+    // predecessors in CSR layout
+    std::vector<int32_t> predOffsets(nodeCount + 1, 0);
+    for (auto i = 0; i < edges.size(); i++) { ++predOffsets[edges[i] + 1]; }
+    for (auto i = 1; i <= nodeCount; i++) { predOffsets[i] += predOffsets[i - 1]; }
+    std::vector<int32_t> predEdges(edges.size());
+    {
+        std::vector<int32_t> cursors(predOffsets.begin(), predOffsets.end() - 1);
+        for (auto n = 0; n < nodeCount; n++)
+        {
+            for (auto i = offsets[n]; i < offsets[n + 1]; i++) { predEdges[cursors[edges[i]]++] = n; }
+        }
+    }
+
+    // preorder numbering with explicit stack, unreachable nodes are visited from root after its real edges
+    std::vector<int32_t> order(nodeCount);
+    std::vector<int32_t> numbers(nodeCount, -1);
+    std::vector<int32_t> parents(nodeCount, -1);
+    std::vector<uint8_t> adopted(nodeCount, 0);
+    {
+        std::vector<std::pair<int32_t, int32_t>> stack;
+        int32_t count = 0;
+        int32_t orphan = 1;
+        numbers[0] = count;
+        order[count++] = 0;
+        stack.emplace_back(0, offsets[0]);
+        while (count < nodeCount)
+        {
+            if (stack.empty())
+            {
+                while (numbers[orphan] >= 0) {++orphan;}
+                numbers[orphan] = count;
+                parents[count] = 0;
+                adopted[orphan] = 1;
+                order[count++] = orphan;
+                stack.emplace_back(orphan, offsets[orphan]);
+            }
+
+            auto &top = stack.back();
+            auto node = top.first;
+            if (top.second == offsets[node + 1]) { stack.pop_back(); continue; }
+
+            auto next = edges[top.second++];
+            if (numbers[next] >= 0) {continue;}
+            numbers[next] = count;
+            parents[count] = numbers[node];
+            order[count++] = next;
+            stack.emplace_back(next, offsets[next]);
+        }
+    }
+
+    // semi dominators and immediate dominators in preorder numbers
+    std::vector<int32_t> semis(nodeCount);
+    std::vector<int32_t> labels(nodeCount);
+    std::vector<int32_t> ancestors(nodeCount, -1);
+    std::vector<int32_t> idoms(nodeCount, 0);
+    std::vector<int32_t> bucketHeads(nodeCount, -1);
+    std::vector<int32_t> bucketNexts(nodeCount, -1);
+    for (auto i = 0; i < nodeCount; i++) { semis[i] = labels[i] = i; }
+
+    std::vector<int32_t> path;
+    auto eval = [&](int32_t v)
+    {
+        if (ancestors[v] == -1) {return v;}
+        path.clear();
+        for (auto x = v; ancestors[ancestors[x]] != -1; x = ancestors[x]) { path.push_back(x); }
+        for (auto iter = path.rbegin(); iter != path.rend(); iter++)
+        {
+            auto x = *iter;
+            auto a = ancestors[x];
+            if (semis[labels[a]] < semis[labels[x]]) {labels[x] = labels[a];}
+            ancestors[x] = ancestors[a];
+        }
+        return labels[v];
+    };
+
+    for (auto w = nodeCount - 1; w > 0; w--)
+    {
+        auto node = order[w];
+        if (adopted[node]) {semis[w] = 0;}
+        for (auto i = predOffsets[node]; i < predOffsets[node + 1]; i++)
+        {
+            auto u = eval(numbers[predEdges[i]]);
+            if (semis[u] < semis[w]) {semis[w] = semis[u];}
+        }
+
+        bucketNexts[w] = bucketHeads[semis[w]];
+        bucketHeads[semis[w]] = w;
+
+        auto p = parents[w];
+        ancestors[w] = p;
+        for (auto v = bucketHeads[p]; v != -1; v = bucketNexts[v])
+        {
+            auto u = eval(v);
+            idoms[v] = semis[u] < semis[v] ? u : p;
+        }
+        bucketHeads[p] = -1;
+    }
+
+    for (auto w = 1; w < nodeCount; w++)
+    {
+        if (idoms[w] != semis[w]) {idoms[w] = idoms[idoms[w]];}
+    }
+
+    // retained sizes accumulate in reverse preorder since dominators precede their children
+    __dominators.resize(nodeCount);
+    __retainedSizes.assign(sizes.begin(), sizes.begin() + nodeCount);
+    __dominators[0] = -1;
+    for (auto w = nodeCount - 1; w > 0; w--)
+    {
+        auto node = order[w];
+        auto dominator = order[idoms[w]];
+        __dominators[node] = dominator;
+        __retainedSizes[dominator] += __retainedSizes[node];
+    }
+
+    __childOffsets.assign(nodeCount + 1, 0);
+    for (auto n = 1; n < nodeCount; n++) { ++__childOffsets[__dominators[n] + 1]; }
+    for (auto n = 1; n <= nodeCount; n++) { __childOffsets[n] += __childOffsets[n - 1]; }
+    __children.resize(nodeCount - 1);
+    std::vector<int32_t> cursors(__childOffsets.begin(), __childOffsets.end() - 1);
+    for (auto n = 1; n < nodeCount; n++) { __children[cursors[__dominators[n]]++] = n; }
+}
+
+EdgeRange DominatorTree::children(int32_t node) const
+{
+    if (node < 0 || node + 1 >= __childOffsets.size()) {return EdgeRange{nullptr, nullptr};}
+    auto data = __children.data();
+    return EdgeRange{data + __childOffsets[node], data + __childOffsets[node + 1]};
+}
+
+size_t DominatorTree::memory() const
+{
+    return (__dominators.capacity() + __childOffsets.capacity() + __children.capacity()) * sizeof(int32_t)
+         + __retainedSizes.capacity() * sizeof(int64_t);
+}
+
+void DominatorTree::clear()
+{
+    std::vector<int32_t>().swap(__dominators);
+    std::vector<int64_t>().swap(__retainedSizes);
+    std::vector<int32_t>().swap(__childOffsets);
+    std::vector<int32_t>().swap(__children);
+}
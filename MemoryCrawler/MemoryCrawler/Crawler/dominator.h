@@ -0,0 +1,39 @@
+//
+//  dominator.h
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/20.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#ifndef dominator_h
+#define dominator_h
+
+#include <vector>
+#include "graph.h"
+
+// Dominator tree of a graph in CSR layout rooted at node 0, nodes unreachable from root are adopted by root.
+class DominatorTree
+{
+    std::vector<int32_t> __dominators;
+    std::vector<int64_t> __retainedSizes;
+    std::vector<int32_t> __childOffsets;
+    std::vector<int32_t> __children;
+
+public:
+    // Lengauer-Tarjan with path compression, sizes are shallow sizes of nodes
+    void build(const std::vector<int32_t> &offsets, const std::vector<int32_t> &edges, const std::vector<int64_t> &sizes);
+
+    bool empty() const { return __dominators.empty(); }
+    int32_t size() const { return (int32_t)__dominators.size(); }
+
+    // immediate dominator, -1 for root
+    int32_t dominator(int32_t node) const { return __dominators[node]; }
+    int64_t retainedSize(int32_t node) const { return __retainedSizes[node]; }
+    EdgeRange children(int32_t node) const;
+
+    size_t memory() const;
+    void clear();
+};
+
+#endif /* dominator_h */
@@ -0,0 +1,130 @@
+//
+//  graph.h
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/18.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#ifndef graph_h
+#define graph_h
+
+#include <vector>
+#include <cassert>
+#include "snapshot.h"
+
+struct EdgeRange
+{
+    const int32_t *first;
+    const int32_t *last;
+
+    const int32_t *begin() const { return first; }
+    const int32_t *end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    int32_t operator[](size_t index) const { return first[index]; }
+};
+
+// Connection indice of managed objects in CSR layout, edges of one object keep connection order
+class ConnectionGraph
+{
+    std::vector<int32_t> __fromOffsets;
+    std::vector<int32_t> __fromEdges;
+    std::vector<int32_t> __toOffsets;
+    std::vector<int32_t> __toEdges;
+    bool __built = false;
+
+public:
+    // count degrees while connections are created
+    void accept(const Connection &connection);
+
+    // fill edges after all connections are accepted
+    template <class C>
+    void build(C &connections, int32_t nodeCount);
+
+    EdgeRange fromConnections(int32_t index) const { return range(__fromOffsets, __fromEdges, index); }
+    EdgeRange toConnections(int32_t index) const { return range(__toOffsets, __toEdges, index); }
+
+    size_t memory() const;
+    bool built() const { return __built; }
+
+    // drop edges and degrees so that connections can be accepted again
+    void clear();
+
+private:
+    static void count(std::vector<int32_t> &offsets, int32_t index);
+    static void prepare(std::vector<int32_t> &offsets, std::vector<int32_t> &edges, int32_t nodeCount);
+    static EdgeRange range(const std::vector<int32_t> &offsets, const std::vector<int32_t> &edges, int32_t index);
+};
+
+inline void ConnectionGraph::count(std::vector<int32_t> &offsets, int32_t index)
+{
+    // offsets[index + 1] holds degree before build
+    if (index + 2 > offsets.size()) {offsets.resize(index + 2, 0);}
+    ++offsets[index + 1];
+}
+
+inline void ConnectionGraph::accept(const Connection &connection)
+{
+    assert(!__built);
+    if (connection.fromKind == CK_managed && connection.from >= 0) {count(__toOffsets, connection.from);}
+    if (connection.toKind == CK_managed && connection.to >= 0) {count(__fromOffsets, connection.to);}
+}
+
+inline void ConnectionGraph::prepare(std::vector<int32_t> &offsets, std::vector<int32_t> &edges, int32_t nodeCount)
+{
+    offsets.resize(nodeCount + 1, 0);
+    for (auto i = 1; i <= nodeCount; i++) { offsets[i] += offsets[i - 1]; }
+    edges.resize(offsets[nodeCount]);
+    edges.shrink_to_fit();
+}
+
+template <class C>
+void ConnectionGraph::build(C &connections, int32_t nodeCount)
+{
+    // degrees are turned into offsets in place, call clear() and accept again before rebuilding
+    assert(!__built);
+    __built = true;
+
+    prepare(__fromOffsets, __fromEdges, nodeCount);
+    prepare(__toOffsets, __toEdges, nodeCount);
+
+    std::vector<int32_t> fromCursors(__fromOffsets.begin(), __fromOffsets.end() - 1);
+    std::vector<int32_t> toCursors(__toOffsets.begin(), __toOffsets.end() - 1);
+    for (auto i = 0; i < connections.size(); i++)
+    {
+        auto &connection = connections[i];
+        if (connection.fromKind == CK_managed && connection.from >= 0 && connection.from < nodeCount)
+        {
+            __toEdges[toCursors[connection.from]++] = connection.connectionArrayIndex;
+        }
+
+        if (connection.toKind == CK_managed && connection.to >= 0 && connection.to < nodeCount)
+        {
+            __fromEdges[fromCursors[connection.to]++] = connection.connectionArrayIndex;
+        }
+    }
+}
+
+inline EdgeRange ConnectionGraph::range(const std::vector<int32_t> &offsets, const std::vector<int32_t> &edges, int32_t index)
+{
+    if (index < 0 || index + 1 >= offsets.size()) {return EdgeRange{nullptr, nullptr};}
+    auto data = edges.data();
+    return EdgeRange{data + offsets[index], data + offsets[index + 1]};
+}
+
+inline size_t ConnectionGraph::memory() const
+{
+    return (__fromOffsets.capacity() + __fromEdges.capacity() + __toOffsets.capacity() + __toEdges.capacity()) * sizeof(int32_t);
+}
+
+inline void ConnectionGraph::clear()
+{
+    std::vector<int32_t>().swap(__fromOffsets);
+    std::vector<int32_t>().swap(__fromEdges);
+    std::vector<int32_t>().swap(__toOffsets);
+    std::vector<int32_t>().swap(__toEdges);
+    __built = false;
+}
+
+#endif /* graph_h */
@@ -0,0 +1,71 @@
+//
+//  hash.cpp
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/28.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#include <cstring>
+#include "hash.h"
+
+static constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87;
+static constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4F;
+static constexpr uint64_t PRIME3 = 0x165667B19E3779F9;
+static constexpr uint64_t PRIME4 = 0x85EBCA77C2B2AE63;
+
+static inline uint64_t rotl(uint64_t v, int32_t bits) { return (v << bits) | (v >> (64 - bits)); }
+
+static inline uint64_t read64(const uint8_t *ptr)
+{
+    uint64_t v;
+    memcpy(&v, ptr, 8);
+    return v;
+}
+
+static inline uint64_t avalanche(uint64_t h)
+{
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9;
+    h ^= h >> 32;
+    return h;
+}
+
+Hash128 hash128(const void *data, size_t size, uint64_t seed)
+{
+    auto ptr = (const uint8_t *)data;
+    auto end = ptr + size;
+
+    uint64_t lanes[4] = {seed + PRIME1 + PRIME2, seed + PRIME2, seed, seed - PRIME1};
+    while (ptr + 32 <= end)
+    {
+        for (auto i = 0; i < 4; i++)
+        {
+            lanes[i] = rotl(lanes[i] + read64(ptr + 8 * i) * PRIME2, 31) * PRIME1;
+        }
+        ptr += 32;
+    }
+
+    auto low = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18) + size * PRIME4;
+    auto high = (lanes[0] ^ rotl(lanes[3], 29)) * PRIME3 + (lanes[1] ^ rotl(lanes[2], 41)) * PRIME4 + (seed ^ size);
+
+    while (ptr + 8 <= end)
+    {
+        auto v = read64(ptr);
+        low = rotl(low ^ (v * PRIME2), 27) * PRIME1 + PRIME4;
+        high = rotl(high + v * PRIME3, 31) * PRIME2;
+        ptr += 8;
+    }
+
+    while (ptr < end)
+    {
+        low = rotl(low ^ (*ptr * PRIME3), 11) * PRIME1;
+        high = rotl(high ^ (*ptr * PRIME1), 23) * PRIME3;
+        ptr++;
+    }
+
+    Hash128 hash;
+    hash.low = avalanche(low + rotl(high, 17));
+    hash.high = avalanche(high ^ (low * PRIME2));
+    return hash;
+}
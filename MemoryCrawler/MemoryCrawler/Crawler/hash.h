@@ -0,0 +1,28 @@
+//
+//  hash.h
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/28.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#ifndef hash_h
+#define hash_h
+
+#include <cstddef>
+#include <cstdint>
+
+struct Hash128
+{
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    bool operator==(const Hash128 &v) const { return low == v.low && high == v.high; }
+    bool operator!=(const Hash128 &v) const { return !(*this == v); }
+    bool operator<(const Hash128 &v) const { return high != v.high ? high < v.high : low < v.low; }
+};
+
+// non-cryptographic content hash, four independent 64-bit lanes over 32-byte stripes so compiler can vectorize them
+Hash128 hash128(const void *data, size_t size, uint64_t seed = 0);
+
+#endif /* hash_h */
@@ -8,17 +8,144 @@
 
 #include "heap.h"
 #include <vector>
+#include <algorithm>
+
+HeapAddressTable::HeapAddressTable(std::vector<MemorySection *> &sortedHeapSections): __sections(&sortedHeapSections)
+{
+    for (int32_t i = (int32_t)sortedHeapSections.size() - 1; i >= 0; i--)
+    {
+        auto &heap = *sortedHeapSections[i];
+        if (heap.bytes == nullptr || heap.bytes->size == 0) {continue;}
+        
+        // walk backwards so that every page keeps the first section overlapping it
+        auto first = heap.startAddress >> PAGE_BITS;
+        auto last = (heap.startAddress + heap.bytes->size - 1) >> PAGE_BITS;
+        for (auto page = first; page <= last; page++)
+        {
+            auto &chunk = createChunk(page >> (CHUNK_BITS - PAGE_BITS));
+            chunk.pages[page & ((1 << (CHUNK_BITS - PAGE_BITS)) - 1)] = i;
+        }
+    }
+}
+
+HeapAddressTable::Chunk &HeapAddressTable::createChunk(address_t key)
+{
+    auto iter = std::lower_bound(__chunks.begin(), __chunks.end(), key, [](const Chunk &chunk, address_t key)
+                                 {
+                                     return chunk.key < key;
+                                 });
+    if (iter == __chunks.end() || iter->key != key)
+    {
+        iter = __chunks.insert(iter, Chunk{key, std::vector<int32_t>(1 << (CHUNK_BITS - PAGE_BITS), -1)});
+    }
+    return *iter;
+}
+
+int32_t HeapAddressTable::find(address_t address, int64_t &probes) const
+{
+    auto key = address >> CHUNK_BITS;
+    auto iter = std::lower_bound(__chunks.begin(), __chunks.end(), key, [](const Chunk &chunk, address_t key)
+                                 {
+                                     return chunk.key < key;
+                                 });
+    if (iter == __chunks.end() || iter->key != key) {return -1;}
+    
+    auto index = iter->pages[(address & ((1ull << CHUNK_BITS) - 1)) >> PAGE_BITS];
+    if (index == -1) {return -1;}
+    
+    auto &sections = *__sections;
+    for (; index < sections.size(); index++)
+    {
+        ++probes;
+        auto &heap = *sections[index];
+        if (heap.startAddress > address) {break;}
+        if (heap.bytes != nullptr && address < heap.startAddress + heap.bytes->size) {return index;}
+    }
+    
+    return -1;
+}
+
+void HeapLookupStats::merge(const HeapLookupStats &stats)
+{
+    lookups += stats.lookups;
+    hits += stats.hits;
+    cacheHits += stats.cacheHits;
+    tableHits += stats.tableHits;
+    probes += stats.probes;
+    misses += stats.misses;
+}
+
+string HeapLookupStats::summary() const
+{
+    auto total = (double)std::max<int64_t>(lookups, 1);
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "lookups=%lld hit=%.2f%% cache=%.2f%% table=%.2f%% miss=%.2f%% probes=%.2f",
+             lookups, hits * 100 / total, cacheHits * 100 / total, tableHits * 100 / total, misses * 100 / total,
+             (double)probes / std::max<int64_t>(tableHits + misses, 1));
+    return buffer;
+}
+
+void TypeResolveStats::merge(const TypeResolveStats &stats)
+{
+    lookups += stats.lookups;
+    direct += stats.direct;
+    hits += stats.hits;
+    negativeHits += stats.negativeHits;
+    misses += stats.misses;
+    nulls += stats.nulls;
+    dropped += stats.dropped;
+}
+
+string TypeResolveStats::summary() const
+{
+    auto total = (double)std::max<int64_t>(lookups, 1);
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "resolves=%lld direct=%.2f%% vtable=%.2f%% negative=%.2f%% miss=%.2f%% null=%.2f%% dropped=%lld",
+             lookups, direct * 100 / total, hits * 100 / total, negativeHits * 100 / total, misses * 100 / total, nulls * 100 / total, dropped);
+    return buffer;
+}
 
 int32_t HeapMemoryReader::seekOffset(address_t address)
 {
     if (address == 0) {return -1;}
+    ++__stats.lookups;
     if (address >= __startAddress && address < __stopAddress)
     {
+        ++__stats.hits;
         return (int32_t)(address - __startAddress);
     }
     
+    for (auto i = 0; i < CACHE_SIZE; i++)
+    {
+        auto &entry = __cache[i];
+        if (address >= entry.startAddress && address < entry.stopAddress)
+        {
+            ++__stats.cacheHits;
+            std::swap(entry.startAddress, __startAddress);
+            std::swap(entry.stopAddress, __stopAddress);
+            std::swap(entry.memory, __memory);
+            std::swap(entry.size, __size);
+            return (int32_t)(address - __startAddress);
+        }
+    }
+    
     auto heapIndex = findHeapOfAddress(address);
-    if (heapIndex == -1) {return -1;}
+    if (heapIndex == -1)
+    {
+        ++__stats.misses;
+        return -1;
+    }
+    ++__stats.tableHits;
+    
+    if (__memory != nullptr)
+    {
+        auto &entry = __cache[__cacheCursor];
+        entry.startAddress = __startAddress;
+        entry.stopAddress = __stopAddress;
+        entry.memory = __memory;
+        entry.size = __size;
+        __cacheCursor = (__cacheCursor + 1) % CACHE_SIZE;
+    }
     
     MemorySection &heap = *(*__sortedHeapSections)[heapIndex];
     __memory = heap.bytes->items;
@@ -59,6 +186,14 @@ const char *HeapMemoryReader::readMemory(address_t address)
     return (const char *)(__memory + offset);
 }
 
+const char *HeapMemoryReader::readMemory(address_t address, int32_t size)
+{
+    auto offset = seekOffset(address);
+    if (offset == -1 || (int64_t)offset + size > __size) {return nullptr;}
+    
+    return (const char *)(__memory + offset);
+}
+
 const char16_t *HeapMemoryReader::readString(address_t address, int32_t &size)
 {
     auto offset = seekOffset(address);
@@ -69,6 +204,7 @@ const char16_t *HeapMemoryReader::readString(address_t address, int32_t &size)
     size <<= 1;
     
     offset += 4;
+    if ((int64_t)offset + size > __size) {return nullptr;} // truncated by heap section
     return (char16_t *)(__memory + offset);
 }
 
@@ -140,12 +276,18 @@ HeapSegment HeapMemoryReader::readObjectMemory(address_t address, TypeDescriptio
 
 int32_t HeapMemoryReader::findHeapOfAddress(address_t address)
 {
+    if (__snapshot->heapAddressTable != nullptr)
+    {
+        return __snapshot->heapAddressTable->find(address, __stats.probes);
+    }
+    
     std::vector<MemorySection *> &heapSections = *__sortedHeapSections;
     int32_t min = 0, max = (int32_t)heapSections.size() - 1;
     
     while (min <= max)
     {
         auto mid = (min + max) >> 1;
+        ++__stats.probes;
         MemorySection &heap = *heapSections[mid];
         if (heap.startAddress > address)
         {
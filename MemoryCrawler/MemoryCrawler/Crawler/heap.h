@@ -9,6 +9,8 @@
 #ifndef heap_h
 #define heap_h
 
+#include <cstring>
+#include <vector>
 #include "types.h"
 #include "snapshot.h"
 
@@ -26,17 +28,83 @@ struct HeapSegment
     }
 };
 
+// Translates address to sorted heap section index with 64KB pages grouped into 4GB chunks
+class HeapAddressTable
+{
+    static constexpr int32_t PAGE_BITS = 16;
+    static constexpr int32_t CHUNK_BITS = 32;
+    
+    struct Chunk
+    {
+        address_t key;
+        std::vector<int32_t> pages; // first section that overlaps page
+    };
+    
+    std::vector<Chunk> __chunks;
+    std::vector<MemorySection *> *__sections;
+    
+public:
+    HeapAddressTable(std::vector<MemorySection *> &sortedHeapSections);
+    
+    int32_t find(address_t address, int64_t &probes) const;
+    
+private:
+    Chunk &createChunk(address_t key);
+};
+
+struct HeapLookupStats
+{
+    int64_t lookups = 0;
+    int64_t hits = 0; // current section
+    int64_t cacheHits = 0; // recent sections
+    int64_t tableHits = 0; // resolved by address table
+    int64_t probes = 0; // sections compared while resolving
+    int64_t misses = 0;
+    
+    void merge(const HeapLookupStats &stats);
+    string summary() const;
+};
+
+struct TypeResolveStats
+{
+    int64_t lookups = 0;
+    int64_t direct = 0; // address is a type info address itself
+    int64_t hits = 0; // vtable resolved before
+    int64_t negativeHits = 0; // vtable known to resolve no type
+    int64_t misses = 0; // resolved by reading vtable->klass
+    int64_t nulls = 0; // no vtable at address
+    int64_t dropped = 0; // resolved vtable not cached, cache is full
+    
+    void merge(const TypeResolveStats &stats);
+    string summary() const;
+};
+
 class HeapMemoryReader
 {
+    struct CacheEntry
+    {
+        address_t startAddress = 0;
+        address_t stopAddress = 0;
+        const byte_t *memory = nullptr;
+        int32_t size = 0;
+    };
+    
+    static constexpr int32_t CACHE_SIZE = 8;
+    
     PackedMemorySnapshot *__snapshot;
     std::vector<MemorySection *> *__sortedHeapSections;
     VirtualMachineInformation *__vm;
     
+    CacheEntry __cache[CACHE_SIZE];
+    int32_t __cacheCursor = 0;
+    
 protected:
     address_t __startAddress = 0;
     address_t __stopAddress = 0;
     const byte_t *__memory = nullptr;
     int32_t __size = 0;
+    HeapLookupStats __stats;
+    TypeResolveStats __resolveStats;
     
     virtual int32_t seekOffset(address_t address);
     
@@ -48,6 +116,9 @@ public:
         __vm = &snapshot->virtualMachineInformation;
     }
     
+    const HeapLookupStats &stats() const { return __stats; }
+    TypeResolveStats &resolveStats() { return __resolveStats; }
+    
     int8_t readInt8(address_t address) { return readScalar<int8_t>(address); }
     int16_t readInt16(address_t address)  { return readScalar<int16_t>(address); }
     int32_t readInt32(address_t address)  { return readScalar<int32_t>(address); }
@@ -77,6 +148,7 @@ public:
     uint32_t readObjectSize(address_t address, TypeDescription &type);
     HeapSegment readObjectMemory(address_t address, TypeDescription &type);
     const char *readMemory(address_t address);
+    const char *readMemory(address_t address, int32_t size); // nullptr if size bytes are not in one section
     
     int32_t findHeapOfAddress(address_t address);
     virtual bool isStatic();
@@ -92,7 +164,10 @@ T HeapMemoryReader::readScalar(address_t address)
     auto offset = seekOffset(address);
     if (offset == -1) {return 0;}
     
-    return *(T *)(__memory + offset);
+    // sections borrowed from a file mapping start at any file offset, so values can be unaligned
+    T v;
+    memcpy(&v, __memory + offset, sizeof(T));
+    return v;
 }
 
 class StaticMemoryReader: public HeapMemoryReader
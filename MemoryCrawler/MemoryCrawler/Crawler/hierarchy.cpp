@@ -0,0 +1,72 @@
+//
+//  hierarchy.cpp
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/29.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#include "hierarchy.h"
+
+void TypeHierarchy::build(const std::vector<int32_t> &parents)
+{
+    auto count = (int32_t)parents.size();
+    
+    // children grouped by parent, ascending type index within group
+    std::vector<int32_t> offsets(count + 1, 0);
+    for (auto i = 0; i < count; i++)
+    {
+        auto parent = parents[i];
+        if (parent >= 0 && parent < count && parent != i) { offsets[parent + 1]++; }
+    }
+    for (auto i = 0; i < count; i++) { offsets[i + 1] += offsets[i]; }
+    
+    std::vector<int32_t> children(offsets[count]);
+    std::vector<int32_t> cursors(offsets.begin(), offsets.end() - 1);
+    for (auto i = 0; i < count; i++)
+    {
+        auto parent = parents[i];
+        if (parent >= 0 && parent < count && parent != i) { children[cursors[parent]++] = i; }
+    }
+    
+    __enters.assign(count, -1);
+    __exits.assign(count, -1);
+    __order.clear();
+    __order.reserve(count);
+    
+    std::vector<std::pair<int32_t, int32_t>> stack; // type, next child slot
+    auto visit = [&](int32_t root)
+    {
+        __enters[root] = (int32_t)__order.size();
+        __order.push_back(root);
+        stack.emplace_back(root, offsets[root]);
+        while (stack.size() > 0)
+        {
+            auto &frame = stack.back();
+            if (frame.second == offsets[frame.first + 1])
+            {
+                __exits[frame.first] = (int32_t)__order.size();
+                stack.pop_back();
+                continue;
+            }
+            
+            auto child = children[frame.second++];
+            if (__enters[child] >= 0) {continue;}
+            __enters[child] = (int32_t)__order.size();
+            __order.push_back(child);
+            stack.emplace_back(child, offsets[child]);
+        }
+    };
+    
+    for (auto i = 0; i < count; i++)
+    {
+        auto parent = parents[i];
+        if (parent < 0 || parent >= count || parent == i) { visit(i); }
+    }
+    
+    // types caught in a base cycle are unreachable from any root, number them as roots
+    for (auto i = 0; i < count; i++)
+    {
+        if (__enters[i] < 0) { visit(i); }
+    }
+}
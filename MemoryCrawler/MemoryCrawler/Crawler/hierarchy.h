@@ -0,0 +1,46 @@
+//
+//  hierarchy.h
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/29.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#ifndef hierarchy_h
+#define hierarchy_h
+
+#include <cstdint>
+#include <vector>
+
+// inheritance forest numbered by preorder, descendants of a type occupy [enter, exit) of that type
+class TypeHierarchy
+{
+    std::vector<int32_t> __enters;
+    std::vector<int32_t> __exits;
+    std::vector<int32_t> __order; // type indice in preorder
+    
+public:
+    // parents[i] is base type of type i, -1 for roots
+    void build(const std::vector<int32_t> &parents);
+    
+    int32_t size() const { return (int32_t)__enters.size(); }
+    
+    // type is base or inherits from base
+    bool derive(int32_t type, int32_t base) const
+    {
+        if (type < 0 || base < 0 || type >= size() || base >= size()) {return false;}
+        auto enter = __enters[type];
+        return enter >= __enters[base] && enter < __exits[base];
+    }
+    
+    // type inherits from base, base itself excluded
+    bool subclass(int32_t type, int32_t base) const { return type != base && derive(type, base); }
+    
+    int32_t countSubclasses(int32_t base) const { return __exits[base] - __enters[base] - 1; }
+    
+    // all descendants of base in preorder
+    const int32_t *beginSubclasses(int32_t base) const { return __order.data() + __enters[base] + 1; }
+    const int32_t *endSubclasses(int32_t base) const { return __order.data() + __exits[base]; }
+};
+
+#endif /* hierarchy_h */
@@ -0,0 +1,152 @@
+//
+//  intern.cpp
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/27.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#include <algorithm>
+#include <cassert>
+#include "intern.h"
+
+uint64_t StringPool::hash(const char *text, size_t length)
+{
+    uint64_t h = 0xcbf29ce484222325;
+    for (auto i = 0; i < length; i++)
+    {
+        h ^= (uint8_t)text[i];
+        h *= 0x100000001b3;
+    }
+    return h;
+}
+
+void StringPool::rehash(size_t capacity)
+{
+    __table.assign(capacity, -1);
+    auto mask = capacity - 1;
+    for (auto iter = __strings.begin(); iter != __strings.end(); iter++)
+    {
+        auto slot = hash(iter->data, iter->length) & mask;
+        while (__table[slot] >= 0) { slot = (slot + 1) & mask; }
+        __table[slot] = iter->id;
+    }
+}
+
+PooledString StringPool::intern(const char *text, size_t length)
+{
+    if (__table.size() == 0) { rehash(1 << 12); }
+
+    auto mask = __table.size() - 1;
+    auto slot = hash(text, length) & mask;
+    while (__table[slot] >= 0)
+    {
+        auto &s = __strings[__table[slot]];
+        if (s.length == length && memcmp(s.data, text, length) == 0) {return s;}
+        slot = (slot + 1) & mask;
+    }
+
+    // text and its lowercase form sit next to each other
+    auto data = (char *)__arena.allocate(2 * length + 2, 1);
+    memcpy(data, text, length);
+    data[length] = 0;
+    auto lower = data + length + 1;
+    for (auto i = 0; i < length; i++) { lower[i] = (char)tolower((uint8_t)text[i]); }
+    lower[length] = 0;
+
+    PooledString s;
+    s.data = data;
+    s.length = (int32_t)length;
+    s.id = (int32_t)__strings.size();
+    __strings.push_back(s);
+    __lowers.push_back(lower);
+    __table[slot] = s.id;
+
+    if (__strings.size() * 2 > __table.size()) { rehash(__table.size() * 2); }
+    return s;
+}
+
+static inline uint32_t trigram(const char *lower)
+{
+    return (uint32_t)(uint8_t)lower[0] << 16 | (uint32_t)(uint8_t)lower[1] << 8 | (uint8_t)lower[2];
+}
+
+void StringPool::index()
+{
+    if (__indexedCount == __strings.size()) {return;}
+
+    std::vector<uint64_t> keys;
+    for (auto id = 0; id < __strings.size(); id++)
+    {
+        auto lower = __lowers[id];
+        for (auto i = 0; i + 3 <= __strings[id].length; i++)
+        {
+            keys.push_back((uint64_t)trigram(lower + i) << 32 | (uint32_t)id);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    __trigrams.clear();
+    __postings.resize(keys.size());
+    for (auto i = 0; i < keys.size(); i++)
+    {
+        auto key = (uint32_t)(keys[i] >> 32);
+        __postings[i] = (int32_t)(keys[i] & 0xFFFFFFFF);
+        auto match = __trigrams.find(key);
+        if (match == __trigrams.end())
+        {
+            __trigrams.insert(std::make_pair(key, std::make_pair((int32_t)i, (int32_t)i + 1)));
+        }
+        else
+        {
+            match->second.second = (int32_t)i + 1;
+        }
+    }
+    __indexedCount = (int32_t)__strings.size();
+}
+
+void StringPool::search(const std::string &keyword, StringMatch mode, std::vector<uint8_t> &matches)
+{
+    matches.assign(__strings.size(), 0);
+
+    auto verify = [&](int32_t id)
+    {
+        auto &s = __strings[id];
+        auto size = keyword.size();
+        if (s.length < size) {return;}
+        switch (mode)
+        {
+            case SM_prefix: matches[id] = memcmp(s.data, keyword.data(), size) == 0; break;
+            case SM_suffix: matches[id] = memcmp(s.data + s.length - size, keyword.data(), size) == 0; break;
+            case SM_contain: matches[id] = std::search(s.begin(), s.end(), keyword.begin(), keyword.end()) != s.end(); break;
+        }
+    };
+
+    if (keyword.size() < 3)
+    {
+        for (auto id = 0; id < __strings.size(); id++) { verify(id); }
+        return;
+    }
+
+    index();
+
+    // rarest trigram of keyword bounds candidates, exact comparison filters them
+    std::string lower(keyword);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) { return (char)tolower((uint8_t)c); });
+    std::pair<int32_t, int32_t> range(0, 0);
+    auto rarest = -1;
+    for (auto i = 0; i + 3 <= lower.size(); i++)
+    {
+        auto match = __trigrams.find(trigram(lower.c_str() + i));
+        if (match == __trigrams.end()) {return;}
+        auto count = match->second.second - match->second.first;
+        if (rarest < 0 || count < rarest)
+        {
+            rarest = count;
+            range = match->second;
+        }
+    }
+
+    for (auto i = range.first; i < range.second; i++) { verify(__postings[i]); }
+}
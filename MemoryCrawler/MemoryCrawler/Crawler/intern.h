@@ -0,0 +1,83 @@
+//
+//  intern.h
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/27.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#ifndef intern_h
+#define intern_h
+
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "arena.h"
+
+// view of a string interned in StringPool, valid as long as the pool
+struct PooledString
+{
+    const char *data = "";
+    int32_t length = 0;
+    int32_t id = -1;
+
+    const char *c_str() const { return data; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+
+    const char *begin() const { return data; }
+    const char *end() const { return data + length; }
+    std::reverse_iterator<const char *> rbegin() const { return std::reverse_iterator<const char *>(end()); }
+    std::reverse_iterator<const char *> rend() const { return std::reverse_iterator<const char *>(begin()); }
+    char operator[](size_t index) const { return data[index]; }
+
+    operator std::string() const { return std::string(data, length); }
+
+    bool operator==(const PooledString &s) const { return data == s.data || (length == s.length && memcmp(data, s.data, length) == 0); }
+    bool operator!=(const PooledString &s) const { return !(*this == s); }
+    bool operator==(const std::string &s) const { return length == s.size() && memcmp(data, s.data(), length) == 0; }
+    bool operator!=(const std::string &s) const { return !(*this == s); }
+};
+
+inline bool operator==(const std::string &a, const PooledString &b) { return b == a; }
+inline bool operator!=(const std::string &a, const PooledString &b) { return b != a; }
+
+enum StringMatch:uint8_t { SM_prefix = 0, SM_suffix, SM_contain };
+
+// every distinct name is stored once with its lowercase form, strings are looked up by 32-bit id
+class StringPool
+{
+    MemoryArena __arena;
+    std::vector<PooledString> __strings;
+    std::vector<const char *> __lowers;
+    std::vector<int32_t> __table; // open addressing over ids, -1 is empty
+
+    // lowercase trigram -> ascending ids, built on first search
+    std::unordered_map<uint32_t, std::pair<int32_t, int32_t>> __trigrams;
+    std::vector<int32_t> __postings;
+    int32_t __indexedCount = 0;
+
+public:
+    StringPool(): __arena(1 << 20) {}
+
+    PooledString intern(const char *text, size_t length);
+    PooledString intern(const char *text) { return intern(text, strlen(text)); }
+    PooledString intern(const std::string &text) { return intern(text.data(), text.size()); }
+
+    int32_t size() const { return (int32_t)__strings.size(); }
+    const PooledString &operator[](int32_t id) const { return __strings[id]; }
+    const char *lower(int32_t id) const { return __lowers[id]; }
+    size_t memory() const { return __arena.reserved(); }
+
+    // matches[id] is set for every string matching keyword, case sensitive
+    void search(const std::string &keyword, StringMatch mode, std::vector<uint8_t> &matches);
+
+private:
+    static uint64_t hash(const char *text, size_t length);
+    void rehash(size_t capacity);
+    void index();
+};
+
+#endif /* intern_h */
@@ -0,0 +1,341 @@
+//
+//  parallel.h
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/12.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#ifndef parallel_h
+#define parallel_h
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "address.h"
+#include "perf.h"
+
+// Task pool where every worker owns a deque: the owner pushes/pops at the back (depth first),
+// idle workers steal from the front of the others (breadth first) and sleep while nothing is queued.
+template <class T>
+class WorkStealingPool
+{
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<T> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> __queues;
+    std::atomic<int64_t> __pending; // queued and running tasks, plus holds
+    std::atomic<int64_t> __queued;
+    std::atomic<int32_t> __sleepers;
+    std::mutex __mutex;
+    std::condition_variable __signal;
+    int32_t __threadCount;
+
+public:
+    WorkStealingPool(int32_t threadCount);
+
+    int32_t threadCount() { return __threadCount; }
+
+    // push is safe from any thread, worker only picks the queue
+    void push(int32_t worker, const T &task);
+    void run(std::function<void(int32_t worker, T &task)> handler);
+
+    // keep workers of a running pool alive while tasks may still be pushed from outside
+    void hold();
+    void release();
+
+private:
+    bool pop(int32_t worker, T &task);
+    bool steal(int32_t worker, T &task);
+    void finish();
+};
+
+template <class T>
+WorkStealingPool<T>::WorkStealingPool(int32_t threadCount): __pending(0), __queued(0), __sleepers(0)
+{
+    __threadCount = threadCount < 1 ? 1 : threadCount;
+    for (auto i = 0; i < __threadCount; i++)
+    {
+        __queues.emplace_back(new WorkQueue);
+    }
+}
+
+template <class T>
+void WorkStealingPool<T>::push(int32_t worker, const T &task)
+{
+    auto &queue = *__queues[worker % __threadCount];
+    __pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+
+    // sleepers count is raised before they check queued count, so one side always sees the other
+    __queued.fetch_add(1);
+    if (__sleepers.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+        __signal.notify_one();
+    }
+}
+
+template <class T>
+bool WorkStealingPool<T>::pop(int32_t worker, T &task)
+{
+    auto &queue = *__queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {return false;}
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    __queued.fetch_sub(1);
+    return true;
+}
+
+template <class T>
+bool WorkStealingPool<T>::steal(int32_t worker, T &task)
+{
+    for (auto n = 1; n < __threadCount; n++)
+    {
+        auto &queue = *__queues[(worker + n) % __threadCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {continue;}
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+        __queued.fetch_sub(1);
+        return true;
+    }
+
+    return false;
+}
+
+template <class T>
+void WorkStealingPool<T>::finish()
+{
+    if (__pending.fetch_sub(1) != 1) {return;}
+    std::lock_guard<std::mutex> lock(__mutex);
+    __signal.notify_all();
+}
+
+template <class T>
+void WorkStealingPool<T>::hold()
+{
+    __pending.fetch_add(1);
+}
+
+template <class T>
+void WorkStealingPool<T>::release()
+{
+    finish();
+}
+
+template <class T>
+void WorkStealingPool<T>::run(std::function<void(int32_t worker, T &task)> handler)
+{
+    auto execute = [&](int32_t worker)
+    {
+        PerfScope scope("WorkStealingPool::worker");
+        T task;
+        while (true)
+        {
+            if (pop(worker, task) || steal(worker, task))
+            {
+                handler(worker, task);
+                finish();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(__mutex);
+            if (__pending.load() == 0) {break;}
+            __sleepers.fetch_add(1);
+            __signal.wait(lock, [&]() { return __queued.load() > 0 || __pending.load() == 0; });
+            __sleepers.fetch_sub(1);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (auto i = 1; i < __threadCount; i++)
+    {
+        threads.emplace_back(execute, i);
+    }
+
+    execute(0);
+    for (auto iter = threads.begin(); iter != threads.end(); iter++)
+    {
+        iter->join();
+    }
+}
+
+// Address keyed map split into independently locked shards, values never move once inserted.
+template <class T>
+class ShardedAddressMap
+{
+    static constexpr int32_t SHARD_COUNT = 64;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        AddressHashMap<int32_t> indice;
+        std::deque<T> items;
+    };
+
+    Shard __shards[SHARD_COUNT];
+
+public:
+    // returns the value of address, constructed from args by the first claimer only
+    template <class ...Args>
+    T *claim(address_t address, bool &claimed, Args&&... args);
+    T *find(address_t address);
+
+    size_t size();
+    void clear();
+
+private:
+    Shard &shardOf(address_t address)
+    {
+        return __shards[((address >> 3) ^ (address >> 17)) % SHARD_COUNT];
+    }
+};
+
+template <class T>
+template <class ...Args>
+T *ShardedAddressMap<T>::claim(address_t address, bool &claimed, Args&&... args)
+{
+    auto &shard = shardOf(address);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto index = shard.indice.find(address);
+    claimed = index == nullptr;
+    if (!claimed) {return &shard.items[*index];}
+    shard.indice.insert(address, (int32_t)shard.items.size());
+    shard.items.emplace_back(std::forward<Args>(args)...);
+    return &shard.items.back();
+}
+
+template <class T>
+T *ShardedAddressMap<T>::find(address_t address)
+{
+    auto &shard = shardOf(address);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto index = shard.indice.find(address);
+    return index != nullptr ? &shard.items[*index] : nullptr;
+}
+
+template <class T>
+size_t ShardedAddressMap<T>::size()
+{
+    size_t count = 0;
+    for (auto i = 0; i < SHARD_COUNT; i++) { count += __shards[i].items.size(); }
+    return count;
+}
+
+template <class T>
+void ShardedAddressMap<T>::clear()
+{
+    for (auto i = 0; i < SHARD_COUNT; i++)
+    {
+        __shards[i].indice.clear();
+        std::deque<T>().swap(__shards[i].items);
+    }
+}
+
+// Fixed capacity vtable -> type index table, lock free for concurrent readers and writers.
+// Unresolvable vtables are kept as -1, entries stop being added once the table is half full and are counted as dropped.
+class VTableTypeCache
+{
+    static constexpr int32_t MAX_PROBES = 16;
+    static constexpr int32_t PENDING = INT32_MIN;
+    
+    struct Slot
+    {
+        std::atomic<address_t> vtable;
+        std::atomic<int32_t> typeIndex;
+    };
+    
+    std::unique_ptr<Slot[]> __slots;
+    size_t __capacity = 0;
+    std::atomic<int32_t> __count;
+    std::atomic<int32_t> __dropped;
+    
+public:
+    VTableTypeCache(): __count(0), __dropped(0) {}
+    
+    void reset(size_t capacity)
+    {
+        size_t size = 1024;
+        while (size < capacity) { size <<= 1; }
+        __slots.reset(new Slot[size]);
+        for (auto i = 0; i < size; i++)
+        {
+            __slots[i].vtable.store(0, std::memory_order_relaxed);
+            __slots[i].typeIndex.store(PENDING, std::memory_order_relaxed);
+        }
+        __capacity = size;
+        __count.store(0);
+        __dropped.store(0);
+    }
+    
+    size_t capacity() const { return __capacity; }
+    int32_t size() const { return __count.load(std::memory_order_relaxed); }
+    int32_t dropped() const { return __dropped.load(std::memory_order_relaxed); }
+    
+    // typeIndex is -1 if vtable has been cached as unresolvable
+    bool find(address_t vtable, int32_t &typeIndex) const
+    {
+        auto mask = __capacity - 1;
+        auto slot = hash(vtable) & mask;
+        for (auto n = 0; n < MAX_PROBES; n++, slot = (slot + 1) & mask)
+        {
+            auto key = __slots[slot].vtable.load(std::memory_order_acquire);
+            if (key == 0) {return false;}
+            if (key != vtable) {continue;}
+            
+            auto value = __slots[slot].typeIndex.load(std::memory_order_acquire);
+            if (value == PENDING) {return false;}
+            typeIndex = value;
+            return true;
+        }
+        return false;
+    }
+    
+    // false if vtable could not be cached
+    bool insert(address_t vtable, int32_t typeIndex)
+    {
+        if (__count.load(std::memory_order_relaxed) * 2 >= __capacity)
+        {
+            __dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        auto mask = __capacity - 1;
+        auto slot = hash(vtable) & mask;
+        for (auto n = 0; n < MAX_PROBES; n++, slot = (slot + 1) & mask)
+        {
+            address_t key = 0;
+            if (__slots[slot].vtable.compare_exchange_strong(key, vtable, std::memory_order_acq_rel))
+            {
+                __slots[slot].typeIndex.store(typeIndex, std::memory_order_release);
+                __count.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            if (key == vtable) {return true;} // claimed by another worker
+        }
+        
+        __dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+private:
+    static size_t hash(address_t vtable)
+    {
+        return (size_t)((vtable >> 3) * 0x9E3779B97F4A7C15 >> 32);
+    }
+};
+
+#endif /* parallel_h */
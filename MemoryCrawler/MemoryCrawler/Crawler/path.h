@@ -0,0 +1,175 @@
+//
+//  path.h
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/21.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#ifndef path_h
+#define path_h
+
+#include <algorithm>
+#include <deque>
+#include <queue>
+#include <vector>
+#include <limits>
+#include "types.h"
+
+// Graph G provides:
+//   int32_t size() const
+//   int32_t inDegree(int32_t node) const
+//   void forEachIncoming(int32_t node, F fn) const, fn(connection, source) with source -1 for root connections
+//   void forEachOutgoing(int32_t node, F fn) const, fn(target)
+// Nodes without incoming connections are treated as roots as well.
+template <class G>
+class RetentionPathFinder
+{
+    struct Step
+    {
+        int32_t node;
+        int32_t connection;
+        int32_t parent;
+        int32_t length;
+    };
+
+    struct Entry
+    {
+        int32_t estimate;
+        int32_t sequence;
+        int32_t step;
+        int32_t marker; // 0 for open paths, 1 for paths reaching root, -1 for circular ones
+
+        bool operator<(const Entry &other) const
+        {
+            if (estimate != other.estimate) {return estimate > other.estimate;}
+            return sequence > other.sequence;
+        }
+    };
+
+    const G &__graph;
+    const std::vector<int32_t> &__distances;
+
+public:
+    static constexpr int32_t UNREACHABLE = std::numeric_limits<int32_t>::max();
+
+    // connection count from nearest root to every node
+    static void measure(const G &graph, std::vector<int32_t> &distances);
+
+    RetentionPathFinder(const G &graph, const std::vector<int32_t> &distances): __graph(graph), __distances(distances) {}
+
+    // shortest paths first, each path lists connections from target back to root
+    // paths cut by depth end with -2, search stops with one cut path after capacity steps
+    // with circular set, paths leading back into an object already on them are kept and end with -1
+    std::vector<std::vector<int32_t>> find(int32_t target, int32_t count, int32_t depth, int64_t capacity, bool circular = false);
+};
+
+template <class G>
+constexpr int32_t RetentionPathFinder<G>::UNREACHABLE;
+
+template <class G>
+void RetentionPathFinder<G>::measure(const G &graph, std::vector<int32_t> &distances)
+{
+    auto size = graph.size();
+    distances.assign(size, UNREACHABLE);
+
+    std::deque<int32_t> queue;
+    for (auto i = 0; i < size; i++)
+    {
+        if (graph.inDegree(i) == 0) { distances[i] = 0; queue.push_back(i); }
+    }
+
+    for (auto i = 0; i < size; i++)
+    {
+        if (distances[i] == 0) {continue;}
+        graph.forEachIncoming(i, [&](int32_t connection, int32_t source)
+                              {
+                                  if (source == -1 && distances[i] != 1) { distances[i] = 1; queue.push_back(i); }
+                              });
+    }
+
+    while (queue.size() > 0)
+    {
+        auto node = queue.front();
+        queue.pop_front();
+        auto distance = distances[node] + 1;
+        graph.forEachOutgoing(node, [&](int32_t target)
+                              {
+                                  if (distances[target] > distance) { distances[target] = distance; queue.push_back(target); }
+                              });
+    }
+}
+
+template <class G>
+std::vector<std::vector<int32_t>> RetentionPathFinder<G>::find(int32_t target, int32_t count, int32_t depth, int64_t capacity, bool circular)
+{
+    std::vector<std::vector<int32_t>> result;
+    if (target < 0 || target >= __graph.size() || __distances[target] == UNREACHABLE || __graph.inDegree(target) == 0) {return result;}
+
+    // partial paths grow backwards from target and share their common part as steps
+    std::vector<Step> steps;
+    std::priority_queue<Entry> queue;
+    std::vector<int32_t> stamps(__graph.size(), -1);
+    int32_t sequence = 0;
+
+    auto chain = [&](int32_t step, int32_t marker)
+    {
+        std::vector<int32_t> connections;
+        for (auto s = step; s != -1; s = steps[s].parent)
+        {
+            if (steps[s].connection >= 0) {connections.push_back(steps[s].connection);}
+        }
+        std::reverse(connections.begin(), connections.end());
+        if (marker < 0) {connections.push_back(marker);}
+        result.emplace_back(std::move(connections));
+    };
+
+    auto visited = [&](int32_t step, int32_t node)
+    {
+        for (auto s = step; s != -1; s = steps[s].parent)
+        {
+            if (steps[s].node == node) {return true;}
+        }
+        return false;
+    };
+
+    steps.push_back(Step{target, -1, -1, 0});
+    queue.push(Entry{__distances[target], sequence++, 0, 0});
+    while (queue.size() > 0 && result.size() < count)
+    {
+        auto entry = queue.top();
+        queue.pop();
+
+        auto index = entry.step;
+        if (entry.marker != 0) { chain(index, entry.marker); continue; }
+
+        auto node = steps[index].node;
+        auto length = steps[index].length;
+        if (length > 0 && __graph.inDegree(node) == 0) { chain(index, 0); continue; }
+        if (depth > 0 && length >= depth) { chain(index, -2); continue; }
+        if (steps.size() >= capacity) { chain(index, -2); break; }
+
+        __graph.forEachIncoming(node, [&](int32_t connection, int32_t source)
+                                {
+                                    if (source == -1)
+                                    {
+                                        steps.push_back(Step{-1, connection, index, length + 1});
+                                        queue.push(Entry{length + 1, sequence++, (int32_t)steps.size() - 1, 1});
+                                        return;
+                                    }
+
+                                    // one step per source object, and paths never pass an object twice
+                                    if (__distances[source] == UNREACHABLE || stamps[source] == index) {return;}
+                                    stamps[source] = index;
+                                    auto marker = visited(index, source) ? -1 : 0;
+                                    if (marker != 0 && !circular) {return;}
+
+                                    steps.push_back(Step{source, connection, index, length + 1});
+                                    queue.push(Entry{length + 1 + __distances[source], sequence++, (int32_t)steps.size() - 1, marker});
+                                });
+    }
+
+    return result;
+}
+
+#endif /* path_h */
@@ -0,0 +1,271 @@
+//
+//  perf.cpp
+//  MemoryCrawler
+//
+//  Created by larryhou on 2019/11/25.
+//  Copyright © 2019 larryhou. All rights reserved.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include "perf.h"
+#include "stat.h"
+
+constexpr int32_t TraceNote::SIZE;
+constexpr int64_t TraceBuffer::CAPACITY;
+constexpr int64_t TraceBuffer::NOTE_CAPACITY;
+
+TraceBuffer::TraceBuffer(int32_t thread): events(new TraceSlot[CAPACITY]), notes(new TraceNote[NOTE_CAPACITY]), head(0), noteHead(0), thread(thread), depth(0)
+{
+    for (auto i = 0; i < CAPACITY; i++) { events[i].stamp.store(-1, std::memory_order_relaxed); }
+    for (auto i = 0; i < NOTE_CAPACITY; i++) { notes[i].owner.store(-1, std::memory_order_relaxed); }
+}
+
+void TraceBuffer::record(const char *name, int64_t start, int64_t stop, int32_t depth, const char *note)
+{
+    auto sequence = head.load(std::memory_order_relaxed);
+    auto &slot = events[sequence % CAPACITY];
+    slot.stamp.store(-1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    auto &event = slot.event;
+    event.name = name;
+    event.start = start;
+    event.duration = stop - start;
+    event.depth = depth;
+    event.note = -1;
+    if (note != nullptr)
+    {
+        auto index = noteHead++ % NOTE_CAPACITY;
+        auto &item = notes[index];
+        item.owner.store(-1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        snprintf(item.text, sizeof(item.text), "%s", note);
+        item.owner.store(sequence, std::memory_order_release);
+        event.note = (int32_t)index;
+    }
+    
+    slot.stamp.store(sequence, std::memory_order_release);
+    head.store(sequence + 1, std::memory_order_release);
+}
+
+bool TraceBuffer::read(int64_t sequence, TraceEvent &event, string &note) const
+{
+    auto &slot = events[sequence % CAPACITY];
+    if (slot.stamp.load(std::memory_order_acquire) != sequence) {return false;}
+    event = slot.event;
+    
+    char text[TraceNote::SIZE];
+    auto owned = false;
+    if (event.note >= 0 && event.note < NOTE_CAPACITY)
+    {
+        auto &item = notes[event.note];
+        if (item.owner.load(std::memory_order_acquire) == sequence)
+        {
+            memcpy(text, item.text, sizeof(text));
+            text[sizeof(text) - 1] = 0;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            owned = item.owner.load(std::memory_order_relaxed) == sequence;
+        }
+    }
+    
+    // slot rewritten while copying
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.stamp.load(std::memory_order_relaxed) != sequence) {return false;}
+    
+    if (owned) { note = text; } else { event.note = -1; } // note overwritten by newer notes
+    return true;
+}
+
+PerfTrace &PerfTrace::shared()
+{
+    static PerfTrace trace;
+    return trace;
+}
+
+struct TraceOwner
+{
+    TraceBuffer *buffer = nullptr;
+    
+    ~TraceOwner()
+    {
+        if (buffer != nullptr) { PerfTrace::shared().release(buffer); }
+    }
+};
+
+TraceBuffer &PerfTrace::local()
+{
+    thread_local TraceOwner slot;
+    if (slot.buffer == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(__mutex);
+        if (__idles.size() > 0)
+        {
+            slot.buffer = __idles.back();
+            __idles.pop_back();
+        }
+        else
+        {
+            __buffers.emplace_back(new TraceBuffer((int32_t)__buffers.size()));
+            slot.buffer = __buffers.back().get();
+        }
+    }
+    return *slot.buffer;
+}
+
+void PerfTrace::release(TraceBuffer *buffer)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    buffer->depth = 0;
+    __idles.push_back(buffer);
+}
+
+void PerfTrace::collect(std::vector<std::pair<int32_t, TraceEvent>> &events, std::vector<string> &notes)
+{
+    std::lock_guard<std::mutex> lock(__mutex);
+    TraceEvent event;
+    string note;
+    for (auto iter = __buffers.begin(); iter != __buffers.end(); iter++)
+    {
+        auto &buffer = **iter;
+        auto head = buffer.head.load(std::memory_order_acquire);
+        for (auto sequence = std::max((int64_t)0, head - TraceBuffer::CAPACITY); sequence < head; sequence++)
+        {
+            if (!buffer.read(sequence, event, note)) {continue;}
+            if (event.note >= 0)
+            {
+                notes.push_back(note);
+                event.note = (int32_t)notes.size() - 1;
+            }
+            events.emplace_back(buffer.thread, event);
+        }
+    }
+}
+
+void PerfTrace::summarize()
+{
+    std::vector<std::pair<int32_t, TraceEvent>> events;
+    std::vector<string> notes;
+    collect(events, notes);
+
+    std::map<string, StreamStatistics<int64_t>> scopes;
+    for (auto iter = events.begin(); iter != events.end(); iter++)
+    {
+        scopes[iter->second.name].collect(iter->second.duration);
+    }
+
+    for (auto iter = scopes.begin(); iter != scopes.end(); iter++)
+    {
+        auto &stats = iter->second;
+        printf("%-40s count=%-8lld total=%.3fms min=%.3fms max=%.3fms p99=%.3fms\n", iter->first.c_str(), (long long)stats.size(),
+               stats.sum * 1E-6, stats.minimum * 1E-6, stats.maximum * 1E-6, stats.quantile(0.99) * 1E-6);
+    }
+}
+
+static void writeJSONString(std::ofstream &fs, const char *text)
+{
+    fs << '"';
+    for (auto c = text; *c != 0; c++)
+    {
+        switch (*c)
+        {
+            case '"': fs << "\\\""; break;
+            case '\\': fs << "\\\\"; break;
+            case '\n': fs << "\\n"; break;
+            case '\t': fs << "\\t"; break;
+            default:
+            {
+                if ((uint8_t)*c < 0x20) {fs << ' ';} else {fs << *c;}
+            } break;
+        }
+    }
+    fs << '"';
+}
+
+bool PerfTrace::save(const char *path)
+{
+    std::vector<std::pair<int32_t, TraceEvent>> events;
+    std::vector<string> notes;
+    collect(events, notes);
+
+    // parents start no later than their children
+    std::sort(events.begin(), events.end(), [](const std::pair<int32_t, TraceEvent> &a, const std::pair<int32_t, TraceEvent> &b)
+              {
+                  if (a.first != b.first) {return a.first < b.first;}
+                  if (a.second.start != b.second.start) {return a.second.start < b.second.start;}
+                  return a.second.depth < b.second.depth;
+              });
+
+    char filepath[512];
+    snprintf(filepath, sizeof(filepath), "%s.json", path);
+    std::ofstream json(filepath);
+    if (!json.is_open()) {return false;}
+
+    char number[64];
+    json << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for (auto i = 0; i < events.size(); i++)
+    {
+        auto &event = events[i].second;
+        if (i > 0) {json << ",\n";}
+        json << "{\"name\":";
+        writeJSONString(json, event.name);
+        snprintf(number, sizeof(number), ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f", events[i].first, event.start * 1E-3, event.duration * 1E-3);
+        json << number;
+        if (event.note >= 0)
+        {
+            json << ",\"args\":{\"note\":";
+            writeJSONString(json, notes[event.note].c_str());
+            json << "}";
+        }
+        json << "}";
+    }
+    json << "\n]}\n";
+    json.close();
+
+    // self time in microseconds of every stack
+    std::map<string, int64_t> stacks;
+    std::vector<std::pair<const TraceEvent *, string>> opens;
+    std::vector<int64_t> children;
+    auto close = [&]()
+    {
+        auto event = opens.back().first;
+        stacks[opens.back().second] += std::max((int64_t)0, event->duration - children.back());
+        opens.pop_back();
+        children.pop_back();
+        if (children.size() > 0) {children.back() += event->duration;}
+    };
+
+    auto thread = -1;
+    for (auto iter = events.begin(); iter != events.end(); iter++)
+    {
+        auto &event = iter->second;
+        if (iter->first != thread)
+        {
+            while (opens.size() > 0) {close();}
+            thread = iter->first;
+        }
+
+        while (opens.size() > 0)
+        {
+            auto parent = opens.back().first;
+            if (parent->depth < event.depth && event.start + event.duration <= parent->start + parent->duration) {break;}
+            close();
+        }
+
+        string stack = opens.size() > 0 ? opens.back().second + ";" : "thread-" + std::to_string(thread) + ";";
+        opens.emplace_back(&event, stack + event.name);
+        children.push_back(0);
+    }
+    while (opens.size() > 0) {close();}
+
+    snprintf(filepath, sizeof(filepath), "%s.folded", path);
+    std::ofstream folded(filepath);
+    if (!folded.is_open()) {return false;}
+    for (auto iter = stacks.begin(); iter != stacks.end(); iter++)
+    {
+        folded << iter->first << ' ' << iter->second / 1000 << '\n';
+    }
+    folded.close();
+    return true;
+}
@@ -10,9 +10,13 @@
 #define perf_h
 
 #include <iostream>
+#include <cstdio>
 #include <map>
 #include <vector>
 #include <chrono>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include "types.h"
 
 using std::vector;
@@ -39,17 +43,142 @@ using std::cout;
 // std::ratio<60>
 // std::ratio<3600>
 
+// one completed scope, timestamps are nanoseconds since trace epoch
+struct TraceEvent
+{
+    const char *name;
+    int64_t start;
+    int64_t duration;
+    int32_t depth;
+    int32_t note;
+};
+
+// note text of one event, owner is sequence of the event so that overwritten notes can be detected
+struct TraceNote
+{
+    static constexpr int32_t SIZE = 248;
+    
+    std::atomic<int64_t> owner;
+    char text[SIZE];
+};
+
+// event slot stamped with its sequence, -1 while being written
+struct TraceSlot
+{
+    std::atomic<int64_t> stamp;
+    TraceEvent event;
+};
+
+// rings of recent events and notes, only written by owner thread and never locked
+// collector reads slots whose stamp is the same before and after copying, torn or overwritten slots are skipped
+struct TraceBuffer
+{
+    static constexpr int64_t CAPACITY = 1 << 16;
+    static constexpr int64_t NOTE_CAPACITY = 1 << 10;
+    
+    std::unique_ptr<TraceSlot[]> events;
+    std::unique_ptr<TraceNote[]> notes;
+    std::atomic<int64_t> head;
+    int64_t noteHead;
+    int32_t thread;
+    int32_t depth;
+    
+    TraceBuffer(int32_t thread);
+    
+    void record(const char *name, int64_t start, int64_t stop, int32_t depth, const char *note);
+    
+    // false if slot of sequence is being written or has been reused
+    bool read(int64_t sequence, TraceEvent &event, string &note) const;
+};
+
+// process wide trace of all threads, exported as chrome trace events and folded stacks
+class PerfTrace
+{
+    std::mutex __mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> __buffers;
+    std::vector<TraceBuffer *> __idles;
+    std::chrono::steady_clock::time_point __epoch;
+    
+public:
+    static PerfTrace &shared();
+    
+    PerfTrace(): __epoch(std::chrono::steady_clock::now()) {}
+    
+    int64_t now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - __epoch).count();
+    }
+    
+    // buffers of exited threads are handed to new threads, so pools spawning threads on every run don't pile them up
+    TraceBuffer &local();
+    void release(TraceBuffer *buffer);
+    
+    // counts/total/min/max/p99 per scope name
+    void summarize();
+    
+    // {path}.json for chrome://tracing and {path}.folded for flamegraph
+    bool save(const char *path);
+    
+private:
+    void collect(std::vector<std::pair<int32_t, TraceEvent>> &events, std::vector<string> &notes);
+};
+
+class PerfScope
+{
+    TraceBuffer &__buffer;
+    const char *__name;
+    int64_t __start;
+    int32_t __depth;
+    char __note[TraceNote::SIZE];
+    
+public:
+    PerfScope(const char *name): __buffer(PerfTrace::shared().local()), __name(name)
+    {
+        __depth = __buffer.depth++;
+        __note[0] = 0;
+        __start = PerfTrace::shared().now();
+    }
+    
+    void annotate(const char *note) { snprintf(__note, sizeof(__note), "%s", note); }
+    void annotate(const string &note) { annotate(note.c_str()); }
+    
+    ~PerfScope()
+    {
+        __buffer.depth--;
+        __buffer.record(__name, __start, PerfTrace::shared().now(), __depth, __note[0] == 0 ? nullptr : __note);
+    }
+};
+
+// nested timing of one owner, every event is also recorded in trace buffer of current thread
+// at most EVENT_CAPACITY events are kept for summarize, they are dropped when a new outermost event begins
 template <class T = std::micro>
 class TimeSampler
 {
-    vector<const char *> __events;
+    static constexpr int32_t EVENT_CAPACITY = 1 << 12;
+    
+    struct Event
+    {
+        const char *name;
+        int64_t start;
+        int64_t stop;
+        int32_t parent;
+        int32_t depth;
+        int32_t note;
+    };
     
-    map<int, clocktime_t> __timestamps;
-    map<int, clocktime_t> __records;
+    struct Open
+    {
+        int32_t index; // -1 if not kept
+        const char *name;
+        int64_t start;
+        int32_t depth;
+        char note[TraceNote::SIZE];
+    };
     
-    vector<int> __entities;
-    map<int, int> __bridges;
-    vector<int> __cursors;
+    vector<Event> __events;
+    vector<Open> __opens;
+    vector<string> __notes;
+    int32_t __dropped = 0;
     
 public:
     TimeSampler();
@@ -57,20 +186,18 @@ public:
     int begin(const char *event);
     int64_t end();
     
+    // attach extra info to the innermost running event
+    void annotate(const string &note);
+    
     void summarize();
     
 private:
-    clocktime_t clock()
-    {
-        return high_resolution_clock::now();
-    }
-    
-    int64_t duration(clocktime_t time, clocktime_t base)
+    int64_t duration(int64_t nanoseconds)
     {
-        return std::chrono::duration_cast<std::chrono::duration<long long, T>>(time - base).count();
+        return std::chrono::duration_cast<std::chrono::duration<long long, T>>(std::chrono::nanoseconds(nanoseconds)).count();
     }
     
-    void dump(map<int, vector<int>> &connections, int index, const char *indent);
+    void dump(map<int32_t, vector<int32_t>> &connections, int32_t index, const char *indent);
 };
 
 template <class T>
@@ -82,89 +209,128 @@ TimeSampler<T>::TimeSampler()
 template <class T>
 int TimeSampler<T>::begin(const char *event)
 {
-    auto timestamp = clock();
-    
-    auto sequence = (int)__events.size();
+    if (__opens.size() == 0 && __events.size() >= EVENT_CAPACITY)
+    {
+        __events.clear();
+        __notes.clear();
+        __dropped = 0;
+    }
     
-    __events.push_back(event);
-    __timestamps.insert(pair<int, clocktime_t>(sequence, timestamp));
+    auto &buffer = PerfTrace::shared().local();
+    __opens.emplace_back();
+    auto &open = __opens.back();
+    open.index = -1;
+    open.name = event;
+    open.depth = buffer.depth++;
+    open.note[0] = 0;
     
-    auto cursorCount = __cursors.size();
-    if (cursorCount == 0)
+    // events stop being kept once capacity is reached, so a kept event never has a dropped parent
+    if (__events.size() < EVENT_CAPACITY)
     {
-        __entities.push_back(sequence);
+        open.index = (int32_t)__events.size();
+        auto parent = __opens.size() == 1 ? -1 : __opens[__opens.size() - 2].index;
+        __events.push_back(Event{event, 0, -1, parent, open.depth, -1});
     }
     else
     {
-        __bridges.insert(pair<int, int>(sequence, __cursors[cursorCount - 1]));
+        ++__dropped;
     }
     
-    __cursors.push_back(sequence);
-    return sequence;
+    open.start = PerfTrace::shared().now();
+    if (open.index >= 0) { __events[open.index].start = open.start; }
+    return open.index;
 }
 
 template <class T>
 int64_t TimeSampler<T>::end()
 {
-    auto timestamp = clock();
+    auto timestamp = PerfTrace::shared().now();
+    if (__opens.size() == 0) {return 0;}
     
-    auto cursorCount = __cursors.size();
-    if (cursorCount == 0) {return 0;}
+    auto &open = __opens.back();
+    auto note = open.note[0] == 0 ? nullptr : open.note;
+    auto &buffer = PerfTrace::shared().local();
+    buffer.depth--;
+    buffer.record(open.name, open.start, timestamp, open.depth, note);
     
-    auto sequence = __cursors[cursorCount - 1];
-    __records.insert(pair<int, clocktime_t>(sequence, timestamp));
-    __cursors.pop_back();
+    if (open.index >= 0)
+    {
+        auto &event = __events[open.index];
+        event.stop = timestamp;
+        if (note != nullptr)
+        {
+            event.note = (int32_t)__notes.size();
+            __notes.emplace_back(note);
+        }
+    }
     
-    return duration(timestamp, __timestamps[sequence]);
+    auto elapse = duration(timestamp - open.start);
+    __opens.pop_back();
+    return elapse;
+}
+
+template <class T>
+void TimeSampler<T>::annotate(const string &note)
+{
+    if (__opens.size() == 0) {return;}
+    auto &open = __opens.back();
+    snprintf(open.note, sizeof(open.note), "%s", note.c_str());
 }
 
 template <class T>
 void TimeSampler<T>::summarize()
 {
-    assert(__records.size() == __timestamps.size());
-    if (__records.size() == 0) {return;}
+    if (__events.size() == 0) {return;}
+    if (__dropped > 0) {printf("%d events not kept\n", __dropped);}
     
-    map<int, vector<int>> connections;
-    for (auto it = __bridges.begin(); it != __bridges.end(); it++)
+    map<int32_t, vector<int32_t>> connections;
+    for (auto i = 0; i < __events.size(); i++)
     {
-        auto leaf = it->first;
-        auto branch = it->second;
-        
-        auto entry = connections.find(branch);
-        if (entry == connections.end())
-        {
-            vector<int> vec{leaf};
-            connections.insert(pair<int, vector<int>>(branch, vec));
-        }
-        else
-        {
-            entry->second.push_back(leaf);
-        }
+        assert(__events[i].stop >= 0);
+        connections[__events[i].parent].push_back(i);
     }
     
-    for(auto i = 0; i < __entities.size(); i++)
+    auto &entities = connections[-1];
+    for(auto i = 0; i < entities.size(); i++)
     {
-        dump(connections, __entities[i], "");
+        dump(connections, entities[i], "");
     }
 }
 
 template <class T>
-void TimeSampler<T>::dump(map<int, vector<int>> &connections, int index, const char *indent)
+void TimeSampler<T>::dump(map<int32_t, vector<int32_t>> &connections, int32_t index, const char *indent)
 {
-    printf("%s[%d] %s=%lld\n", indent, index, __events[index], duration(__records.at(index), __timestamps.at(index)));
+    auto &event = __events[index];
+    printf("%s[%d] %s=%lld", indent, index, event.name, duration(event.stop - event.start));
+    if (event.note >= 0) {printf(" %s", __notes[event.note].c_str());}
+    printf("\n");
     
     char __indent[strlen(indent) + 4 + 1];
     memset(__indent, 0, sizeof(__indent));
     sprintf(__indent, "%s    ", indent);
     
     auto iter = connections.find(index);
-    if (iter != connections.end())
+    if (iter == connections.end()) {return;}
+    
+    // repeated scopes of one parent are printed once with their distribution
+    auto &children = iter->second;
+    map<const char *, vector<int32_t>> groups;
+    for (auto i = children.begin(); i != children.end(); i++) { groups[__events[*i].name].push_back(*i); }
+    
+    for (auto i = children.begin(); i != children.end(); i++)
     {
-        auto children = iter->second;
-        for (auto i = 0; i < children.size(); i++)
-        {
-            dump(connections, children[i], __indent);
-        }
+        auto &group = groups[__events[*i].name];
+        if (group.size() <= 1) { dump(connections, *i, __indent); continue; }
+        if (group[0] != *i) {continue;}
+        
+        vector<int64_t> durations;
+        for (auto n = group.begin(); n != group.end(); n++) { durations.push_back(__events[*n].stop - __events[*n].start); }
+        std::sort(durations.begin(), durations.end());
+        
+        int64_t total = 0;
+        for (auto n = durations.begin(); n != durations.end(); n++) { total += *n; }
+        printf("%s[%d] %s=%lld count=%d min=%lld max=%lld p99=%lld\n", __indent, *i, __events[*i].name, duration(total), (int32_t)durations.size(),
+               duration(durations.front()), duration(durations.back()), duration(durations[(durations.size() - 1) * 99 / 100]));
     }
 }
 
@@ -19,28 +19,36 @@ const uint32_t kSnapshotRuntimeInfoMagicBytes = 0x0183EFAC;
 const uint32_t kSnapshotTailMagicBytes = 0x865EEAAF;
 const uint32_t kSnapshotNativeAppendingMagicBytes = 0x55AA55AA;
 
-void readMemorySectionR(MemorySection &section, FileStream &fs)
+void readMemorySectionR(MemorySection &section, FileStream &fs, MemoryArena &arena)
 {
     section.startAddress = fs.readUInt64();
     auto size = section.size = fs.readUInt32();
     if (size > 0)
     {
-        section.bytes = new Array<byte_t>(size);
-        fs.read((char *)(section.bytes->items), size);
+        auto borrowed = fs.borrow(size);
+        if (borrowed != nullptr)
+        {
+            section.bytes = Array<byte_t>::create(arena, size, (byte_t *)borrowed);
+        }
+        else
+        {
+            section.bytes = Array<byte_t>::create(arena, size);
+            fs.read((char *)(section.bytes->items), size);
+        }
     }
 }
 
 string removeFieldWrapper(string name);
 
-void readFieldDescriptionR(FieldDescription &item, FileStream &fs)
+void readFieldDescriptionR(FieldDescription &item, FileStream &fs, StringPool &strings)
 {
     item.offset = fs.readInt32();
     item.typeIndex = fs.readInt32();
-    item.name = removeFieldWrapper(fs.readZEString());
+    item.name = strings.intern(removeFieldWrapper(fs.readZEString()));
     item.isStatic = fs.readBoolean();
 }
 
-void readTypeDescriptionR(TypeDescription &item, FileStream &fs)
+void readTypeDescriptionR(TypeDescription &item, FileStream &fs, PackedMemorySnapshot &snapshot)
 {
     auto flags = fs.readInt32();
     item.isValueType = (flags & (1 << 0)) != 0;
@@ -50,25 +58,25 @@ void readTypeDescriptionR(TypeDescription &item, FileStream &fs)
     if (!item.isArray)
     {
         auto fieldCount = fs.readUInt32();
-        item.fields = new Array<FieldDescription>(fieldCount);
+        item.fields = Array<FieldDescription>::create(snapshot.arena, fieldCount);
         if (fieldCount > 0)
         {
             for (auto i = 0; i < fieldCount; i++)
             {
-                readFieldDescriptionR(item.fields->items[i], fs);
+                readFieldDescriptionR(item.fields->items[i], fs, snapshot.strings);
             }
         }
         
         auto byteCount = fs.readUInt32();
         if (byteCount > 0)
         {
-            item.staticFieldBytes = new Array<byte_t>(byteCount);
+            item.staticFieldBytes = Array<byte_t>::create(snapshot.arena, byteCount);
             fs.read((char *)(item.staticFieldBytes->items), byteCount);
         }
     }
     
-    item.name = fs.readZEString();
-    item.assembly = fs.readZEString();
+    item.name = snapshot.strings.intern(fs.readZEString());
+    item.assembly = snapshot.strings.intern(fs.readZEString());
     item.typeInfoAddress = fs.readUInt64();
     item.size = fs.readInt32();
 }
@@ -100,10 +108,10 @@ void RawMemorySnapshotReader::read(PackedMemorySnapshot &snapshot)
             {
                 __sampler.begin("ReadHeapMemorySections");
                 auto sectionCount = fs.readUInt32();
-                snapshot.heapSections = new Array<MemorySection>(sectionCount);
+                snapshot.heapSections = Array<MemorySection>::create(snapshot.arena, sectionCount);
                 for (auto i = 0; i < sectionCount; i++)
                 {
-                    readMemorySectionR(snapshot.heapSections->items[i], fs);
+                    readMemorySectionR(snapshot.heapSections->items[i], fs, snapshot.arena);
                 }
                 __sampler.end();
             }break;
@@ -111,10 +119,10 @@ void RawMemorySnapshotReader::read(PackedMemorySnapshot &snapshot)
             {
                 __sampler.begin("ReadStacksMemorySections");
                 auto sectionCount = fs.readUInt32();
-                snapshot.stacksSections = new Array<MemorySection>(sectionCount);
+                snapshot.stacksSections = Array<MemorySection>::create(snapshot.arena, sectionCount);
                 for (auto i = 0; i < sectionCount; i++)
                 {
-                    readMemorySectionR(snapshot.stacksSections->items[i], fs);
+                    readMemorySectionR(snapshot.stacksSections->items[i], fs, snapshot.arena);
                 }
                 __sampler.end();
             }break;
@@ -122,11 +130,11 @@ void RawMemorySnapshotReader::read(PackedMemorySnapshot &snapshot)
             {
                 __sampler.begin("ReadTypeDescriptions");
                 auto typeCount = fs.readUInt32();
-                auto typeDescriptions = snapshot.typeDescriptions = new Array<TypeDescription>(typeCount);
+                auto typeDescriptions = snapshot.typeDescriptions = Array<TypeDescription>::create(snapshot.arena, typeCount);
                 for (auto i = 0; i < typeCount; i++)
                 {
                     auto &item = typeDescriptions->items[i];
-                    readTypeDescriptionR(item, fs);
+                    readTypeDescriptionR(item, fs, snapshot);
                     item.typeIndex = i;
                 }
                 __sampler.end();
@@ -135,10 +143,12 @@ void RawMemorySnapshotReader::read(PackedMemorySnapshot &snapshot)
             {
                 __sampler.begin("ReadGCHandles");
                 auto itemCount = fs.readUInt32();
-                auto gcHandles = snapshot.gcHandles = new Array<PackedGCHandle>(itemCount);
+                auto gcHandles = snapshot.gcHandles = Array<PackedGCHandle>::create(snapshot.arena, itemCount);
+                std::vector<address_t> targets(itemCount);
+                fs.readArray(targets.data(), itemCount);
                 for (auto i = 0; i < itemCount; i++)
                 {
-                    gcHandles->items[i].target = fs.readUInt64();
+                    gcHandles->items[i].target = targets[i];
                 }
                 __sampler.end();
             }break;
@@ -160,13 +170,13 @@ void RawMemorySnapshotReader::read(PackedMemorySnapshot &snapshot)
                     typeCount = maxClassID + 1;
                 }
                 
-                auto nativeTypes = snapshot.nativeTypes = new Array<PackedNativeType>(typeCount);
+                auto nativeTypes = snapshot.nativeTypes = Array<PackedNativeType>::create(snapshot.arena, typeCount);
                 for (auto i = 0; i < typeCount; i++)
                 {
                     auto &type = nativeTypes->items[i];
                     type.typeIndex = fs.readInt32();
                     type.nativeBaseTypeArrayIndex = fs.readInt32();
-                    type.name = fs.readZEString();
+                    type.name = snapshot.strings.intern(fs.readZEString());
                 }
                 
                 if (formatVersion <= 3)
@@ -186,14 +196,15 @@ void RawMemorySnapshotReader::read(PackedMemorySnapshot &snapshot)
             {
                 __sampler.begin("ReadNativeObjectsAndConnections");
                 std::vector<Connection> connections;
+                std::vector<int32_t> references;
                 auto gcHandleCount = snapshot.gcHandles->size;
                 
                 auto itemCount = fs.readUInt32();
-                auto nativeObjects = snapshot.nativeObjects = new Array<PackedNativeUnityEngineObject>(itemCount);
+                auto nativeObjects = snapshot.nativeObjects = Array<PackedNativeUnityEngineObject>::create(snapshot.arena, itemCount);
                 for (auto i = 0; i < itemCount; i++)
                 {
                     auto &obj = nativeObjects->items[i];
-                    obj.name = fs.readZEString();
+                    obj.name = snapshot.strings.intern(fs.readZEString());
                     obj.instanceId = fs.readInt32();
                     obj.size = fs.readInt32();
                     obj.nativeTypeArrayIndex = fs.readInt32();
@@ -214,9 +225,11 @@ void RawMemorySnapshotReader::read(PackedMemorySnapshot &snapshot)
                     }
                     
                     auto referenceCount = fs.readUInt32();
-                    while (referenceCount-- > 0)
+                    references.resize(referenceCount);
+                    fs.readArray(references.data(), referenceCount);
+                    for (auto iter = references.begin(); iter != references.end(); iter++)
                     {
-                        auto referencedObjectIndex = fs.readInt32();
+                        auto referencedObjectIndex = *iter;
                         if (referencedObjectIndex != -1)
                         {
                             Connection c;
@@ -228,7 +241,7 @@ void RawMemorySnapshotReader::read(PackedMemorySnapshot &snapshot)
                 }
                 
                 // create_connections
-                snapshot.connections = new Array<Connection>((uint32_t)connections.size());
+                snapshot.connections = Array<Connection>::create(snapshot.arena, (uint32_t)connections.size());
                 if (connections.size() > 0)
                 {
                     memcpy((char *)snapshot.connections->items, (const char *)(&connections.front()), sizeof(Connection) * connections.size());
@@ -347,7 +360,8 @@ void RawMemorySnapshotReader::read(PackedMemorySnapshot &snapshot)
                         transform.parent = fs.readUInt64();
                         
                         auto count = fs.readUInt32();
-                        while (count-- > 0) {transform.children.push_back(fs.readUInt64());}
+                        transform.children.resize(count);
+                        fs.readArray(transform.children.data(), count);
                         
                         appending.transform = (int32_t)collection.transforms.size();
                         collection.transforms.emplace_back(transform);
@@ -365,7 +379,8 @@ void RawMemorySnapshotReader::read(PackedMemorySnapshot &snapshot)
                         transform.parent = fs.readUInt64();
                         
                         auto count = fs.readUInt32();
-                        while (count-- > 0) {transform.children.push_back(fs.readUInt64());}
+                        transform.children.resize(count);
+                        fs.readArray(transform.children.data(), count);
                         
                         // RectTransform
                         transform.rect = fs.read<NativeRect>();
@@ -466,15 +481,14 @@ void RawMemorySnapshotReader::read(PackedMemorySnapshot &snapshot)
                 }
                 
 #ifdef STRIP_NATIVE_CONNECTIONS
-                Array<Connection> *newConnections = new Array<Connection>((uint32_t)connections.size());
+                Array<Connection> *newConnections = Array<Connection>::create(snapshot.arena, (uint32_t)connections.size());
                 memcpy(newConnections->items, &connections.front(), connections.size() * sizeof(Connection));
 #else
-                Array<Connection> *newConnections = new Array<Connection>(snapshot.connections->size + (uint32_t)connections.size());
+                Array<Connection> *newConnections = Array<Connection>::create(snapshot.arena, snapshot.connections->size + (uint32_t)connections.size());
                 memcpy(newConnections->items, snapshot.connections->items, snapshot.connections->size * sizeof(Connection));
                 memcpy(newConnections->items + snapshot.connections->size, &connections.front(), connections.size() * sizeof(Connection));
 #endif
-                delete snapshot.connections;
-                snapshot.connections = newConnections;
+                snapshot.connections = newConnections; // previous one stays in arena until teardown
                 
                 for (auto iter = collection.components.begin(); iter != collection.components.end(); iter++)
                 {
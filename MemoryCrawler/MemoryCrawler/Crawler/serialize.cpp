@@ -7,12 +7,28 @@
 //
 
 #include "serialize.h"
+#include "heap.h"
 #include <map>
 
 void MemorySnapshotDeserializer::read(PackedMemorySnapshot &snapshot)
 {
     __snapshot = &snapshot;
     __fs.open(__filepath);
+    
+    if (mapping)
+    {
+        auto file = new MappedFile;
+        if (file->open(__filepath))
+        {
+            delete snapshot.mapping;
+            snapshot.mapping = file;
+            __fs.attach(file);
+        }
+        else
+        {
+            delete file;
+        }
+    }
 }
 
 MemorySnapshotReader::MemorySnapshotReader(const char *filepath): MemorySnapshotDeserializer(filepath) {}
@@ -68,7 +84,7 @@ void MemorySnapshotReader::readHeader(FileStream &fs)
 }
 
 //MARK: read object
-void readPackedNativeUnityEngineObject(PackedNativeUnityEngineObject &item, FileStream &fs)
+void readPackedNativeUnityEngineObject(PackedNativeUnityEngineObject &item, FileStream &fs, StringPool &strings)
 {
     auto fieldCount = fs.readUInt8();
     assert(fieldCount == 10);
@@ -76,7 +92,7 @@ void readPackedNativeUnityEngineObject(PackedNativeUnityEngineObject &item, File
     item.isPersistent = fs.readBoolean();
     item.isDontDestroyOnLoad = fs.readBoolean();
     item.isManager = fs.readBoolean();
-    item.name = fs.readString();
+    item.name = strings.intern(fs.readString());
     item.instanceId = fs.readInt32();
     item.size = fs.readInt32();
     item.classId = fs.readInt32();
@@ -85,34 +101,50 @@ void readPackedNativeUnityEngineObject(PackedNativeUnityEngineObject &item, File
     item.nativeObjectAddress = fs.readInt64();
 }
 
-void readPackedNativeType(PackedNativeType &item, FileStream &fs)
+void readPackedNativeType(PackedNativeType &item, FileStream &fs, StringPool &strings)
 {
     auto fieldCount = fs.readUInt8();
     assert(fieldCount == 3);
     
-    item.name = fs.readString();
+    item.name = strings.intern(fs.readString());
     item.baseClassId = fs.readInt32();
     item.nativeBaseTypeArrayIndex = fs.readInt32();
 }
 
-void readPackedGCHandle(PackedGCHandle &item, FileStream &fs)
+// fixed size records are read in one block and decoded with stride: fieldCount(1) + fields
+void readPackedGCHandles(Array<PackedGCHandle> &items, FileStream &fs)
 {
-    auto fieldCount = fs.readUInt8();
-    assert(fieldCount == 1);
+    const size_t stride = 1 + sizeof(address_t);
+    std::vector<char> bytes(stride * items.size);
+    fs.readArray(bytes.data(), bytes.size());
     
-    item.target = fs.readUInt64();
+    auto ptr = bytes.data();
+    for (auto i = 0; i < items.size; i++)
+    {
+        assert(ptr[0] == 1);
+        memcpy(&items.items[i].target, ptr + 1, sizeof(address_t));
+        ptr += stride;
+    }
 }
 
-void readConnection(Connection &item, FileStream &fs)
+void readConnections(Array<Connection> &items, FileStream &fs)
 {
-    auto fieldCount = fs.readUInt8();
-    assert(fieldCount == 2);
+    const size_t stride = 1 + 2 * sizeof(int32_t);
+    std::vector<char> bytes(stride * items.size);
+    fs.readArray(bytes.data(), bytes.size());
     
-    item.from = fs.readInt32();
-    item.to = fs.readInt32();
+    auto ptr = bytes.data();
+    for (auto i = 0; i < items.size; i++)
+    {
+        assert(ptr[0] == 2);
+        auto &item = items.items[i];
+        memcpy(&item.from, ptr + 1, sizeof(int32_t));
+        memcpy(&item.to, ptr + 1 + sizeof(int32_t), sizeof(int32_t));
+        ptr += stride;
+    }
 }
 
-void readMemorySection(MemorySection &item, FileStream &fs)
+void readMemorySection(MemorySection &item, FileStream &fs, MemoryArena &arena)
 {
     auto fieldCount = fs.readUInt8();
     assert(fieldCount == 2);
@@ -121,8 +153,16 @@ void readMemorySection(MemorySection &item, FileStream &fs)
         auto size = fs.readUInt32();
         if (size > 0)
         {
-            item.bytes = new Array<byte_t>(size);
-            fs.read((char *)(item.bytes->items), size);
+            auto borrowed = fs.borrow(size);
+            if (borrowed != nullptr)
+            {
+                item.bytes = Array<byte_t>::create(arena, size, (byte_t *)borrowed);
+            }
+            else
+            {
+                item.bytes = Array<byte_t>::create(arena, size);
+                fs.read((char *)(item.bytes->items), size);
+            }
         }
     }
     item.startAddress = fs.readUInt64();
@@ -148,18 +188,18 @@ string removeFieldWrapper(string name)
     return name;
 }
 
-void readFieldDescription(FieldDescription &item, FileStream &fs)
+void readFieldDescription(FieldDescription &item, FileStream &fs, StringPool &strings)
 {
     auto fieldCount = fs.readUInt8();
     assert(fieldCount == 4);
     
-    item.name = removeFieldWrapper(fs.readString());
+    item.name = strings.intern(removeFieldWrapper(fs.readString()));
     item.offset = fs.readInt32();
     item.typeIndex = fs.readInt32();
     item.isStatic = fs.readBoolean();
 }
 
-void readTypeDescription(TypeDescription &item, FileStream &fs)
+void readTypeDescription(TypeDescription &item, FileStream &fs, PackedMemorySnapshot &snapshot)
 {
     auto fieldCount = fs.readUInt8();
     assert(fieldCount == 11);
@@ -167,21 +207,21 @@ void readTypeDescription(TypeDescription &item, FileStream &fs)
     item.isValueType = fs.readBoolean();
     item.isArray = fs.readBoolean();
     item.arrayRank = fs.readInt32();
-    item.name = fs.readString();
-    item.assembly = fs.readString();
+    item.name = snapshot.strings.intern(fs.readString());
+    item.assembly = snapshot.strings.intern(fs.readString());
     {
         auto size = fs.readUInt32();
-        item.fields = new Array<FieldDescription>(size);
+        item.fields = Array<FieldDescription>::create(snapshot.arena, size);
         for (auto i = 0; i < size; i++)
         {
-            readFieldDescription(item.fields->items[i], fs);
+            readFieldDescription(item.fields->items[i], fs, snapshot.strings);
         }
     }
     {
         auto size = fs.readUInt32();
         if (size > 0)
         {
-            item.staticFieldBytes = new Array<byte_t>(size);
+            item.staticFieldBytes = Array<byte_t>::create(snapshot.arena, size);
             fs.read((char *)(item.staticFieldBytes->items), size);
         }
     }
@@ -214,60 +254,54 @@ void MemorySnapshotReader::readPackedMemorySnapshot(PackedMemorySnapshot &item,
     {
         __sampler.begin("ReadNativeTypes");
         auto size = fs.readUInt32();
-        item.nativeTypes = new Array<PackedNativeType>(size);
+        item.nativeTypes = Array<PackedNativeType>::create(item.arena, size);
         for (auto i = 0; i < size; i++)
         {
-            readPackedNativeType(item.nativeTypes->items[i], fs);
+            readPackedNativeType(item.nativeTypes->items[i], fs, item.strings);
         }
         __sampler.end();
     }
     {
         __sampler.begin("ReadNativeObjects");
         auto size = fs.readUInt32();
-        item.nativeObjects = new Array<PackedNativeUnityEngineObject>(size);
+        item.nativeObjects = Array<PackedNativeUnityEngineObject>::create(item.arena, size);
         for (auto i = 0; i < size; i++)
         {
-            readPackedNativeUnityEngineObject(item.nativeObjects->items[i], fs);
+            readPackedNativeUnityEngineObject(item.nativeObjects->items[i], fs, item.strings);
         }
         __sampler.end();
     }
     {
         __sampler.begin("ReadGCHandles");
         auto size = fs.readUInt32();
-        item.gcHandles = new Array<PackedGCHandle>(size);
-        for (auto i = 0; i < size; i++)
-        {
-            readPackedGCHandle(item.gcHandles->items[i], fs);
-        }
+        item.gcHandles = Array<PackedGCHandle>::create(item.arena, size);
+        readPackedGCHandles(*item.gcHandles, fs);
         __sampler.end();
     }
     {
         __sampler.begin("ReadConnections");
         auto size = fs.readUInt32();
-        item.connections = new Array<Connection>(size);
-        for (auto i = 0; i < size; i++)
-        {
-            readConnection(item.connections->items[i], fs);
-        }
+        item.connections = Array<Connection>::create(item.arena, size);
+        readConnections(*item.connections, fs);
         __sampler.end();
     }
     {
         __sampler.begin("ReadHeapMemorySections");
         auto size = fs.readUInt32();
-        item.heapSections = new Array<MemorySection>(size);
+        item.heapSections = Array<MemorySection>::create(item.arena, size);
         for (auto i = 0; i < size; i++)
         {
-            readMemorySection(item.heapSections->items[i], fs);
+            readMemorySection(item.heapSections->items[i], fs, item.arena);
         }
         __sampler.end();
     }
     {
         __sampler.begin("ReadTypeDescriptions");
         auto size = fs.readUInt32();
-        item.typeDescriptions = new Array<TypeDescription>(size);
+        item.typeDescriptions = Array<TypeDescription>::create(item.arena, size);
         for (auto i = 0; i < size; i++)
         {
-            readTypeDescription(item.typeDescriptions->items[i], fs);
+            readTypeDescription(item.typeDescriptions->items[i], fs, item);
         }
         __sampler.end();
     }
@@ -289,7 +323,7 @@ void MemorySnapshotReader::readSnapshot(FileStream &fs)
     prepareSnapshot();
 }
 
-bool strend(const string *s, const string *with)
+bool strend(const PooledString *s, const string *with)
 {
     auto its = s->rbegin();
     auto itw = with->rbegin();
@@ -459,6 +493,10 @@ void MemorySnapshotDeserializer::prepareSnapshot()
     }
     __sampler.end();
     
+    __sampler.begin("CreateHeapAddressTable");
+    __snapshot->heapAddressTable = new HeapAddressTable(*sortedHeapSections);
+    __sampler.end();
+    
     __sampler.begin("SetNativeObjectIndex");
     Array<PackedNativeUnityEngineObject> &nativeObjects = *__snapshot->nativeObjects;
     for (auto i = 0; i < nativeObjects.size; i++)
@@ -26,6 +26,7 @@ protected:
     FieldDescription *__cachedPtr;
 public:
     string uuid;
+    bool mapping = true; // memory sections borrow bytes from file mapping instead of copying
     
 public:
     MemorySnapshotDeserializer(const char *filepath)
@@ -8,42 +8,8 @@
 
 #include <stdio.h>
 #include "snapshot.h"
-
-Connection::~Connection()
-{
-    
-}
-
-FieldDescription::~FieldDescription()
-{
-    
-}
-
-TypeDescription::~TypeDescription()
-{
-    delete fields;
-    delete staticFieldBytes;
-}
-
-MemorySection::~MemorySection()
-{
-     delete bytes;
-}
-
-PackedGCHandle::~PackedGCHandle()
-{
-    
-}
-
-PackedNativeUnityEngineObject::~PackedNativeUnityEngineObject()
-{
-    
-}
-
-PackedNativeType::~PackedNativeType()
-{
-    
-}
+#include "stream.h"
+#include "heap.h"
 
 VirtualMachineInformation::~VirtualMachineInformation()
 {
@@ -52,12 +18,8 @@ VirtualMachineInformation::~VirtualMachineInformation()
 
 PackedMemorySnapshot::~PackedMemorySnapshot()
 {
-    delete connections;
-    delete gcHandles;
-    delete heapSections;
-    delete nativeObjects;
-    delete nativeTypes;
-    delete typeDescriptions;
+    delete heapAddressTable;
     delete sortedHeapSections;
+    delete mapping;
 }
 
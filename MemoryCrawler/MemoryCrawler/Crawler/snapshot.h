@@ -13,6 +13,10 @@
 #include <string>
 #include <vector>
 #include "types.h"
+#include "intern.h"
+
+class MappedFile;
+class HeapAddressTable;
 
 using std::string;
 
@@ -26,8 +30,6 @@ struct Connection
     int32_t to;
     ConnectionKind fromKind = CK_none;
     ConnectionKind toKind = CK_none;
-    
-    ~Connection();
 };
 
 struct NativeManagedLink
@@ -148,17 +150,15 @@ struct FieldDescription
     int32_t offset;
     int32_t typeIndex;
     int32_t hookTypeIndex = -1;
-    string name;
-    
-    ~FieldDescription();
+    PooledString name;
 };
 
 struct TypeDescription
 {
     address_t typeInfoAddress;
-    string assembly;
+    PooledString assembly;
     Array<FieldDescription>* fields = nullptr; // FieldDescription[]
-    string name;
+    PooledString name;
     Array<byte_t> *staticFieldBytes = nullptr; // byte[]
     int32_t arrayRank;
     int32_t baseOrElementTypeIndex;
@@ -173,8 +173,6 @@ struct TypeDescription
     bool isArray;
     bool isValueType;
     bool isUnityEngineObjectType;
-    
-    ~TypeDescription();
 };
 
 struct MemorySection
@@ -183,8 +181,6 @@ struct MemorySection
     address_t startAddress;
     int32_t heapArrayIndex = -1;
     int32_t size;
-    
-    ~MemorySection();
 };
 
 struct PackedGCHandle
@@ -193,8 +189,6 @@ struct PackedGCHandle
     
     int32_t gcHandleArrayIndex = -1;
     int32_t managedObjectArrayIndex = -1;
-    
-    ~PackedGCHandle();
 };
 
 struct PackedNativeUnityEngineObject
@@ -209,7 +203,7 @@ struct PackedNativeUnityEngineObject
     bool isManager;
     bool isPersistent;
     MemoryState state = MS_none;
-    string name;
+    PooledString name;
     address_t nativeObjectAddress;
     int32_t nativeTypeArrayIndex;
     int32_t size;
@@ -217,13 +211,11 @@ struct PackedNativeUnityEngineObject
     
     int32_t managedObjectArrayIndex = -1;
     int32_t nativeObjectArrayIndex = -1;
-    
-    ~PackedNativeUnityEngineObject();
 };
 
 struct PackedNativeType
 {
-    string name;
+    PooledString name;
     int32_t nativeBaseTypeArrayIndex;
     int32_t baseClassId;
     
@@ -231,8 +223,6 @@ struct PackedNativeType
     int32_t managedTypeArrayIndex = -1;
     int32_t instanceCount = 0;
     int32_t instanceMemory = 0;
-    
-    ~PackedNativeType();
 };
 
 struct VirtualMachineInformation
@@ -248,8 +238,11 @@ struct VirtualMachineInformation
     ~VirtualMachineInformation();
 };
 
+// arrays of snapshot are allocated from arena and released together with it
 struct PackedMemorySnapshot
 {
+    MemoryArena arena;
+    StringPool strings; // names of types, fields and native objects
     Array<Connection> *connections = nullptr; // Connection[]
     Array<PackedGCHandle> *gcHandles = nullptr; // PackedGCHandle[]
     Array<MemorySection> *heapSections = nullptr; // MemorySection[]
@@ -261,6 +254,8 @@ struct PackedMemorySnapshot
     NativeAppendingCollection nativeAppendingCollection;
     
     std::vector<MemorySection *> *sortedHeapSections = nullptr;
+    HeapAddressTable *heapAddressTable = nullptr;
+    MappedFile *mapping = nullptr; // backs memory sections that borrow bytes
     
     ManagedTypeIndex managedTypeIndex;
     NativeTypeIndex nativeTypeIndex;
@@ -6,9 +6,104 @@
 //  Copyright © 2019 larryhou. All rights reserved.
 //
 
+#include <cassert>
 #include "stat.h"
 using std::pair;
 
+QuantileSketch::QuantileSketch(double accuracy)
+{
+    __logGamma = log((1 + accuracy) / (1 - accuracy));
+}
+
+int32_t QuantileSketch::keyOf(double value) const
+{
+    return (int32_t)ceil(log(value) / __logGamma);
+}
+
+double QuantileSketch::valueOf(int32_t key) const
+{
+    // midpoint of (gamma^(key-1), gamma^key] in relative error
+    auto gamma = exp(__logGamma);
+    return 2 * exp(key * __logGamma) / (gamma + 1);
+}
+
+void QuantileSketch::insert(std::vector<int64_t> &bins, int32_t &offset, int32_t key, int64_t count)
+{
+    if (bins.size() == 0)
+    {
+        offset = key;
+        bins.push_back(count);
+        return;
+    }
+    
+    if (key < offset)
+    {
+        bins.insert(bins.begin(), offset - key, 0);
+        offset = key;
+    }
+    else if (key - offset >= bins.size())
+    {
+        bins.resize(key - offset + 1, 0);
+    }
+    bins[key - offset] += count;
+}
+
+void QuantileSketch::add(double value)
+{
+    constexpr double MINIMUM = 1E-9;
+    if (value > MINIMUM) { insert(__positives, __positiveOffset, keyOf(value), 1); }
+    else if (value < -MINIMUM) { insert(__negatives, __negativeOffset, keyOf(-value), 1); }
+    else { ++__zeroCount; }
+    ++__count;
+}
+
+void QuantileSketch::merge(const QuantileSketch &other)
+{
+    assert(__logGamma == other.__logGamma);
+    for (auto i = 0; i < other.__positives.size(); i++)
+    {
+        if (other.__positives[i] > 0) {insert(__positives, __positiveOffset, other.__positiveOffset + i, other.__positives[i]);}
+    }
+    for (auto i = 0; i < other.__negatives.size(); i++)
+    {
+        if (other.__negatives[i] > 0) {insert(__negatives, __negativeOffset, other.__negativeOffset + i, other.__negatives[i]);}
+    }
+    __zeroCount += other.__zeroCount;
+    __count += other.__count;
+}
+
+void QuantileSketch::clear()
+{
+    __positives.clear();
+    __negatives.clear();
+    __positiveOffset = __negativeOffset = 0;
+    __zeroCount = __count = 0;
+}
+
+double QuantileSketch::quantile(double q) const
+{
+    if (__count == 0) {return 0;}
+    
+    auto rank = (int64_t)(std::min(std::max(q, 0.0), 1.0) * (__count - 1));
+    int64_t n = 0;
+    for (auto i = (int32_t)__negatives.size() - 1; i >= 0; i--)
+    {
+        n += __negatives[i];
+        if (n > rank) {return -valueOf(__negativeOffset + i);}
+    }
+    
+    n += __zeroCount;
+    if (n > rank) {return 0;}
+    
+    for (auto i = 0; i < __positives.size(); i++)
+    {
+        n += __positives[i];
+        if (n > rank) {return valueOf(__positiveOffset + i);}
+    }
+    
+    return valueOf(__positiveOffset + (int32_t)__positives.size() - 1);
+}
+
 void TrackStatistics::collect(int32_t itemIndex, int32_t typeIndex, int32_t size)
 {
     __samples.push_back(std::make_tuple(itemIndex, typeIndex, size));
@@ -9,6 +9,7 @@
 #ifndef stat_h
 #define stat_h
 
+#include <algorithm>
 #include <vector>
 #include <map>
 
@@ -131,6 +132,128 @@ void Statistics<T>::clear()
     __samples.clear();
 }
 
+// logarithmic buckets keep quantiles within relative accuracy, in the way of DDSketch
+class QuantileSketch
+{
+    double __logGamma;
+    
+    std::vector<int64_t> __positives;
+    std::vector<int64_t> __negatives;
+    int32_t __positiveOffset = 0;
+    int32_t __negativeOffset = 0;
+    int64_t __zeroCount = 0;
+    int64_t __count = 0;
+    
+public:
+    QuantileSketch(double accuracy = 0.01);
+    
+    void add(double value);
+    void merge(const QuantileSketch &other);
+    void clear();
+    
+    // q in [0, 1]
+    double quantile(double q) const;
+    int64_t size() const { return __count; }
+    
+private:
+    int32_t keyOf(double value) const;
+    double valueOf(int32_t key) const;
+    static void insert(std::vector<int64_t> &bins, int32_t &offset, int32_t key, int64_t count);
+};
+
+// single pass statistics without keeping samples, partial states from workers can be merged
+template <class T>
+class StreamStatistics
+{
+    QuantileSketch __sketch;
+    double __squareDelta = 0;
+    
+public:
+    T minimum = 0;
+    T maximum = 0;
+    
+    double sum = 0;
+    double mean = 0;
+    
+public:
+    StreamStatistics();
+    void collect(T sample);
+    void merge(const StreamStatistics<T> &other);
+    void clear();
+    int64_t size() const { return __sketch.size(); }
+    
+    double standardDeviation() const;
+    T quantile(double q) const;
+};
+
+template <class T>
+StreamStatistics<T>::StreamStatistics()
+{
+    static_assert(std::is_arithmetic<T>::value, "NOT summarizable type");
+}
+
+template <class T>
+void StreamStatistics<T>::collect(T sample)
+{
+    auto count = __sketch.size() + 1;
+    if (count == 1) {minimum = maximum = sample;}
+    if (sample < minimum) {minimum = sample;}
+    if (sample > maximum) {maximum = sample;}
+    
+    // Welford
+    auto delta = (double)sample - mean;
+    mean += delta / (double)count;
+    __squareDelta += delta * ((double)sample - mean);
+    sum += sample;
+    
+    __sketch.add(sample);
+}
+
+template <class T>
+void StreamStatistics<T>::merge(const StreamStatistics<T> &other)
+{
+    auto n = (double)size();
+    auto m = (double)other.size();
+    if (m == 0) {return;}
+    if (n == 0) { *this = other; return; }
+    
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+    
+    auto delta = other.mean - mean;
+    __squareDelta += other.__squareDelta + delta * delta * n * m / (n + m);
+    mean += delta * m / (n + m);
+    sum += other.sum;
+    
+    __sketch.merge(other.__sketch);
+}
+
+template <class T>
+void StreamStatistics<T>::clear()
+{
+    __sketch.clear();
+    __squareDelta = 0;
+    minimum = maximum = 0;
+    sum = mean = 0;
+}
+
+template <class T>
+double StreamStatistics<T>::standardDeviation() const
+{
+    auto count = size();
+    return count > 1 ? sqrt(__squareDelta / (double)(count - 1)) : 0;
+}
+
+template <class T>
+T StreamStatistics<T>::quantile(double q) const
+{
+    if (size() == 0) {return 0;}
+    auto value = __sketch.quantile(q);
+    if (value < minimum) {return minimum;}
+    if (value > maximum) {return maximum;}
+    return (T)value;
+}
+
 class TrackStatistics
 {
     using sample_t = std::tuple<int32_t/*element_index*/, int32_t/*type_index*/, int32_t/*element_size*/>;
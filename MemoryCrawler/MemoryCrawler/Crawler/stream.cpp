@@ -7,6 +7,10 @@
 //
 
 #include "stream.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 constexpr static char __hexmap[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
 
@@ -18,6 +22,17 @@ FileStream::FileStream()
 void FileStream::open(const char* filepath, std::ios_base::openmode mode)
 {
     __fs.open(filepath, mode);
+    
+    __offset = __cursor = __limit = 0;
+    __fileSize = 0;
+    __eof = false;
+    __reading = (mode & std::ios_base::in) != 0;
+    if (__reading && __fs.is_open())
+    {
+        __fs.seekg(0, std::ios_base::end);
+        __fileSize = __fs.tellg();
+        __fs.seekg(0, std::ios_base::beg);
+    }
 }
 
 void FileStream::open(const char* filepath)
@@ -32,43 +47,150 @@ void FileStream::close()
 
 bool FileStream::byteAvailable()
 {
-    return !__fs.eof();
+    return !__eof;
 }
 
-void FileStream::ignore(size_t size)
+size_t FileStream::refill()
+{
+    if (__window == nullptr) {__window = new char[WINDOW_SIZE];}
+    
+    __offset += __limit;
+    __cursor = __limit = 0;
+    
+    __fs.read(__window, WINDOW_SIZE);
+    __limit = __fs.gcount();
+    if (__limit < WINDOW_SIZE) {__fs.clear();}
+    return __limit;
+}
+
+bool FileStream::fetch(char *buffer, size_t size)
 {
-    auto block = sizeof(__buf);
-    while (size >= block)
+    if (size == 0) {return true;}
+    
+    auto available = __limit - __cursor;
+    if (size <= available)
+    {
+        memcpy(buffer, __window + __cursor, size);
+        __cursor += size;
+        return true;
+    }
+    
+    if (available > 0)
+    {
+        memcpy(buffer, __window + __cursor, available);
+        buffer += available;
+        size -= available;
+    }
+    
+    size_t count;
+    if (size >= WINDOW_SIZE)
+    {
+        // large blocks bypass window
+        __offset += __limit;
+        __cursor = __limit = 0;
+        __fs.read(buffer, size);
+        count = __fs.gcount();
+        if (count < size) {__fs.clear();}
+        __offset += count;
+    }
+    else
     {
-        __fs.read(__buf, block);
-        size -= block;
+        count = std::min(refill(), size);
+        memcpy(buffer, __window, count);
+        __cursor = count;
     }
     
-    if (size > 0)
+    if (count < size)
     {
-        __fs.read(__buf, size);
+        memset(buffer + count, 0, size - count);
+        __eof = true;
+        return false;
+    }
+    
+    return true;
+}
+
+void FileStream::ignore(size_t size)
+{
+    auto position = tell();
+    if (size > __fileSize - std::min(position, __fileSize))
+    {
+        seek(__fileSize, std::ios_base::beg);
+        __eof = true;
+    }
+    else
+    {
+        seek(position + size, std::ios_base::beg);
     }
 }
 
 void FileStream::seek(size_t offset, seekdir_t whence)
 {
-    __fs.seekg(offset, whence);
+    if (!__reading)
+    {
+        __fs.seekg(offset, whence);
+        return;
+    }
+    
+    auto position = offset;
+    if (whence == std::ios_base::cur) {position += tell();}
+    else if (whence == std::ios_base::end) {position += __fileSize;}
+    
+    __eof = false;
+    if (position >= __offset && position <= __offset + __limit)
+    {
+        __cursor = position - __offset;
+    }
+    else
+    {
+        __fs.clear();
+        __fs.seekg(position, std::ios_base::beg);
+        __offset = position;
+        __cursor = __limit = 0;
+    }
+}
+
+size_t FileStream::refresh()
+{
+    if (!__reading) {return __fileSize;}
+    
+    // window may hold a short tail read before file grew
+    auto position = tell();
+    __fs.clear();
+    __fs.seekg(0, std::ios_base::end);
+    __fileSize = __fs.tellg();
+    __fs.seekg(position, std::ios_base::beg);
+    __offset = position;
+    __cursor = __limit = 0;
+    __eof = false;
+    return __fileSize;
 }
 
 size_t FileStream::tell()
 {
-    return __fs.tellg();
+    return __reading ? __offset + __cursor : (size_t)__fs.tellp();
 }
 
 void FileStream::read(char *buffer, size_t size)
 {
-    __fs.read(buffer, size);
+    fetch(buffer, size);
+}
+
+const char *FileStream::borrow(size_t size)
+{
+    if (__mapping == nullptr) {return nullptr;}
+    
+    auto offset = tell();
+    if (offset + size > __mapping->size()) {return nullptr;}
+    
+    seek(offset + size, std::ios_base::beg);
+    return __mapping->data() + offset;
 }
 
 string FileStream::readUUID()
 {
     char uuid[16];
-    __fs.read(uuid, 16);
+    fetch(uuid, 16);
     auto offset = 0;
     for (auto i = 0; i < 16; ++i)
     {
@@ -89,13 +211,13 @@ string FileStream::readUUID()
 void FileStream::skipString()
 {
     size_t size = readUInt32();
-    __fs.read(__buf, size);
+    ignore(size);
 }
 
 void FileStream::skipString(bool reverseEndian)
 {
     size_t size = readUInt32(reverseEndian);
-    __fs.read(__buf, size);
+    ignore(size);
 }
 
 string FileStream::readString(bool reverseEndian)
@@ -112,32 +234,47 @@ string FileStream::readString()
 
 string FileStream::readString(size_t size)
 {
-    __fs.read(__buf, size);
-    string s(__buf, size);
+    string s(size, 0);
+    fetch(&s[0], size);
     return s;
 }
 
 string FileStream::readZEString()
 {
-    *__buf = 0;
-    auto ptr = __buf;
-    do
+    string s;
+    while (true)
     {
-        __fs.read(ptr, 1);
-    } while (*ptr++ != 0);
-    return __buf;
+        if (__cursor == __limit && refill() == 0)
+        {
+            __eof = true;
+            break;
+        }
+        
+        auto begin = __window + __cursor;
+        auto end = (const char *)memchr(begin, 0, __limit - __cursor);
+        if (end != nullptr)
+        {
+            s.append(begin, end - begin);
+            __cursor += end - begin + 1;
+            break;
+        }
+        
+        s.append(begin, __limit - __cursor);
+        __cursor = __limit;
+    }
+    return s;
 }
 
 void FileStream::skipUnicodeString()
 {
     size_t size = readUInt32();
-    __fs.read(__buf, size << 1);
+    ignore(size << 1);
 }
 
 void FileStream::skipUnicodeString(bool reverseEndian)
 {
     size_t size = readUInt32(reverseEndian);
-    __fs.read(__buf, size << 1);
+    ignore(size << 1);
 }
 
 unicode_t FileStream::readUnicodeString(bool reverseEndian)
@@ -154,15 +291,16 @@ unicode_t FileStream::readUnicodeString()
 
 unicode_t FileStream::readUnicodeString(size_t size)
 {
-    __fs.read(__buf, size << 1);
-    unicode_t s((char16_t *)__buf, size);
+    unicode_t s(size, 0);
+    fetch((char *)&s[0], size << 1);
     return s;
 }
 
 bool FileStream::readBoolean()
 {
-    __fs.read(__buf, 1);
-    return __buf[0] != 0;
+    char v;
+    fetch(&v, 1);
+    return v != 0;
 }
 
 void FileStream::write(const char *v)
@@ -207,4 +345,42 @@ FileStream::~FileStream()
 {
     delete __memory;
     delete __bytes;
+    delete [] __window;
+}
+
+bool MappedFile::open(const char *filepath)
+{
+    close();
+    
+    auto fd = ::open(filepath, O_RDONLY);
+    if (fd == -1) {return false;}
+    
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        auto data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            __data = (const char *)data;
+            __size = st.st_size;
+        }
+    }
+    
+    ::close(fd);
+    return __data != nullptr;
+}
+
+void MappedFile::close()
+{
+    if (__data != nullptr)
+    {
+        munmap((void *)__data, __size);
+        __data = nullptr;
+        __size = 0;
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    close();
 }
@@ -12,6 +12,8 @@
 #include <fstream>
 #include <string>
 #include <streambuf>
+#include <cstring>
+#include <algorithm>
 #include "types.h"
 
 using std::string;
@@ -28,6 +30,92 @@ struct MemoryBuffer: std::streambuf
     }
 };
 
+template <size_t N>
+struct EndianSwapper
+{
+    template <typename T>
+    static T swap(T v)
+    {
+        auto ptr = (char *)&v;
+        std::reverse(ptr, ptr + N);
+        return v;
+    }
+};
+
+template <>
+struct EndianSwapper<1>
+{
+    template <typename T>
+    static T swap(T v) { return v; }
+};
+
+template <>
+struct EndianSwapper<2>
+{
+    template <typename T>
+    static T swap(T v)
+    {
+        uint16_t u;
+        memcpy(&u, &v, 2);
+        u = __builtin_bswap16(u);
+        memcpy(&v, &u, 2);
+        return v;
+    }
+};
+
+template <>
+struct EndianSwapper<4>
+{
+    template <typename T>
+    static T swap(T v)
+    {
+        uint32_t u;
+        memcpy(&u, &v, 4);
+        u = __builtin_bswap32(u);
+        memcpy(&v, &u, 4);
+        return v;
+    }
+};
+
+template <>
+struct EndianSwapper<8>
+{
+    template <typename T>
+    static T swap(T v)
+    {
+        uint64_t u;
+        memcpy(&u, &v, 8);
+        u = __builtin_bswap64(u);
+        memcpy(&v, &u, 8);
+        return v;
+    }
+};
+
+template <typename T>
+inline T swapEndian(T v) { return EndianSwapper<sizeof(T)>::swap(v); }
+
+// plain loop over bswap gets vectorized into byte shuffles by compiler
+template <typename T>
+inline void swapEndian(T *items, size_t count)
+{
+    for (size_t i = 0; i < count; i++) { items[i] = swapEndian(items[i]); }
+}
+
+class MappedFile
+{
+    const char *__data = nullptr;
+    size_t __size = 0;
+    
+public:
+    ~MappedFile();
+    
+    bool open(const char *filepath);
+    void close();
+    
+    const char *data() const { return __data; }
+    size_t size() const { return __size; }
+};
+
 class FileStream
 {
 public:
@@ -40,11 +128,26 @@ public:
     
     bool byteAvailable();
     
+    bool isOpen() { return __fs.is_open(); }
+    bool good() { return !__fs.fail(); } // no read/write/close failure so far
+    
     size_t tell();
     void seek(size_t offset, seekdir_t whence);
+    size_t size() const { return __fileSize; }
+    
+    // pick up size of a file that grows while being read, returns new size
+    size_t refresh();
     
     void read(char *buffer, size_t size);
     
+    // decode count elements at once
+    template <typename T>
+    void readArray(T *items, size_t count, bool reverseEndian = false);
+    
+    // attach a mapping of the same file to borrow bytes without copying
+    void attach(const MappedFile *mapping) { __mapping = mapping; }
+    const char *borrow(size_t size);
+    
     void ignore(size_t size);
     
     float readFloat() { return read<float>(); }
@@ -117,6 +220,20 @@ private:
     char *__bytes = nullptr;
     char __buf[64*1024];
     MemoryBuffer *__memory = nullptr;
+    const MappedFile *__mapping = nullptr;
+    
+    // read window over file, __offset is file position of window head
+    static constexpr size_t WINDOW_SIZE = 1 << 20;
+    char *__window = nullptr;
+    size_t __offset = 0;
+    size_t __cursor = 0;
+    size_t __limit = 0;
+    size_t __fileSize = 0;
+    bool __reading = false;
+    bool __eof = false;
+    
+    bool fetch(char *buffer, size_t size);
+    size_t refill();
 };
 
 template <typename T>
@@ -143,25 +260,24 @@ void FileStream::write(T v, bool reverseEndian)
 template <typename T>
 T FileStream::read()
 {
-    __fs.read(__buf, sizeof(T));
-    return *(T *)__buf;
+    T v;
+    fetch((char *)&v, sizeof(T));
+    return v;
 }
 
 template <typename T>
 T FileStream::read(bool reverseEndian)
 {
-    auto size = sizeof(T);
-    if (reverseEndian)
-    {
-        auto ptr = __buf + size - 1;
-        for (auto i = 0; i < size; i++) { __fs.read(ptr--, 1); }
-    }
-    else
-    {
-        __fs.read(__buf, size);
-    }
-    
-    return *(T *)__buf;
+    T v;
+    fetch((char *)&v, sizeof(T));
+    return reverseEndian ? swapEndian(v) : v;
+}
+
+template <typename T>
+void FileStream::readArray(T *items, size_t count, bool reverseEndian)
+{
+    fetch((char *)items, sizeof(T) * count);
+    if (reverseEndian) {swapEndian(items, count);}
 }
 
 #endif /* stream_h */
@@ -10,6 +10,7 @@
 #define types_h
 #include <ios>
 #include <string>
+#include "arena.h"
 
 using byte_t = unsigned char;
 using address_t = uint64_t;
@@ -35,14 +36,28 @@ struct Array
 {
     int32_t size = 0;
     T *items;
+    bool owning = true;
     
     Array(int32_t size): size(size)
     {
         assert(size >= 0);
         items = new T[size];
     }
+    // borrow items from external storage, e.g. memory mapped file
+    Array(T *items, int32_t size): size(size), items(items), owning(false)
+    {
+        assert(size >= 0);
+    }
     T &operator[](const int32_t index) { return items[index]; }
-    ~Array() { delete [] items; }
+    ~Array() { if (owning) {delete [] items;} }
+    
+    // header and items both live in arena, never delete them
+    static Array<T> *create(MemoryArena &arena, int32_t size, T *items = nullptr)
+    {
+        if (items == nullptr) { items = arena.create<T>(size); }
+        auto array = new (arena.allocate(sizeof(Array<T>), alignof(Array<T>))) Array<T>(items, size);
+        return array;
+    }
 };
 
 struct ManagedTypeIndex
@@ -16,6 +16,7 @@
 #include "Crawler/crawler.h"
 #include "Crawler/cache.h"
 #include "Crawler/leak.h"
+#include "Crawler/bench.h"
 #include "Crawler/rserialize.h"
 #include "Crawler/format.h"
 #include "utils.h"
@@ -126,7 +127,7 @@ void processMemorySnapshot(const char * filepath)
             readCommandOptions(command, [&](std::vector<const char *> &options)
                                {
                                    PackedMemorySnapshot __snapshot;
-                                   MemorySnapshotCrawler __crawler(&snapshot);
+                                   MemorySnapshotCrawler __crawler(&__snapshot);
                                    if (options.size() == 1)
                                    {
                                        SnapshotCrawlerCache().read(uuid, &__crawler);
@@ -140,17 +141,31 @@ void processMemorySnapshot(const char * filepath)
         }
         else if (strbeg(command, "save"))
         {
-            SnapshotCrawlerCache().save(mainCrawler);
+            readCommandOptions(command, [&](std::vector<const char *> &options)
+                               {
+                                   if (options.size() > 1 && 0 == strcmp(options[1], "sqlite"))
+                                   {
+                                       SnapshotCrawlerCache().saveDatabase(mainCrawler);
+                                   }
+                                   else
+                                   {
+                                       SnapshotCrawlerCache().save(mainCrawler);
+                                   }
+                               });
         }
         else if (strbeg(command, "load"))
         {
             readCommandOptions(command, [&](std::vector<const char *> &options)
                                {
                 if (options.size() == 1) {return;}
-                PackedMemorySnapshot __snapshot;
-                MemorySnapshotCrawler crawler(&deserialize(options[1], __snapshot));
-                crawler.crawl();
-                mainCrawler.compare(crawler);
+                SnapshotBaseline baseline;
+                {
+                    PackedMemorySnapshot __snapshot;
+                    MemorySnapshotCrawler crawler(&deserialize(options[1], __snapshot));
+                    crawler.crawl();
+                    baseline.capture(crawler);
+                }
+                mainCrawler.compare(baseline);
             });
         }
         else if (strbeg(command, "uuid"))
@@ -358,6 +373,28 @@ void processMemorySnapshot(const char * filepath)
                                    inspectCondition<PackedNativeUnityEngineObject>(subcommand);
                                });
         }
+        else if (strbeg(command, "bench"))
+        {
+            readCommandOptions(command, [&](std::vector<const char *> &options)
+                               {
+                                   if (options.size() == 1){return;}
+                                   if (0 == strcmp(options[1], "addr"))
+                                   {
+                                       std::vector<address_t> addresses;
+                                       auto &managedObjects = mainCrawler.managedObjects;
+                                       for (auto i = 0; i < managedObjects.size(); i++)
+                                       {
+                                           auto &mo = managedObjects[i];
+                                           if (!mo.isValueType) {addresses.push_back(mo.address);}
+                                       }
+                                       benchAddressIndex(addresses);
+                                   }
+                                   else if (0 == strcmp(options[1], "stream") && options.size() > 2)
+                                   {
+                                       benchFileStream(options[2]);
+                                   }
+                               });
+        }
         else if (strbeg(command, "track"))
         {
             readCommandOptions(command, [&](std::vector<const char *> &options)
@@ -583,6 +620,52 @@ void processMemorySnapshot(const char * filepath)
                                    mainCrawler.topNObjects(options.size() == 1 ? 50 : atoi(options[1]));
                                });
         }
+        else if (strbeg(command, "diff"))
+        {
+            readCommandOptions(command, [&](std::vector<const char *> &options)
+                               {
+                                   if (options.size() > 2 && 0 == strcmp(options[1], "save"))
+                                   {
+                                       SnapshotBaseline baseline;
+                                       baseline.capture(mainCrawler);
+                                       if (!baseline.save(options[2]))
+                                       {
+                                           printf("\e[31mfailed to save baseline: %s\e[0m\n", options[2]);
+                                       }
+                                   }
+                                   else if (options.size() > 2 && 0 == strcmp(options[1], "load"))
+                                   {
+                                       SnapshotBaseline baseline;
+                                       if (!baseline.load(options[2]))
+                                       {
+                                           printf("\e[31mnot a baseline file: %s\e[0m\n", options[2]);
+                                           return;
+                                       }
+                                       mainCrawler.compare(baseline);
+                                       mainCrawler.dumpDiff(options.size() > 3 ? atoi(options[3]) : 20);
+                                   }
+                                   else
+                                   {
+                                       mainCrawler.dumpDiff(options.size() > 1 ? atoi(options[1]) : 20);
+                                   }
+                               });
+        }
+        else if (strbeg(command, "retain"))
+        {
+            readCommandOptions(command, [&](std::vector<const char *> options)
+                               {
+                                   mainCrawler.topRetainers(options.size() == 1 ? 50 : atoi(options[1]));
+                               });
+        }
+        else if (strbeg(command, "dom"))
+        {
+            readCommandOptions(command, [&](std::vector<const char *> options)
+                               {
+                                   mainCrawler.dumpDominatorTree(options.size() > 1 ? castAddress(options[1]) : 0,
+                                                                 options.size() > 2 ? atoi(options[2]) : 2,
+                                                                 options.size() > 3 ? atoi(options[3]) : 10);
+                               });
+        }
         else if (strbeg(command, "frag"))
         {
             readCommandOptions(command, [&](std::vector<const char *> options)
@@ -734,12 +817,23 @@ void processMemorySnapshot(const char * filepath)
                                    {
                                        mainCrawler.dumpRepeatedObjects(mainCrawler.snapshot->managedTypeIndex.system_String);
                                    }
+                                   else if (strcmp(options[1], "all") == 0)
+                                   {
+                                       mainCrawler.dumpDuplicateObjects(options.size() >= 3 ? atoi(options[2]) : 20);
+                                   }
                                    else
                                    {
                                        mainCrawler.dumpRepeatedObjects(atoi(options[1]), options.size() >= 3? atoi(options[2]) : 2);
                                    }
                                });
         }
+        else if (strbeg(command, "sweep"))
+        {
+            readCommandOptions(command, [&](std::vector<const char *> options)
+                               {
+                                   mainCrawler.dumpUnreachableObjects(options.size() >= 2 ? atoi(options[1]) : 20);
+                               });
+        }
         else if (strbeg(command, "handle"))
         {
             mainCrawler.dumpGCHandles();
@@ -751,6 +845,14 @@ void processMemorySnapshot(const char * filepath)
             sprintf(exportpath, "__export/%s.heap", filename.c_str());
             HeapExplorerFormat().encode(&snapshot, exportpath);
         }
+        else if (strbeg(command, "trace"))
+        {
+            char tracepath[256];
+            mkdir("__trace", 0777);
+            sprintf(tracepath, "__trace/%s", filename.c_str());
+            PerfTrace::shared().summarize();
+            if (PerfTrace::shared().save(tracepath)) {printf("%s.json %s.folded\n", tracepath, tracepath);}
+        }
         else if (strbeg(command, "quit"))
         {
             recordable = false;
@@ -762,7 +864,7 @@ void processMemorySnapshot(const char * filepath)
         {
             recordable = false;
             const int __indent = 6;
-            help("read", "[UUID]*", "读取以sqlite3保存的内存快照缓存", __indent);
+            help("read", "[UUID]*", "读取保存在本机的内存快照缓存", __indent);
             help("load", "[PMS_FILE_PATH]*", "加载内存快照文件", __indent);
             help("track", "[alloc|leak]", "追踪内存增长以及泄露问题", __indent);
             help("str", "[ADDRESS]*", "解析地址对应的字符串内容", __indent);
@@ -785,13 +887,17 @@ void processMemorySnapshot(const char * filepath)
             help("size", "[ADDRESS]*", "计算托管对象引用的内存大小", __indent);
             help("type", "[TYPE_INDEX]*", "查看托管类型信息", __indent);
             help("utype", "[TYPE_INDEX]*", "查看引擎类型信息", __indent);
-            help("dup", "[TYPE_INDEX]", "按指定类型统计相同对象的信息", __indent);
+            help("dup", "[TYPE_INDEX|all [RANK]]", "按指定类型统计相同对象的信息, all按浪费内存输出全堆重复对象", __indent);
+            help("sweep", "[RANK]", "线性扫描托管堆, 按类型输出不可达对象数量与内存", __indent);
             help("stat", "[RANK]", "按类型输出托管对象内存占用前RANK名的简报[支持内存追踪过滤]", __indent);
             help("ustat", "[RANK]", "按类型输出引擎对象内存占用前RANK名的简报[支持内存追踪过滤]", __indent);
             help("bar", "[RANK]", "输出托管类型内存占用前RANK名图形简报[支持内存追踪过滤]", __indent);
             help("ubar", "[RANK]", "输出引擎类型内存占用前RANK名图形简报[支持内存追踪过滤]", __indent);
             help("top", "[RANK] [ADDRESS] [KEEP_ADDRESS_ORDER]", "按大小降序/原序输出最大的内存对象列表", __indent);
             help("utop", "[RANK]", "按大小降序输出输出Native对象列表", __indent);
+            help("diff", "[RANK|save FILE_PATH|load FILE_PATH [RANK]]", "输出与对比快照的差异，可保存/加载对比基线文件而无需重新解析快照", __indent);
+            help("retain", "[RANK]", "按支配树保留内存降序输出托管/引擎对象列表", __indent);
+            help("dom", "[ADDRESS] [DEPTH] [RANK]", "输出对象的支配链以及支配子树，缺省地址从根节点开始", __indent);
             help("list", NULL, "列举托管类型所有活跃对象内存占用简报[支持内存追踪过滤]", __indent);
             help("ulist", NULL, "列举引擎类型所有活跃对象内存占用简报[支持内存追踪过滤]", __indent);
             help("event", NULL, "搜索所有未清理的delegate对象");
@@ -806,12 +912,14 @@ void processMemorySnapshot(const char * filepath)
             help("tex", "[ADDRESS]*", "输出Texture2D资源信息", __indent);
             help("sprite", "[ADDRESS]*", "输出Sprite资源信息", __indent);
             help("base", "[TYPE_INDEX]", "查看当前类型的子类型", __indent);
-            help("save", NULL, "把当前内存快照分析结果以sqlite3格式保存到本机", __indent);
+            help("save", "[sqlite]", "把当前内存快照分析结果以二进制格式保存到本机, sqlite参数导出sqlite3数据库", __indent);
             help("uuid", NULL, "查看内存快照UUID", __indent);
+            help("trace", NULL, "输出内部耗时统计, 并导出chrome://tracing文件以及火焰图folded文件", __indent);
             help("handle", NULL, "查看GCHandle对象", __indent);
             help("static", "[TYPE_INDEX]", "查看类静态对象数据", __indent);
             help("class", "[CLASS_NAME]", "查看类信息", __indent);
             help("uname", "[UNITY_ASSET_NAME]", "列举名字以指定字符开头的所有Native对象", __indent);
+            help("bench", "[addr|stream FILE_PATH]", "测试地址索引性能或者文件流解码吞吐量", __indent);
             help("help", NULL, "帮助", __indent);
             help("quit", NULL, "退出", __indent);
             cout << std::flush;
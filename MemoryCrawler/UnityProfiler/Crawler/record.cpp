@@ -6,15 +6,149 @@
 //  Copyright © 2019 larryhou. All rights reserved.
 //
 
+#include <limits>
+#include <thread>
+#include <unistd.h>
 #include "record.h"
+#include "parallel.h"
+
+void FrameSampleStore::resize(int32_t sampleCount)
+{
+    nameRefs.resize(sampleCount);
+    callsCounts.resize(sampleCount);
+    gcAllocBytes.resize(sampleCount);
+    totalTimes.resize(sampleCount);
+    selfTimes.resize(sampleCount);
+}
+
+void FrameSampleStore::append(const StackSample *samples, int32_t count)
+{
+    if (frameOffsets.size() == 0) {frameOffsets.push_back(0);}
+    for (auto i = 0; i < count; i++)
+    {
+        auto &s = samples[i];
+        auto index = (int32_t)nameRefs.size();
+        nameRefs.push_back(s.nameRef);
+        callsCounts.push_back(s.callsCount);
+        gcAllocBytes.push_back(s.gcAllocBytes);
+        totalTimes.push_back(s.totalTime);
+        selfTimes.push_back(s.selfTime);
+        
+        if (s.nameRef < 0) {continue;}
+        if (s.nameRef >= functionSamples.size()) {functionSamples.resize(s.nameRef + 1);}
+        functionSamples[s.nameRef].push_back(index);
+    }
+    frameOffsets.push_back((int32_t)nameRefs.size());
+}
+
+void FrameSampleStore::write(int32_t offset, const StackSample *samples, int32_t count)
+{
+    for (auto i = 0; i < count; i++)
+    {
+        auto &s = samples[i];
+        auto n = offset + i;
+        nameRefs[n] = s.nameRef;
+        callsCounts[n] = s.callsCount;
+        gcAllocBytes[n] = s.gcAllocBytes;
+        totalTimes[n] = s.totalTime;
+        selfTimes[n] = s.selfTime;
+    }
+}
+
+void FrameSampleStore::buildFunctionIndex(int32_t functionCount, int32_t concurrency)
+{
+    functionSamples.clear();
+    functionSamples.resize(functionCount);
+    
+    // one block of consecutive samples per worker, counted and then scattered in place
+    WorkStealingPool<int32_t> pool(concurrency);
+    auto blockCount = pool.threadCount();
+    auto size = (int32_t)nameRefs.size();
+    auto blockSize = (size + blockCount - 1) / blockCount;
+    std::vector<std::vector<int32_t>> cursors(blockCount);
+    
+    for (auto i = 0; i < blockCount; i++) { pool.push(i, i); }
+    pool.run([&](int32_t worker, int32_t &block)
+             {
+                 auto &counts = cursors[block];
+                 counts.assign(functionCount, 0);
+                 auto stop = std::min(size, (block + 1) * blockSize);
+                 for (auto n = block * blockSize; n < stop; n++)
+                 {
+                     auto nameRef = nameRefs[n];
+                     if (nameRef >= 0 && nameRef < functionCount) {++counts[nameRef];}
+                 }
+             });
+    
+    // block counts turn into write cursors, so samples of every function stay in sample order
+    for (auto f = 0; f < functionCount; f++)
+    {
+        auto offset = 0;
+        for (auto i = 0; i < blockCount; i++)
+        {
+            auto count = cursors[i][f];
+            cursors[i][f] = offset;
+            offset += count;
+        }
+        functionSamples[f].resize(offset);
+    }
+    
+    for (auto i = 0; i < blockCount; i++) { pool.push(i, i); }
+    pool.run([&](int32_t worker, int32_t &block)
+             {
+                 auto &offsets = cursors[block];
+                 auto stop = std::min(size, (block + 1) * blockSize);
+                 for (auto n = block * blockSize; n < stop; n++)
+                 {
+                     auto nameRef = nameRefs[n];
+                     if (nameRef >= 0 && nameRef < functionCount) {functionSamples[nameRef][offsets[nameRef]++] = n;}
+                 }
+             });
+}
+
+void FrameSampleStore::clear()
+{
+    nameRefs.clear();
+    callsCounts.clear();
+    gcAllocBytes.clear();
+    totalTimes.clear();
+    selfTimes.clear();
+    frameOffsets.clear();
+    functionSamples.clear();
+}
+
+int32_t FrameSampleStore::frameOf(int32_t sample) const
+{
+    auto iter = std::upper_bound(frameOffsets.begin(), frameOffsets.end(), sample);
+    return (int32_t)(iter - frameOffsets.begin()) - 1;
+}
+
+void FollowStatistics::collect(const RenderFrame &frame, int32_t alloc)
+{
+    fps.collect(frame.fps);
+    time.collect(frame.time);
+    if (alloc > 0)
+    {
+        ++allocFrameCount;
+        allocSum += alloc;
+    }
+}
+
+void FollowStatistics::dump()
+{
+    printf("frames=%d fps=%.1f±%.1f range=[%.1f, %.1f] time.p99=%.3fms alloc=%lld/%d\n", (int32_t)fps.size(), fps.mean, 3 * fps.standardDeviation(), fps.minimum, fps.maximum, time.quantile(0.99), allocSum, allocFrameCount);
+}
 
 RecordCrawler::RecordCrawler()
 {
     
 }
 
-void RecordCrawler::load(const char *filepath)
+void RecordCrawler::load(const char *filepath, int32_t concurrency)
 {
+    if (concurrency <= 0) {concurrency = (int32_t)std::thread::hardware_concurrency();}
+    __concurrency = concurrency;
+    
     __sampler.begin("RecordCrawler::load");
     __fs.open(filepath);
     
@@ -24,6 +158,34 @@ void RecordCrawler::load(const char *filepath)
     __startTime = __fs.readUInt64();
     __strOffset = __fs.readUInt32();
     
+    // string offset is encoded when recording stops
+    __following = __strOffset == 0;
+    if (__following)
+    {
+        while (__fs.readUInt32() == 0)
+        {
+            usleep(100000);
+            __fs.refresh();
+            __fs.seek(15, seekdir_t::beg);
+        }
+        
+        __fs.seek(15, seekdir_t::beg);
+        readMetadatas();
+        __dataOffset = __followOffset = __fs.tell();
+        __stopTime = __startTime;
+        
+        printf("following %s\n", filepath);
+        while (__frames.size() == 0 && __following)
+        {
+            if (update() == 0) {usleep(100000);}
+        }
+        
+        __sampler.end();
+        __sampler.summarize();
+        return;
+    }
+    
+    __mapping.open(filepath);
     readMetadatas();
     __dataOffset = __fs.tell();
     
@@ -40,52 +202,67 @@ void RecordCrawler::load(const char *filepath)
 void RecordCrawler::crawl()
 {
     __sampler.begin("RecordCrawler::crawl");
+    __samples.clear();
+    __samples.frameOffsets.push_back(0);
+    
+    // frame headers are walked in order, sample arrays are only located
+    __sampler.begin("slice");
+    std::vector<size_t> positions;
     while (__fs.tell() < __strOffset)
     {
         RenderFrame &frame = __frames.add();
-        frame.offset = (int32_t)__fs.tell();
-        frame.index = __fs.readUInt32();
-        frame.time = __fs.readFloat();
-        frame.fps = __fs.readFloat();
-        
-        auto extra = __fs.readUInt16();
-        if (extra > 0)
-        {
-            frame.hasMemoryInfo = true;
-            auto pos = __fs.tell();
-            frame.usedHeap = __fs.readUInt64();
-            frame.usedMonoHeap = __fs.readUInt64();
-            frame.reservedMonoHeap = __fs.readUInt64();
-            frame.totalAllocatedMemory = __fs.readUInt64();
-            frame.totalReservedMemory = __fs.readUInt64();
-            frame.totalUnusedReservedMemory = __fs.readUInt64();
-            assert(__fs.tell() - pos == extra);
-        }
-        else { frame.hasMemoryInfo = false; }
-        
-        for (auto iter = __metadatas.begin(); iter != __metadatas.end(); iter++)
-        {
-            auto size = iter->second.size();
-            assert(iter->first == __fs.readUInt8());
-            AreaStatistics statistics;
-            statistics.type = (ProfilerArea)iter->first;
-            
-            for (auto i = 0; i < size; i++)
-            {
-                statistics.properties.push_back(__fs.readFloat());
-            }
-            
-            frame.statistics.graphs.emplace_back(statistics);
-        }
+        readFrameHeader(frame);
         
         auto sampleCount = __fs.readUInt32();
-        __fs.ignore(sampleCount * 24);
+        positions.push_back(__fs.tell());
+        __samples.frameOffsets.push_back(__samples.frameOffsets.back() + sampleCount);
+        __fs.ignore(sampleCount * sizeof(StackSample));
         
         auto relationCount = __fs.readUInt32();
         __fs.ignore(relationCount * 8);
         
         assert(__fs.readUInt32() == 0x12345678);
     }
+    __sampler.end();
+    
+    // sample arrays are decoded by blocks of frames straight into their columns
+    __sampler.begin("decode");
+    static_assert(sizeof(StackSample) == 24, "StackSample should match sample record layout");
+    __samples.resize(__samples.frameOffsets.back());
+    
+    auto mapped = __mapping.data() != nullptr;
+    auto frameCount = (int32_t)positions.size();
+    const int32_t BLOCK_SIZE = 256;
+    WorkStealingPool<int32_t> pool(mapped ? __concurrency : 1);
+    for (auto i = 0; i < frameCount; i += BLOCK_SIZE) { pool.push(i / BLOCK_SIZE, i); }
+    
+    std::vector<std::vector<StackSample>> buffers(pool.threadCount());
+    pool.run([&](int32_t worker, int32_t &task)
+             {
+                 PerfScope scope("decode_block");
+                 auto &buffer = buffers[worker];
+                 for (auto i = task; i < std::min(task + BLOCK_SIZE, frameCount); i++)
+                 {
+                     auto offset = __samples.frameOffsets[i];
+                     auto count = __samples.frameOffsets[i + 1] - offset;
+                     buffer.resize(count);
+                     if (mapped)
+                     {
+                         memcpy(buffer.data(), __mapping.data() + positions[i], count * sizeof(StackSample));
+                     }
+                     else
+                     {
+                         __fs.seek(positions[i], seekdir_t::beg);
+                         __fs.readArray(buffer.data(), count);
+                     }
+                     __samples.write(offset, buffer.data(), count);
+                 }
+             });
+    __sampler.end();
+    
+    __sampler.begin("index");
+    __samples.buildFunctionIndex((int32_t)__strings.size(), __concurrency);
+    __sampler.end();
     
     __lowerFrameIndex = __frames[0].index;
     __upperFrameIndex = __lowerFrameIndex + __frames.size();
@@ -95,6 +272,147 @@ void RecordCrawler::crawl()
     __sampler.end();
 }
 
+void RecordCrawler::readFrameHeader(RenderFrame &frame)
+{
+    frame.offset = (int32_t)__fs.tell();
+    frame.index = __fs.readUInt32();
+    frame.time = __fs.readFloat();
+    frame.fps = __fs.readFloat();
+    
+    auto extra = __fs.readUInt16();
+    if (extra > 0)
+    {
+        frame.hasMemoryInfo = true;
+        auto pos = __fs.tell();
+        frame.usedHeap = __fs.readUInt64();
+        frame.usedMonoHeap = __fs.readUInt64();
+        frame.reservedMonoHeap = __fs.readUInt64();
+        frame.totalAllocatedMemory = __fs.readUInt64();
+        frame.totalReservedMemory = __fs.readUInt64();
+        frame.totalUnusedReservedMemory = __fs.readUInt64();
+        assert(__fs.tell() - pos == extra);
+    }
+    else { frame.hasMemoryInfo = false; }
+    
+    for (auto iter = __metadatas.begin(); iter != __metadatas.end(); iter++)
+    {
+        auto size = iter->second.size();
+        assert(iter->first == __fs.readUInt8());
+        AreaStatistics statistics;
+        statistics.type = (ProfilerArea)iter->first;
+        
+        for (auto i = 0; i < size; i++)
+        {
+            statistics.properties.push_back(__fs.readFloat());
+        }
+        
+        frame.statistics.graphs.emplace_back(statistics);
+    }
+}
+
+size_t RecordCrawler::measureFrame(size_t offset, size_t limit)
+{
+    auto position = offset + 14; // index + time + fps + extra
+    if (position > limit) {return 0;}
+    __fs.seek(offset + 12, seekdir_t::beg);
+    position += __fs.readUInt16() + __statsize + 4;
+    if (position > limit) {return 0;}
+    
+    __fs.seek(position - 4, seekdir_t::beg);
+    position += __fs.readUInt32() * sizeof(StackSample) + 4;
+    if (position > limit) {return 0;}
+    
+    __fs.seek(position - 4, seekdir_t::beg);
+    position += __fs.readUInt32() * 8 + 4;
+    if (position > limit) {return 0;}
+    
+    // sentinel of a frame still being written may not be there yet
+    __fs.seek(position - 4, seekdir_t::beg);
+    if (__fs.readUInt32() != 0x12345678) {return 0;}
+    return position - offset;
+}
+
+int32_t RecordCrawler::update()
+{
+    if (!__following) {return 0;}
+    
+    auto limit = __fs.refresh();
+    __fs.seek(11, seekdir_t::beg);
+    __strOffset = __fs.readUInt32();
+    if (__strOffset > 0) {limit = std::min(limit, __strOffset);}
+    
+    // range locked by user is kept, otherwise it grows with capture
+    auto locked = __frames.size() > 0 && (__lowerFrameIndex != std::get<0>(__range) || __upperFrameIndex != std::get<1>(__range));
+    
+    int32_t count = 0;
+    size_t size;
+    std::vector<StackSample> samples;
+    while ((size = measureFrame(__followOffset, limit)) > 0)
+    {
+        __fs.seek(__followOffset, seekdir_t::beg);
+        RenderFrame &frame = __frames.add();
+        readFrameHeader(frame);
+        
+        samples.resize(__fs.readUInt32());
+        __fs.readArray(samples.data(), samples.size());
+        __samples.append(samples.data(), (int32_t)samples.size());
+        
+        auto alloc = 0;
+        for (auto iter = samples.begin(); iter != samples.end(); iter++)
+        {
+            if (iter->selfTime == iter->totalTime) {alloc += iter->gcAllocBytes;}
+        }
+        __followStats.collect(frame, alloc);
+        
+        __followOffset += size;
+        ++count;
+    }
+    
+    if (count > 0)
+    {
+        auto lower = __frames[0].index;
+        if (count == __frames.size()) {__cursor = lower;}
+        __range = std::make_tuple(lower, lower + __frames.size());
+        if (!locked)
+        {
+            __lowerFrameIndex = lower;
+            __upperFrameIndex = lower + __frames.size();
+        }
+    }
+    
+    if (__strOffset > 0 && __followOffset >= __strOffset)
+    {
+        readStrings();
+        __following = false;
+    }
+    
+    return count;
+}
+
+void RecordCrawler::follow(int32_t seconds)
+{
+    int64_t elapse = 0;
+    while (__following && (seconds <= 0 || elapse < seconds * 1000000LL))
+    {
+        if (update() > 0) {__followStats.dump();}
+        if (!__following) {break;}
+        usleep(500000);
+        elapse += 500000;
+    }
+    
+    if (!__following) {printf("capture completed\n");}
+}
+
+std::string RecordCrawler::nameOf(int32_t nameRef)
+{
+    if (nameRef >= 0 && nameRef < __strings.size()) {return __strings[nameRef];}
+    
+    // string table is written when recording stops
+    char placeholder[16];
+    snprintf(placeholder, sizeof(placeholder), "<%d>", nameRef);
+    return placeholder;
+}
+
 void RecordCrawler::lock(int32_t frameIndex, int32_t frameCount)
 {
     auto lower = std::get<0>(__range);
@@ -125,36 +443,28 @@ void RecordCrawler::lock(int32_t frameIndex, int32_t frameCount)
 
 void RecordCrawler::summarize(bool rangeEnabled)
 {
-    if (rangeEnabled)
+    auto baseIndex = std::get<0>(__range);
+    auto lower = rangeEnabled ? __lowerFrameIndex : baseIndex;
+    auto upper = rangeEnabled ? __upperFrameIndex : std::get<1>(__range);
+    
+    StreamStatistics<float> fps;
+    StreamStatistics<float> time;
+    for (auto i = lower; i < upper; i++)
     {
-        Statistics<float> fps;
-        auto baseIndex = std::get<0>(__range);
-        for (auto i = __lowerFrameIndex; i < __upperFrameIndex; i++)
-        {
-            auto &frame = __frames[i - baseIndex];
-            fps.collect(frame.fps);
-        }
-        
-        fps.summarize();
-        printf("frames=[%d, %d)=%d fps=%.1f±%.1f range=[%.1f, %.1f] reasonable=[%.1f, %.1f]\n", __lowerFrameIndex, __upperFrameIndex, __upperFrameIndex - __lowerFrameIndex, fps.mean, 3 * fps.standardDeviation, fps.minimum, fps.maximum, fps.reasonableMinimum, fps.reasonableMaximum);
+        auto &frame = __frames[i - baseIndex];
+        fps.collect(frame.fps);
+        time.collect(frame.time);
     }
-    else
+    
+    printf("frames=[%d, %d)=%d", lower, upper, upper - lower);
+    if (!rangeEnabled)
     {
-        Statistics<float> fps;
-        for (auto i = 0; i < __frames.size(); i++)
-        {
-            auto &frame = __frames[i];
-            fps.collect(frame.fps);
-        }
-        
-        fps.summarize();
-        
         auto f = (double)__startTime * 1E-6;
         auto t = (double)__stopTime * 1E-6;
-        auto lower = std::get<0>(__range);
-        auto upper = std::get<1>(__range);
-        printf("frames=[%d, %d)=%d elapse=(%.3f, %.3f)=%.3fs fps=%.1f±%.1f range=[%.1f, %.1f] reasonable=[%.1f, %.1f]\n", lower, upper, upper - lower, f, t, t - f, fps.mean, 3 * fps.standardDeviation, fps.minimum, fps.maximum, fps.reasonableMinimum, fps.reasonableMaximum);
+        printf(" elapse=(%.3f, %.3f)=%.3fs", f, t, t - f);
     }
+    printf(" fps=%.1f±%.1f range=[%.1f, %.1f]\n", fps.mean, 3 * fps.standardDeviation(), fps.minimum, fps.maximum);
+    printf("time=%.3f±%.3fms p50=%.3fms p90=%.3fms p99=%.3fms p99.9=%.3fms\n", time.mean, 3 * time.standardDeviation(), time.quantile(0.5), time.quantile(0.9), time.quantile(0.99), time.quantile(0.999));
 }
 
 void RecordCrawler::findFramesWithFPS(float fps, std::function<bool (float, float)> predicate)
@@ -170,74 +480,91 @@ void RecordCrawler::findFramesWithFPS(float fps, std::function<bool (float, floa
     }
 }
 
-void RecordCrawler::iterateSamples(std::function<void (int32_t, StackSample &)> callback, bool clearProgress)
+void RecordCrawler::iterateSamples(std::function<void (int32_t, StackSample &)> callback)
 {
-    auto &frame = __frames[__lowerFrameIndex - std::get<0>(__range)];
-    __fs.seek(frame.offset, seekdir_t::beg);
-    
-    auto frameCount = __upperFrameIndex - __lowerFrameIndex;
-    
-    int32_t iterCount = 0;
-    std::cout << " 0%" << std::flush;
-    
-    double step = 2;
-    double progress = 0.0;
-    while (__fs.tell() < __strOffset)
+    auto baseIndex = std::get<0>(__range);
+    for (auto i = __lowerFrameIndex - baseIndex; i < __upperFrameIndex - baseIndex; i++)
     {
-        auto index = __fs.readUInt32();
-        __fs.readFloat(); // time
-        __fs.readFloat(); // fps
-        
-        __fs.ignore(__fs.readUInt16() + __statsize);
-        
-        readFrameSamples([&](auto &samples, auto &relations)
-                    {
-                        for (auto i = 0; i < samples.size(); i++)
-                        {
-                            callback(index, samples[i]);
-                        }
-                    });
-        
-        ++iterCount;
-        auto percent = (double)iterCount * 100.0 / (double)frameCount;
-        if (percent - progress >= step || percent + 1E-4 >= 100)
+        auto index = __frames[i].index;
+        auto offset = __samples.frameOffsets[i];
+        for (auto n = offset; n < __samples.frameOffsets[i + 1]; n++)
         {
-            printf("\b\b\b\b█%3.0f%%", percent);
-            std::cout << std::flush;
-            progress += step;
+            StackSample sample{n - offset, __samples.nameRefs[n], __samples.callsCounts[n], __samples.gcAllocBytes[n], __samples.totalTimes[n], __samples.selfTimes[n]};
+            callback(index, sample);
         }
-        
-        if (iterCount >= frameCount) {break;}
     }
-    
-    std::cout << (clearProgress ? '\r' : '\n');
 }
 
 void RecordCrawler::statByFunction(int32_t rank)
 {
-    std::map<int32_t, int32_t> callsStat;
-    std::map<int32_t, float> timeStat;
-    std::vector<int32_t> functions;
+    struct Partial
+    {
+        std::vector<int32_t> calls;
+        std::vector<double> times;
+        std::vector<int32_t> firsts;
+        double totalTime = 0;
+    };
+    
+    auto functionCount = (int32_t)__samples.functionSamples.size();
+    auto baseIndex = std::get<0>(__range);
+    auto begin = __samples.frameOffsets[__lowerFrameIndex - baseIndex];
+    auto end = __samples.frameOffsets[__upperFrameIndex - baseIndex];
+    
+    // every worker aggregates blocks of samples into its own partial
+    const int32_t BLOCK_SIZE = 1 << 16;
+    WorkStealingPool<int32_t> pool(__concurrency);
+    for (auto n = begin; n < end; n += BLOCK_SIZE) { pool.push((n - begin) / BLOCK_SIZE, n); }
+    
+    std::vector<Partial> partials(pool.threadCount());
+    for (auto iter = partials.begin(); iter != partials.end(); iter++)
+    {
+        iter->calls.resize(functionCount);
+        iter->times.resize(functionCount);
+        iter->firsts.resize(functionCount, std::numeric_limits<int32_t>::max());
+    }
     
-    double totalTime = 0;
-    iterateSamples([&](int32_t index, StackSample &sample)
-                   {
-                       auto iter = callsStat.find(sample.nameRef);
-                       if (iter == callsStat.end())
-                       {
-                           iter = callsStat.insert(std::pair<int32_t, int32_t>(sample.nameRef, 0)).first;
-                           timeStat.insert(std::pair<int32_t, float>(sample.nameRef, 0));
-                           functions.push_back(sample.nameRef);
-                       }
-                       
-                       iter->second += sample.callsCount;
-                       timeStat.at(sample.nameRef) += sample.selfTime;
-                       totalTime += sample.selfTime;
-                   });
+    pool.run([&](int32_t worker, int32_t &task)
+             {
+                 auto &partial = partials[worker];
+                 for (auto n = task; n < std::min(task + BLOCK_SIZE, end); n++)
+                 {
+                     auto nameRef = __samples.nameRefs[n];
+                     if (nameRef < 0 || nameRef >= functionCount) {continue;}
+                     
+                     auto selfTime = __samples.selfTimes[n];
+                     partial.calls[nameRef] += __samples.callsCounts[n];
+                     partial.times[nameRef] += selfTime;
+                     partial.firsts[nameRef] = std::min(partial.firsts[nameRef], n);
+                     partial.totalTime += selfTime;
+                 }
+             });
+    
+    auto &callsStat = partials[0].calls;
+    auto &timeStat = partials[0].times;
+    auto &firsts = partials[0].firsts;
+    auto totalTime = partials[0].totalTime;
+    for (auto i = 1; i < partials.size(); i++)
+    {
+        auto &partial = partials[i];
+        for (auto n = 0; n < functionCount; n++)
+        {
+            callsStat[n] += partial.calls[n];
+            timeStat[n] += partial.times[n];
+            firsts[n] = std::min(firsts[n], partial.firsts[n]);
+        }
+        totalTime += partial.totalTime;
+    }
     
+    std::vector<int32_t> functions;
+    for (auto n = 0; n < functionCount; n++)
+    {
+        if (firsts[n] != std::numeric_limits<int32_t>::max()) {functions.push_back(n);}
+    }
+    
+    // functions of equal time are kept in order of appearance
     std::sort(functions.begin(), functions.end(), [&](auto a, auto b)
               {
-                  return timeStat.at(a) > timeStat.at(b);
+                  return timeStat[a] != timeStat[b] ? timeStat[a] > timeStat[b] : firsts[a] < firsts[b];
               });
     
     char progress[300+1];
@@ -248,7 +575,7 @@ void RecordCrawler::statByFunction(int32_t rank)
     {
         if (rank > 0 && i >= rank){break;}
         auto index = functions[i];
-        auto &name = __strings[index];
+        auto name = nameOf(index);
         width.collect((int32_t)name.size());
     }
     width.summarize();
@@ -261,10 +588,10 @@ void RecordCrawler::statByFunction(int32_t rank)
     {
         if (rank > 0 && i >= rank){break;}
         auto index = functions[i];
-        auto &name = __strings[index];
+        auto name = nameOf(index);
         
         memset(progress, 0, sizeof(progress));
-        auto time = timeStat.at(index);
+        auto time = (float)timeStat[index];
         auto percent = time * 100 / totalTime;
         auto count = std::max(1, (int32_t)std::round(percent));
         char *iter = progress;
@@ -273,58 +600,61 @@ void RecordCrawler::statByFunction(int32_t rank)
             memcpy(iter, fence, 3);
             iter += 3;
         }
-        printf("%5.2f%% %9.2fms #%-8d", percent, time, callsStat.at(index));
+        printf("%5.2f%% %9.2fms #%-8d", percent, time, callsStat[index]);
         std::cout << progress;
         printf(" %s *%d\n", name.c_str(), index);
     }
 }
 
+void RecordCrawler::iterateFunctionSamples(int32_t functionNameRef, std::function<void (int32_t, int32_t)> callback)
+{
+    if (functionNameRef < 0 || functionNameRef >= __samples.functionSamples.size()) {return;}
+    
+    auto baseIndex = std::get<0>(__range);
+    auto begin = __samples.frameOffsets[__lowerFrameIndex - baseIndex];
+    auto end = __samples.frameOffsets[__upperFrameIndex - baseIndex];
+    
+    auto &indice = __samples.functionSamples[functionNameRef];
+    for (auto iter = std::lower_bound(indice.begin(), indice.end(), begin); iter != indice.end() && *iter < end; iter++)
+    {
+        callback(__samples.frameOf(*iter), *iter);
+    }
+}
+
 void RecordCrawler::findFramesWithFunction(int32_t functionNameRef)
 {
     std::vector<int32_t> results;
-    iterateSamples([&](int32_t index, StackSample &sample)
-                   {
-                       if (sample.nameRef == functionNameRef)
-                       {
-                           results.push_back(index);
-                       }
-                   }, false);
-    auto baseIndex = std::get<0>(__range);
+    iterateFunctionSamples(functionNameRef, [&](int32_t frameIndex, int32_t sample)
+                           {
+                               results.push_back(frameIndex);
+                           });
     for (auto i = results.begin(); i != results.end(); i++)
     {
-        auto &frame = __frames[*i - baseIndex];
+        auto &frame = __frames[*i];
         printf("[FRAME] index=%d time=%.3fms fps=%.1f offset=%d\n", frame.index, frame.time, frame.fps, frame.offset);
     }
 }
 
 void RecordCrawler::inspectFunction(int32_t functionNameRef)
 {
-    std::vector<StackSample> samples;
-    std::vector<int32_t> frames;
-    
-    Statistics<float> stats;
-    iterateSamples([&](int32_t index, StackSample &sample)
-                   {
-                       if (sample.nameRef == functionNameRef)
-                       {
-                           samples.emplace_back(sample);
-                           frames.push_back(index);
-                           
-                           stats.collect(sample.totalTime);
-                       }
-                   }, true);
-    stats.summarize();
+    StreamStatistics<float> stats;
+    iterateFunctionSamples(functionNameRef, [&](int32_t frameIndex, int32_t sample)
+                           {
+                               stats.collect(__samples.totalTimes[sample]);
+                           });
     
-    auto &name = __strings[functionNameRef];
-    printf("[%s] count=%d total=%.3f mean=%.3f±%.3f \n", name.c_str(), stats.size(), stats.sum, stats.mean, stats.standardDeviation);
+    auto name = nameOf(functionNameRef);
+    printf("[%s] count=%d total=%.3f mean=%.3f±%.3f p50=%.3f p90=%.3f p99=%.3f\n", name.c_str(), (int32_t)stats.size(), stats.sum, stats.mean, stats.standardDeviation(), stats.quantile(0.5), stats.quantile(0.9), stats.quantile(0.99));
     
-    auto baseIndex = std::get<0>(__range);
-    stats.iterateUnusualMaximums([&](int32_t index, float value)
-                                 {
-                                     auto frameIndex = frames[index];
-                                     auto &frame = __frames[frameIndex - baseIndex];
-                                     printf("%7.3f [FRAME] index=%d time=%.3fms fps=%.1f offset=%d\n", value ,frame.index, frame.time, frame.fps, frame.offset);
-                                 });
+    // samples beyond 3σ are unusual
+    auto threshold = stats.mean + 3 * stats.standardDeviation();
+    iterateFunctionSamples(functionNameRef, [&](int32_t frameIndex, int32_t sample)
+                           {
+                               auto value = __samples.totalTimes[sample];
+                               if (value <= threshold) {return;}
+                               auto &frame = __frames[frameIndex];
+                               printf("%7.3f [FRAME] index=%d time=%.3fms fps=%.1f offset=%d\n", value ,frame.index, frame.time, frame.fps, frame.offset);
+                           });
 }
 
 void RecordCrawler::findFramesMatchValue(ProfilerArea area, int32_t property, float value, std::function<bool (float, float)> predicate)
@@ -358,7 +688,7 @@ void RecordCrawler::statValues(ProfilerArea area, int32_t property)
     
     auto baseIndex = std::get<0>(__range);
     
-    Statistics<float> stats;
+    StreamStatistics<float> stats;
     for (auto i = __lowerFrameIndex; i < __upperFrameIndex; i++)
     {
         auto index = i - baseIndex;
@@ -366,10 +696,8 @@ void RecordCrawler::statValues(ProfilerArea area, int32_t property)
         stats.collect(frame.statistics.graphs[area].properties[property]);
     }
     
-    stats.summarize();
-    
     printf("[%s][%s]", __names[area].c_str(), __metadatas.at(area)[property].c_str());
-    printf(" mean=%.3f±%.3f range=[%.0f, %.0f] reasonable=[%.0f, %.0f]\n", stats.mean, stats.standardDeviation, stats.minimum, stats.maximum, stats.reasonableMinimum, stats.reasonableMaximum);
+    printf(" mean=%.3f±%.3f range=[%.0f, %.0f] p50=%.3f p90=%.3f p99=%.3f p99.9=%.3f\n", stats.mean, stats.standardDeviation(), stats.minimum, stats.maximum, stats.quantile(0.5), stats.quantile(0.9), stats.quantile(0.99), stats.quantile(0.999));
 }
 
 void RecordCrawler::findFramesWithAlloc(int32_t frameOffset, int32_t frameCount)
@@ -386,61 +714,24 @@ void RecordCrawler::findFramesWithAlloc(int32_t frameOffset, int32_t frameCount)
     if (frameCount == 0) {return;}
     
     auto baseIndex = std::get<0>(__range);
-    auto frameIndex = __lowerFrameIndex + frameOffset;
-    __fs.seek(__frames[frameIndex - baseIndex].offset, seekdir_t::beg);
-    
-    int32_t iterCount = 0;
-    
-    using std::get;
-    std::vector<std::tuple<int32_t, float, float, int32_t, int32_t>> frames;
-    
-    std::cout << " 0%" << std::flush;
-    
-    double step = 2;
-    double progress = 0.0;
-    while (__fs.tell() < __strOffset)
+    auto lower = __lowerFrameIndex - baseIndex + frameOffset;
+    auto upper = std::min(lower + frameCount, __samples.frameCount());
+    for (auto i = lower; i < upper; i++)
     {
-        auto offset = __fs.tell();
-        auto index = __fs.readUInt32();
-        auto time = __fs.readFloat();
-        auto fps = __fs.readFloat();
-        
-        __fs.ignore(__fs.readUInt16() + __statsize);
-        
         auto alloc = 0;
-        readFrameSamples([&](auto &samples, auto &relations)
-                  {
-                      for (auto i = 0; i < samples.size(); i++)
-                      {
-                          StackSample &s = samples[i];
-                          if (s.selfTime == s.totalTime)
-                          {
-                              alloc += s.gcAllocBytes;
-                          }
-                      }
-                  });
-        if (alloc > 0)
+        for (auto n = __samples.frameOffsets[i]; n < __samples.frameOffsets[i + 1]; n++)
         {
-            frames.emplace_back(std::make_tuple(index, time, fps, alloc, offset));
+            if (__samples.selfTimes[n] == __samples.totalTimes[n])
+            {
+                alloc += __samples.gcAllocBytes[n];
+            }
         }
         
-        ++iterCount;
-        auto percent = (double)iterCount * 100.0 / (double)frameCount;
-        if (percent - progress >= step || percent + 1E-4 >= 100)
+        if (alloc > 0)
         {
-            printf("\b\b\b\b█%3.0f%%", percent);
-            std::cout << std::flush;
-            progress += step;
+            auto &frame = __frames[i];
+            printf("[FRAME] index=%d time=%.3fms fps=%.1f alloc=%d offset=%d\n", frame.index, frame.time, frame.fps, alloc, frame.offset);
         }
-        
-        if (iterCount >= frameCount) {break;}
-    }
-    printf("\r");
-    
-    for (auto iter = frames.begin(); iter != frames.end(); iter++)
-    {
-        auto &f = *iter;
-        printf("[FRAME] index=%d time=%.3fms fps=%.1f alloc=%d offset=%d\n", get<0>(f), get<1>(f), get<2>(f), get<3>(f), get<4>(f));
     }
 }
 
@@ -494,25 +785,20 @@ void RecordCrawler::readFrameSamples(std::function<void (std::vector<StackSample
 {
     auto elementCount = __fs.readUInt32();
     
+    static_assert(sizeof(StackSample) == 24, "StackSample should match sample record layout");
     std::vector<StackSample> samples(elementCount);
-    for (auto i = 0; i < elementCount; i++)
-    {
-        StackSample &s = samples[i];
-        s.id = __fs.readUInt32();
-        s.nameRef = __fs.readUInt32();
-        s.callsCount = __fs.readUInt32();
-        s.gcAllocBytes = __fs.readUInt32();
-        s.totalTime = __fs.readFloat();
-        s.selfTime = __fs.readFloat();
-    }
+    __fs.readArray(samples.data(), elementCount);
     
     elementCount = __fs.readUInt32();
+    std::vector<int32_t> pairs(elementCount * 2);
+    __fs.readArray(pairs.data(), pairs.size());
+    
     std::map<int32_t, std::vector<int32_t>> relations;
     std::map<int32_t, int32_t> connections;
     for (auto i = 0; i < elementCount; i++)
     {
-        auto node = __fs.readUInt32();
-        auto parent = __fs.readUInt32();
+        auto node = pairs[2 * i];
+        auto parent = pairs[2 * i + 1];
         auto match = relations.find(parent);
         if (match == relations.end())
         {
@@ -609,7 +895,7 @@ void RecordCrawler::dumpFrameStacks(int32_t entity, std::vector<StackSample> &sa
             
             closed ? memcpy(tabular, "└", 3) : memcpy(tabular, "├", 3);
             auto &s = samples[*i];
-            auto &name = __strings[s.nameRef];
+            auto name = nameOf(s.nameRef);
             printf("\e[36m%s%s \e[33mtime=%.3f%%/%.3fms \e[32mself=%.3f%%/%.3fms \e[37mcalls=%d", __indent, name.c_str(), s.totalTime * 100 / totalTime, s.totalTime, s.selfTime * 100/s.totalTime, s.selfTime, s.callsCount);
             if (s.gcAllocBytes > 0) {printf(" \e[31malloc=%d", s.gcAllocBytes);}
             printf(" \e[90m*%d\e[0m\n", s.nameRef);
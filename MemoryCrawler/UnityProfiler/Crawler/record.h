@@ -9,6 +9,7 @@
 #ifndef record_h
 #define record_h
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -78,6 +79,44 @@ struct RenderFrame
     int32_t offset;
 };
 
+// samples of all frames kept column by column, frame i owns samples [frameOffsets[i], frameOffsets[i+1])
+struct FrameSampleStore
+{
+    std::vector<int32_t> nameRefs;
+    std::vector<int32_t> callsCounts;
+    std::vector<int32_t> gcAllocBytes;
+    std::vector<float> totalTimes;
+    std::vector<float> selfTimes;
+    std::vector<int32_t> frameOffsets;
+    
+    // sample indice of every function in frame order
+    std::vector<std::vector<int32_t>> functionSamples;
+    
+    void resize(int32_t sampleCount);
+    void append(const StackSample *samples, int32_t count);
+    void write(int32_t offset, const StackSample *samples, int32_t count);
+    void clear();
+    
+    // samples are split into blocks that are counted, prefix summed and scattered in parallel
+    void buildFunctionIndex(int32_t functionCount, int32_t concurrency);
+    
+    int32_t frameCount() const { return (int32_t)frameOffsets.size() - 1; }
+    int32_t frameOf(int32_t sample) const;
+};
+
+// running aggregates of frames appended while following a capture
+struct FollowStatistics
+{
+    StreamStatistics<float> fps;
+    StreamStatistics<float> time;
+    
+    int32_t allocFrameCount = 0;
+    int64_t allocSum = 0;
+    
+    void collect(const RenderFrame &frame, int32_t alloc);
+    void dump();
+};
+
 class RecordCrawler
 {
 private:
@@ -85,6 +124,12 @@ private:
     int64_t __stopTime;
     
     FileStream __fs;
+    MappedFile __mapping;
+    int32_t __concurrency;
+    
+    bool __following;
+    size_t __followOffset;
+    FollowStatistics __followStats;
     TimeSampler<std::nano> __sampler;
     
     std::vector<std::string> __strings;
@@ -99,6 +144,7 @@ private:
     int32_t __cdepth;
     
     InstanceManager<RenderFrame> __frames;
+    FrameSampleStore __samples;
     int32_t __lowerFrameIndex;
     int32_t __upperFrameIndex;
     std::tuple<int32_t, int32_t> __range;
@@ -106,15 +152,21 @@ private:
 public:
     RecordCrawler();
     
-    void load(const char *filepath);
+    void load(const char *filepath, int32_t concurrency = 0);
+    
+    // append frames written since last update while the capture is growing, returns appended frame count
+    int32_t update();
+    void follow(int32_t seconds);
+    bool following() const { return __following; }
     
     void inspectFrame(int32_t frameIndex, int32_t depth);
     void inspectFrame(int32_t frameIndex);
     
     void list(int32_t frameOffset = -1, int32_t frameCount = 10, int32_t sorting = 0);
     
-    void iterateSamples(std::function<void(int32_t, StackSample &)> callback, bool clearProgress = true);
+    void iterateSamples(std::function<void(int32_t, StackSample &)> callback);
     void statByFunction(int32_t rank = 0);
+    void iterateFunctionSamples(int32_t functionNameRef, std::function<void(int32_t frameIndex, int32_t sample)> callback);
     
     void next(int32_t step = 1, int32_t depth = -1);
     void prev(int32_t step = 1, int32_t depth = -1);
@@ -140,6 +192,9 @@ private:
     void readStrings();
     void readMetadatas();
     void crawl();
+    void readFrameHeader(RenderFrame &frame);
+    size_t measureFrame(size_t offset, size_t limit);
+    std::string nameOf(int32_t nameRef);
     void readFrameSamples(std::function<void(std::vector<StackSample> &, std::map<int32_t, std::vector<int32_t>> &)> completion);
     void dumpFrameStacks(int32_t entity, std::vector<StackSample> &samples, std::map<int32_t, std::vector<int32_t>> &relations, const float totalTime, const int32_t depth = 0, const char *indent = "",  const int32_t __depth = 0);
 };
@@ -73,6 +73,7 @@ void processRecord(const char *filepath)
         }
         
         cout << "\e[0m" << "\e[36m";
+        crawler.update();
         
         const char *command = input.c_str();
         if (strbeg(command, "frame"))
@@ -347,6 +348,21 @@ void processRecord(const char *filepath)
                                    }
                                });
         }
+        else if (strbeg(command, "follow"))
+        {
+            readCommandOptions(command, [&](std::vector<const char *> &options)
+                               {
+                                   crawler.follow(options.size() >= 2 ? atoi(options[1]) : 0);
+                               });
+        }
+        else if (strbeg(command, "trace"))
+        {
+            char tracepath[256];
+            mkdir("__trace", 0777);
+            sprintf(tracepath, "__trace/%s", filename.c_str());
+            PerfTrace::shared().summarize();
+            if (PerfTrace::shared().save(tracepath)) {printf("%s.json %s.folded\n", tracepath, tracepath);}
+        }
         else if (strbeg(command, "quit"))
         {
             recordable = false;
@@ -370,7 +386,9 @@ void processRecord(const char *filepath)
             help("stat", "[PROFILER_AREA] [PROPERTY]", "统计性能指标", __indent);
             help("seek", "[PROFILER_AREA] [PROPERTY] [VALUE] [>|=|<]", "搜索性能指标满足条件(>大于VALUE[默认] =等于VALUE <小于VALUE)的帧", __indent);
             help("info", NULL, "性能摘要", __indent);
+            help("trace", NULL, "输出内部耗时统计, 并导出chrome://tracing文件以及火焰图folded文件", __indent);
             help("fps", "[FPS] [>|=|<]", "搜索满足条件(>大于FPS =等于FPS <小于FPS[默认])的帧", __indent);
+            help("follow", "[SECONDS]", "跟踪正在录制的采样文件 直到录制结束或超过SECONDS秒", __indent);
             help("help", NULL, "帮助", __indent);
             help("quit", NULL, "退出", __indent);
             cout << std::flush;